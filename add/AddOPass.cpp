@@ -1,55 +1,738 @@
+// AddO: Mixed Boolean-Arithmetic (MBA) obfuscation of integer operations.
+//
+// Each selected add, sub, xor, or, and, mul or icmp is replaced by an equivalent expression mixing arithmetic and
+// bitwise operators, taken from a table of identities. Within a BasicBlock the rewrites form a DAG: operands are
+// the already rewritten values, and subexpressions (e.g. x & y) are shared between rewrites and with the original
+// code instead of being recomputed. Vector operators are rewritten into the same identities on vectors.
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/RandomNumberGenerator.h"
 #include "llvm/Support/raw_ostream.h"
-#include "llvm/Transforms/Utils/BasicBlockUtils.h"
-#include <map>
+#include "ObfCompat.h"
+#include "ObfConfig.h"
+#include "ObfCost.h"
+#include "ObfFamilies.h"
+#include "ObfInstrument.h"
+#include "ObfOptions.h"
+#include "ObfPasses.h"
+#include "ObfTrace.h"
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+
+#define DEBUG_TYPE "AddO"
+
+STATISTIC(RewrittenOps, "Number of operations rewritten into MBA expressions");
+STATISTIC(SharedTerms, "Number of MBA subexpressions shared instead of recomputed");
+STATISTIC(AddedCycles, "Estimated cycles added by the MBA expressions");
+STATISTIC(CapStops, "Number of rounds stopped by the instruction cap");
 
 using namespace llvm;
 
+static cl::list<OpKind> Ops(AddOOpsOption.Name, cl::CommaSeparated,
+    cl::desc("Operators rewritten into MBA expressions (default: add)"),
+    cl::values(clEnumValN(AddOp, "add", "Addition"), clEnumValN(SubOp, "sub", "Subtraction"),
+        clEnumValN(XorOp, "xor", "Exclusive or"), clEnumValN(OrOp, "or", "Or"), clEnumValN(AndOp, "and", "And"),
+        clEnumValN(MulOp, "mul", "Multiplication"), clEnumValN(CmpOp, "cmp", "Integer comparisons")));
+
+static cl::opt<unsigned> MaxOverhead(AddOMaxOverheadOption.Name,
+    cl::desc("Maximum estimated cycles an MBA expression may add to the operation it replaces. Operations without "
+             "an identity within the bound are not rewritten"),
+    cl::value_desc("cycles"), cl::init(8), cl::Optional);
+
+static cl::opt<unsigned> Rounds(AddORoundsOption.Name,
+    cl::desc("Rounds of rewriting. Each round rewrites the operations of the MBA expressions of the previous one"),
+    cl::value_desc("rounds"), cl::init(1), cl::Optional);
+
+static cl::opt<unsigned> MaxInsts("addo-max-insts",
+    cl::desc("Maximum number of instructions created in one function, over all rounds (0 = unlimited)"),
+    cl::value_desc("instructions"), cl::init(0), cl::Optional);
+
+static cl::opt<unsigned> Budget(AddOBudgetOption.Name,
+    cl::desc("Maximum estimated dynamic instruction increase per function in percent. Operations are obfuscated "
+             "coldest first (0 = unlimited)"),
+    cl::value_desc("percent"), cl::init(0), cl::Optional);
+
+static cl::opt<bool> Instrument("addo-instrument",
+    cl::desc("Count the executed MBA expressions by BasicBlock (link with libObfInstrRuntime.a)"), cl::init(false),
+    cl::Optional);
+
 namespace
 {
+struct AddO;
+
+typedef std::pair<unsigned, std::pair<Value*, Value*> > TermKey; // Opcode and operands of a binary operation
+
+static TermKey getKey(unsigned Opcode, Value* A, Value* B)
+{
+    return std::make_pair(Opcode, std::make_pair(A, B));
+}
+
+/// An MBA identity for one operator and its cost (common/ObfFamilies.h)
+struct MBAIdentity {
+    const MBAIdentityCost& Cost;
+    Value* (AddO::*Build)(IRBuilder<>& Builder, Instruction* I);
+};
+
 struct AddO : public FunctionPass {
 
     static char ID;
 
+    std::unique_ptr<RandomNumberGenerator> RNG; // Seeded by -rng-seed, the module and the pass
+
+    DenseMap<TermKey, Value*> Terms; // Values of the current BasicBlock by operation
+
+    DenseMap<BasicBlock*, unsigned> BlockRewrites; // Operations rewritten in each BasicBlock of the current function
+
+    std::unique_ptr<ObfInstrumenter> Instr; // -addo-instrument
+
+    bool HasBMI; // The current function may use ANDN
+
+    unsigned Rewritten; // Operations of the current function rewritten so far
+    unsigned Added;     // Instructions created in the current function so far
+    unsigned Cycles;    // Estimated cycles added to the current function so far
+
+    FunctionAnalysisManager* FAM; // Cached analyses of the new pass manager, null under the legacy one
+
     AddO()
         : FunctionPass(ID)
+        , HasBMI(false)
+        , Rewritten(0)
+        , Added(0)
+        , Cycles(0)
+        , FAM(nullptr)
+    {
+    }
+
+    virtual bool doInitialization(Module& M)
+    {
+        RNG = createObfRNG(M, this);
+
+        if(Instrument) {
+            Instr.reset(new ObfInstrumenter(M, "addO"));
+        }
+
+        return false;
+    }
+
+    virtual bool doFinalization(Module& M)
     {
+        bool Instrumented = Instr && Instr->finish();
+
+        Instr.reset();
+        return Instrumented;
     }
 
     virtual bool runOnFunction(Function& F)
     {
+        if(!getObfConfig().isEnabled("addO", F)) {
+            return false;
+        }
+
+        ObfTraceScope Scope("addO", F);
+
+        std::vector<Instruction*> Worklist;
+        std::unique_ptr<ObfBudget> FBudget;
+
+        HasBMI = F.getFnAttribute("target-features").getValueAsString().find("+bmi") != StringRef::npos;
+        Rewritten = Added = Cycles = 0;
+        BlockRewrites.clear();
+
+        for(BasicBlock& BB : F) {
+            for(Instruction& I : BB) {
+                if(isEnabled(&I)) {
+                    Worklist.push_back(&I);
+                }
+            }
+        }
+
+        if(Budget > 0 && !Worklist.empty()) {
+            FBudget.reset(new ObfBudget(F, Budget, FAM));
+        }
+
+        // Each round rewrites only the operations the previous round created, never the ones it left alone
+        for(unsigned Round = 0; Round < Rounds && !Worklist.empty(); ++Round) {
+            Worklist = rewriteRound(F, Worklist, FBudget.get());
+        }
 
-        bool changed = false;
+        if(FBudget) {
+            FBudget->report("addO", F, errs());
+        }
 
-        for(Function::iterator BI = F.begin(), BE = F.end(); BI != BE; ++BI) {
-            for(BasicBlock::iterator II = BI->begin(), IE = BI->end(); II != IE; ++II) {
-                Instruction& I = *II;
-                BinaryOperator* BO = dyn_cast<BinaryOperator>(&I);
+        if(Rewritten == 0) {
+            return false;
+        }
 
-                if(!BO || BO->getOpcode() != Instruction::Add) {
-                    continue;
+        // The expressions of a BasicBlock execute together, one counter per BasicBlock counts all of them
+        if(Instr) {
+            for(BasicBlock& BB : F) {
+                if(unsigned N = BlockRewrites.lookup(&BB)) {
+                    Instr->count("rewrite", &BB, &*BB.getFirstInsertionPt(), N);
                 }
+            }
+        }
+
+        RewrittenOps += Rewritten;
+        AddedCycles += Cycles;
+
+        DEBUG_WITH_TYPE(DEBUG_TYPE, errs() << "addO: " << F.getName() << ": " << Rewritten
+                                           << " operations rewritten, " << Added << " instructions created, estimated +"
+                                           << Cycles << " cycles (+" << format("%.1f", double(Cycles) / Rewritten)
+                                           << " per operation)\n");
+
+        return true;
+    }
+
+    std::vector<Instruction*> rewriteRound(Function& F, std::vector<Instruction*>& Worklist, ObfBudget* FBudget);
+
+    bool isEnabled(Instruction* I);
+
+    const MBAIdentity* selectIdentity(Instruction* I);
+
+    unsigned getInsts(const MBAIdentity& Id, Type* Ty) const;
+
+    unsigned getOverhead(const MBAIdentity& Id, Type* Ty) const;
+
+    void addTerm(Instruction* I);
+
+    Value* getTerm(IRBuilder<>& Builder, Instruction::BinaryOps Opcode, Value* A, Value* B);
+
+    Value* getNot(IRBuilder<>& Builder, Value* A);
+
+    Value* getAndNot(IRBuilder<>& Builder, Value* A, Value* B);
+
+    Value* getDouble(IRBuilder<>& Builder, Value* A);
+
+    Value* buildAdd1(IRBuilder<>& Builder, Instruction* I);
+    Value* buildAdd2(IRBuilder<>& Builder, Instruction* I);
+    Value* buildAdd3(IRBuilder<>& Builder, Instruction* I);
+    Value* buildAdd4(IRBuilder<>& Builder, Instruction* I);
+    Value* buildSub1(IRBuilder<>& Builder, Instruction* I);
+    Value* buildSub2(IRBuilder<>& Builder, Instruction* I);
+    Value* buildSub3(IRBuilder<>& Builder, Instruction* I);
+    Value* buildSub4(IRBuilder<>& Builder, Instruction* I);
+    Value* buildXor1(IRBuilder<>& Builder, Instruction* I);
+    Value* buildXor2(IRBuilder<>& Builder, Instruction* I);
+    Value* buildXor3(IRBuilder<>& Builder, Instruction* I);
+    Value* buildOr1(IRBuilder<>& Builder, Instruction* I);
+    Value* buildOr2(IRBuilder<>& Builder, Instruction* I);
+    Value* buildOr3(IRBuilder<>& Builder, Instruction* I);
+    Value* buildAnd1(IRBuilder<>& Builder, Instruction* I);
+    Value* buildAnd2(IRBuilder<>& Builder, Instruction* I);
+    Value* buildAnd3(IRBuilder<>& Builder, Instruction* I);
+    Value* buildMul(IRBuilder<>& Builder, Instruction* I);
+    Value* buildCmpXor(IRBuilder<>& Builder, Instruction* I);
+    Value* buildCmpSub(IRBuilder<>& Builder, Instruction* I);
+    Value* buildCmpSign(IRBuilder<>& Builder, Instruction* I);
 
-                IRBuilder<> Builder(BO);
-                Value* V = Builder.CreateAdd(Builder.CreateXor(BO->getOperand(0), BO->getOperand(1)),
-                    Builder.CreateMul(
-                        ConstantInt::get(BO->getType(), 2), Builder.CreateAnd(BO->getOperand(0), BO->getOperand(1))));
+    /// Keep the coldest selected operations of 'Worklist' whose estimated cost fits 'FBudget'
+    void selectColdest(ObfBudget& FBudget, std::vector<Instruction*>& Worklist,
+        DenseMap<Instruction*, const MBAIdentity*>& Selected)
+    {
+        DenseMap<Instruction*, const MBAIdentity*> Kept;
+
+        std::stable_sort(Worklist.begin(), Worklist.end(), [&FBudget](Instruction* A, Instruction* B) {
+            return FBudget.getFrequency(A->getParent()) < FBudget.getFrequency(B->getParent());
+        });
 
-                ReplaceInstWithValue(BI->getInstList(), II, V);
+        for(Instruction* I : Worklist) {
+            auto It = Selected.find(I);
+
+            if(It == Selected.end()) {
+                continue;
+            }
 
-                changed = true;
+            if(FBudget.spend(I->getParent(), getInsts(*It->second, I->getOperand(0)->getType()) - 1)) {
+                Kept.insert(*It);
             }
         }
 
-        return changed;
+        Selected.swap(Kept);
     }
 };
 }
 
 char AddO::ID = 0;
-static RegisterPass<AddO> X("addO", "Obfuscation of add instructions", false, false);
+static RegisterPass<AddO> X("addO", "MBA obfuscation of integer operations", false, false);
+
+// In the order of MBAIdentityCosts
+static const MBAIdentity Identities[] = {
+    { MBAIdentityCosts[0],  &AddO::buildAdd1 },    // (x ^ y) + 2*(x & y)
+    { MBAIdentityCosts[1],  &AddO::buildAdd2 },    // (x | y) + (x & y)
+    { MBAIdentityCosts[2],  &AddO::buildAdd3 },    // 2*(x | y) - (x ^ y)
+    { MBAIdentityCosts[3],  &AddO::buildAdd4 },    // x - ~y - 1
+    { MBAIdentityCosts[4],  &AddO::buildSub1 },    // (x ^ -y) + 2*(x & -y)
+    { MBAIdentityCosts[5],  &AddO::buildSub2 },    // x + ~y + 1
+    { MBAIdentityCosts[6],  &AddO::buildSub3 },    // (x & ~y) - (y & ~x)
+    { MBAIdentityCosts[7],  &AddO::buildSub4 },    // 2*(x & ~y) - (x ^ y)
+    { MBAIdentityCosts[8],  &AddO::buildXor1 },    // (x | y) - (x & y)
+    { MBAIdentityCosts[9],  &AddO::buildXor2 },    // (x & ~y) | (y & ~x)
+    { MBAIdentityCosts[10], &AddO::buildXor3 },    // x + y - 2*(x & y)
+    { MBAIdentityCosts[11], &AddO::buildOr1 },     // (x ^ y) + (x & y)
+    { MBAIdentityCosts[12], &AddO::buildOr2 },     // (x & ~y) + y
+    { MBAIdentityCosts[13], &AddO::buildOr3 },     // x + y - (x & y)
+    { MBAIdentityCosts[14], &AddO::buildAnd1 },    // (x | y) - (x ^ y)
+    { MBAIdentityCosts[15], &AddO::buildAnd2 },    // x - (x & ~y)
+    { MBAIdentityCosts[16], &AddO::buildAnd3 },    // x + y - (x | y)
+    { MBAIdentityCosts[17], &AddO::buildMul },     // (x & y)*(x | y) + (x & ~y)*(y & ~x)
+    { MBAIdentityCosts[18], &AddO::buildCmpXor },  // (x ^ y) == 0
+    { MBAIdentityCosts[19], &AddO::buildCmpSub },  // (x - y) == 0
+    { MBAIdentityCosts[20], &AddO::buildCmpSign }, // x <s y: (x ^ MIN) <u (y ^ MIN)
+};
+
+static_assert(sizeof(Identities) / sizeof(Identities[0]) == NumMBAIdentities, "One builder per MBA identity");
+
+/// Rewrite the operations of 'Worklist' (in 'F') that get an identity, fit 'FBudget' (if any) and -addo-max-insts.
+/// The BasicBlocks are walked once in order, so that the rewrites see each other's values. Returns the enabled
+/// operations the rewrites created, the worklist of the next round
+std::vector<Instruction*> AddO::rewriteRound(Function& F, std::vector<Instruction*>& Worklist, ObfBudget* FBudget)
+{
+    DenseMap<Instruction*, const MBAIdentity*> Selected;
+    std::vector<Instruction*> Next;
+    std::vector<Instruction*> Dead;
+    bool Capped = false;
+
+    for(Instruction* I : Worklist) {
+        if(const MBAIdentity* Id = selectIdentity(I)) {
+            Selected[I] = Id;
+        }
+    }
+
+    if(FBudget && !Selected.empty()) {
+        selectColdest(*FBudget, Worklist, Selected);
+    }
+
+    if(Selected.empty()) {
+        return Next;
+    }
+
+    for(BasicBlock& BB : F) {
+        Terms.clear();
+
+        for(BasicBlock::iterator II = BB.begin(), IE = BB.end(); II != IE;) {
+            Instruction& I = *II++;
+            auto It = Selected.find(&I);
+
+            if(It == Selected.end()) {
+                addTerm(&I);
+                continue;
+            }
+
+            const MBAIdentity& Id = *It->second;
+
+            if(MaxInsts > 0 && Added + getInsts(Id, I.getOperand(0)->getType()) > MaxInsts) {
+                Capped = true;
+                addTerm(&I);
+                continue;
+            }
+
+            // The rewrite inserts its instructions between 'Prev' and 'I'
+            Instruction* Prev = I.getPrevNode();
+            IRBuilder<> Builder(&I);
+            Value* V = (this->*Id.Build)(Builder, &I);
+
+            for(Instruction* N = Prev ? Prev->getNextNode() : &BB.front(); N != &I; N = N->getNextNode()) {
+                Added += 1;
+
+                if(isEnabled(N)) {
+                    Next.push_back(N);
+                }
+            }
+
+            V->takeName(&I);
+            I.replaceAllUsesWith(V);
+            Dead.push_back(&I);
+            BlockRewrites[&BB] += 1;
+
+            // Later rewrites that need the value of this operation share the expression
+            if(isa<BinaryOperator>(I)) {
+                Terms[getKey(I.getOpcode(), I.getOperand(0), I.getOperand(1))] = V;
+            }
+
+            Cycles += getOverhead(Id, I.getOperand(0)->getType());
+        }
+    }
+
+    Terms.clear();
+
+    // Erased only now, so that no new instruction can take the address of one still in 'Terms'
+    for(Instruction* I : Dead) {
+        I->eraseFromParent();
+    }
+
+    Rewritten += Dead.size();
+
+    if(Capped) {
+        CapStops += 1;
+        Next.clear();
+    }
+
+    return Next;
+}
+
+/// The kind of 'I' if it is an integer operation the MBA rewrite is enabled for (-addo-ops)
+static bool getOpKind(Instruction* I, OpKind& Kind)
+{
+    if(!I->getType()->isIntOrIntVectorTy() || !I->getOperand(0)->getType()->isIntOrIntVectorTy()) {
+        return false;
+    }
+
+    switch(I->getOpcode()) {
+    case Instruction::Add:
+        Kind = AddOp;
+        return true;
+    case Instruction::Sub:
+        Kind = SubOp;
+        return true;
+    case Instruction::Xor:
+        Kind = XorOp;
+        return true;
+    case Instruction::Or:
+        Kind = OrOp;
+        return true;
+    case Instruction::And:
+        Kind = AndOp;
+        return true;
+    case Instruction::Mul:
+        Kind = MulOp;
+        return true;
+    case Instruction::ICmp:
+        Kind = CmpOp;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool AddO::isEnabled(Instruction* I)
+{
+    OpKind Kind;
+
+    if(!getOpKind(I, Kind) || ObfInstrumenter::isInstrumentation(I)) {
+        return false;
+    }
+
+    if(Ops.empty()) {
+        return Kind == AddOp;
+    }
+
+    return std::find(Ops.begin(), Ops.end(), Kind) != Ops.end();
+}
+
+/// Choose the identity 'I' is rewritten into among the ones within -addo-max-overhead, with a likelihood inversely
+/// proportional to their estimated cycles (getMBAWeight). Null if none is within the bound
+const MBAIdentity* AddO::selectIdentity(Instruction* I)
+{
+    OpKind Kind;
+    std::vector<const MBAIdentity*> Fitting;
+    std::vector<unsigned> Weights;
+    unsigned Total = 0;
+
+    getOpKind(I, Kind);
+
+    // The sign flip only applies to relational comparisons, the others only to equality
+    bool Relational = Kind == CmpOp && !cast<ICmpInst>(I)->isEquality();
+    Type* Ty = I->getOperand(0)->getType();
+
+    for(const MBAIdentity& Id : Identities) {
+        if(!isMBAApplicable(Id.Cost, Kind, Relational) || getOverhead(Id, Ty) > MaxOverhead) {
+            continue;
+        }
+
+        Fitting.push_back(&Id);
+        Weights.push_back(getMBAWeight(Id.Cost, Ty->isVectorTy(), HasBMI));
+        Total += Weights.back();
+    }
+
+    if(Fitting.empty()) {
+        return nullptr;
+    }
+
+    unsigned R = (*RNG)() % Total;
+    unsigned Idx = 0;
+
+    while(R >= Weights[Idx]) {
+        R -= Weights[Idx++];
+    }
+
+    return Fitting[Idx];
+}
+
+/// Estimated instructions of 'Id' on operands of type 'Ty'
+unsigned AddO::getInsts(const MBAIdentity& Id, Type* Ty) const
+{
+    return getMBAInsts(Id.Cost, Ty->isVectorTy(), HasBMI);
+}
+
+/// Estimated cycles 'Id' adds to the operation it replaces on operands of type 'Ty'
+unsigned AddO::getOverhead(const MBAIdentity& Id, Type* Ty) const
+{
+    return getMBAOverhead(Id.Cost, Ty->isVectorTy(), HasBMI);
+}
+
+/// Make the value of the binary operation 'I' available to the rewrites that follow it in its BasicBlock. With nsw,
+/// nuw or exact 'I' is poison where the wrapping term of an identity is defined, so it is not shared
+void AddO::addTerm(Instruction* I)
+{
+    bool PoisonFlags = (isa<OverflowingBinaryOperator>(I) && (I->hasNoSignedWrap() || I->hasNoUnsignedWrap())) ||
+                       (isa<PossiblyExactOperator>(I) && I->isExact());
+
+    if(isa<BinaryOperator>(I) && !PoisonFlags) {
+        Terms.insert(std::make_pair(getKey(I->getOpcode(), I->getOperand(0), I->getOperand(1)), I));
+    }
+}
+
+/// 'A' 'Opcode' 'B', shared with an earlier equal operation of the BasicBlock if there is one
+Value* AddO::getTerm(IRBuilder<>& Builder, Instruction::BinaryOps Opcode, Value* A, Value* B)
+{
+    auto It = Terms.find(getKey(Opcode, A, B));
+
+    if(It == Terms.end() && Instruction::isCommutative(Opcode)) {
+        It = Terms.find(getKey(Opcode, B, A));
+    }
+
+    if(It != Terms.end()) {
+        SharedTerms += 1;
+        return It->second;
+    }
+
+    Value* V = Builder.CreateBinOp(Opcode, A, B);
+    Terms[getKey(Opcode, A, B)] = V;
+
+    return V;
+}
+
+Value* AddO::getNot(IRBuilder<>& Builder, Value* A)
+{
+    return getTerm(Builder, Instruction::Xor, A, Constant::getAllOnesValue(A->getType()));
+}
+
+Value* AddO::getAndNot(IRBuilder<>& Builder, Value* A, Value* B)
+{
+    return getTerm(Builder, Instruction::And, A, getNot(Builder, B));
+}
+
+/// 2*a, as an add so that it also holds for i1 and folds into a LEA
+Value* AddO::getDouble(IRBuilder<>& Builder, Value* A)
+{
+    return getTerm(Builder, Instruction::Add, A, A);
+}
+
+Value* AddO::buildAdd1(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateAdd(getTerm(Builder, Instruction::Xor, X, Y),
+        getDouble(Builder, getTerm(Builder, Instruction::And, X, Y)));
+}
+
+Value* AddO::buildAdd2(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateAdd(getTerm(Builder, Instruction::Or, X, Y), getTerm(Builder, Instruction::And, X, Y));
+}
+
+Value* AddO::buildAdd3(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateSub(getDouble(Builder, getTerm(Builder, Instruction::Or, X, Y)),
+        getTerm(Builder, Instruction::Xor, X, Y));
+}
+
+Value* AddO::buildAdd4(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateSub(Builder.CreateSub(X, getNot(Builder, Y)), ConstantInt::get(I->getType(), 1));
+}
+
+Value* AddO::buildSub1(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* NegY = getTerm(Builder, Instruction::Sub, Constant::getNullValue(I->getType()), I->getOperand(1));
+
+    return Builder.CreateAdd(getTerm(Builder, Instruction::Xor, X, NegY),
+        getDouble(Builder, getTerm(Builder, Instruction::And, X, NegY)));
+}
+
+Value* AddO::buildSub2(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateAdd(Builder.CreateAdd(X, getNot(Builder, Y)), ConstantInt::get(I->getType(), 1));
+}
+
+Value* AddO::buildSub3(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateSub(getAndNot(Builder, X, Y), getAndNot(Builder, Y, X));
+}
+
+Value* AddO::buildSub4(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateSub(getDouble(Builder, getAndNot(Builder, X, Y)), getTerm(Builder, Instruction::Xor, X, Y));
+}
+
+Value* AddO::buildXor1(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateSub(getTerm(Builder, Instruction::Or, X, Y), getTerm(Builder, Instruction::And, X, Y));
+}
+
+Value* AddO::buildXor2(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateOr(getAndNot(Builder, X, Y), getAndNot(Builder, Y, X));
+}
+
+Value* AddO::buildXor3(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateSub(getTerm(Builder, Instruction::Add, X, Y),
+        getDouble(Builder, getTerm(Builder, Instruction::And, X, Y)));
+}
+
+Value* AddO::buildOr1(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateAdd(getTerm(Builder, Instruction::Xor, X, Y), getTerm(Builder, Instruction::And, X, Y));
+}
+
+Value* AddO::buildOr2(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateAdd(getAndNot(Builder, X, Y), Y);
+}
+
+Value* AddO::buildOr3(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateSub(getTerm(Builder, Instruction::Add, X, Y), getTerm(Builder, Instruction::And, X, Y));
+}
+
+Value* AddO::buildAnd1(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateSub(getTerm(Builder, Instruction::Or, X, Y), getTerm(Builder, Instruction::Xor, X, Y));
+}
+
+Value* AddO::buildAnd2(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateSub(X, getAndNot(Builder, X, Y));
+}
+
+Value* AddO::buildAnd3(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateSub(getTerm(Builder, Instruction::Add, X, Y), getTerm(Builder, Instruction::Or, X, Y));
+}
+
+Value* AddO::buildMul(IRBuilder<>& Builder, Instruction* I)
+{
+    Value* X = I->getOperand(0);
+    Value* Y = I->getOperand(1);
+
+    return Builder.CreateAdd(
+        Builder.CreateMul(getTerm(Builder, Instruction::And, X, Y), getTerm(Builder, Instruction::Or, X, Y)),
+        Builder.CreateMul(getAndNot(Builder, X, Y), getAndNot(Builder, Y, X)));
+}
+
+Value* AddO::buildCmpXor(IRBuilder<>& Builder, Instruction* I)
+{
+    ICmpInst* Cmp = cast<ICmpInst>(I);
+    Value* X = Cmp->getOperand(0);
+    Value* Y = Cmp->getOperand(1);
+
+    return Builder.CreateICmp(
+        Cmp->getPredicate(), getTerm(Builder, Instruction::Xor, X, Y), Constant::getNullValue(X->getType()));
+}
+
+Value* AddO::buildCmpSub(IRBuilder<>& Builder, Instruction* I)
+{
+    ICmpInst* Cmp = cast<ICmpInst>(I);
+    Value* X = Cmp->getOperand(0);
+    Value* Y = Cmp->getOperand(1);
+
+    return Builder.CreateICmp(
+        Cmp->getPredicate(), getTerm(Builder, Instruction::Sub, X, Y), Constant::getNullValue(X->getType()));
+}
+
+/// Flipping the sign bits turns a signed comparison into the unsigned one and vice versa
+Value* AddO::buildCmpSign(IRBuilder<>& Builder, Instruction* I)
+{
+    ICmpInst* Cmp = cast<ICmpInst>(I);
+    Value* X = Cmp->getOperand(0);
+    Value* Y = Cmp->getOperand(1);
+    Constant* Min = ConstantInt::get(X->getType(), APInt::getSignedMinValue(X->getType()->getScalarSizeInBits()));
+    CmpInst::Predicate Pred = Cmp->isSigned() ? Cmp->getUnsignedPredicate() : Cmp->getSignedPredicate();
+
+    return Builder.CreateICmp(
+        Pred, getTerm(Builder, Instruction::Xor, X, Min), getTerm(Builder, Instruction::Xor, Y, Min));
+}
+
+#if LLVM_VERSION_MAJOR >= 7
+PreservedAnalyses AddOPass::run(Module &M, ModuleAnalysisManager &AM) {
+    AddO Impl; // Same implementation as the legacy pass
+    Impl.FAM = &AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    // One RNG and one table of -addo-instrument counters for the module, as under the legacy FunctionPass
+    Impl.doInitialization(M);
+
+    bool Changed = false;
+    for (Function &F : M) {
+        if (!F.isDeclaration()) {
+            Changed |= Impl.runOnFunction(F);
+        }
+    }
+
+    // The counters of -addo-instrument are attached in a BasicBlock split off the 'entry' BasicBlock
+    Changed |= Impl.doFinalization(M);
+
+    return Changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
+#endif
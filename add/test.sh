@@ -0,0 +1,128 @@
+#!/bin/bash
+
+usage()
+{
+    echo "Usage ./test.sh"
+}
+
+error()
+{
+    exit -1
+}
+
+case  $1 in
+    -h | --help )
+	echo "Testing addO"
+	usage
+	exit 0
+	;;
+    *)
+esac
+
+obf=../cmake-build-debug/driver/llvm-obf # all passes are linked into the driver
+
+# Every operator in two rounds, so that the MBA expressions of the first round are rewritten again. The default
+# -addo-max-overhead only admits the cheap identities, 100 admits all of them. The identity of each operation is
+# chosen at random, the seeds vary the choice.
+
+ops="-addo-ops=add,sub,xor,or,and,mul,cmp"
+
+modes=("${ops} -addo-rounds=2"
+       "${ops} -addo-rounds=2 -addo-max-overhead=100"
+       "${ops} -addo-rounds=2 -addo-max-overhead=100 -rng-seed=1"
+       "${ops} -addo-rounds=2 -addo-max-overhead=100 -rng-seed=2"
+       "${ops} -addo-rounds=3 -addo-max-overhead=100 -rng-seed=3")
+
+# add <program> <mode>
+add()
+{
+    program=$1
+    base=$(basename "$program" ".ll")
+    object=${base}\_a.o
+    binary=${base}\_a
+
+    ${obf} ${program} -passes=addO $2 -o ${object} 2> /dev/null
+    clang ${object} -o ${binary}
+}
+
+# check <expected> <command>
+check()
+{
+    res=$($2 > /dev/null; echo $?)
+
+    if [ $res != $1 ]; then
+        echo "Fail: $2 ($res)"
+        error
+    fi
+}
+
+for mode in "${modes[@]}"; do
+
+    printf "[Testing] addO ${mode}\n"
+
+    # fac
+
+    add "../programs/ll/fac.ll" "${mode}"
+
+    check 1 "./fac_a 1"
+    check 24 "./fac_a 4"
+    check 120 "./fac_a 5"
+
+    # fib
+
+    add "../programs/ll/fib.ll" "${mode}"
+
+    check 1 "./fib_a 1"
+    check 5 "./fib_a 5"
+    check 55 "./fib_a 10"
+
+    # pow
+
+    add "../programs/ll/pow.ll" "${mode}"
+
+    check 1 "./pow_a 1 5"
+    check 128 "./pow_a 2 7"
+    check 64 "./pow_a 4 3"
+
+    # phi
+
+    add "../programs/ll/phi.ll" "${mode}"
+
+    check 3 "./phi_a"
+
+    # sum100
+
+    add "../programs/ll/sum100.ll" "${mode}"
+
+    check 30 "./sum100_a"
+
+    # twofunc
+
+    add "../programs/ll/twofunc.ll" "${mode}"
+
+    check 33 "./twofunc_a"
+
+    # vector: the operators on <4 x i32>, <8 x i16> and <16 x i8>, compared lane by lane with the same operators on
+    # scalars. Both sides are rewritten, with different identities
+
+    add "../programs/ll/vector.ll" "${mode}"
+
+    check 0 "./vector_a"
+    check 0 "./vector_a 1 2 3"
+
+    # kernels (exit status 0 when the output matches its check)
+
+    for kernel in matmul quicksort hashtable interp crc parser; do
+        add "../programs/ll/${kernel}.ll" "${mode}"
+    done
+
+    check 0 "./matmul_a 24"
+    check 0 "./quicksort_a 5000"
+    check 0 "./hashtable_a 5000"
+    check 0 "./interp_a 5000"
+    check 0 "./crc_a 5000"
+    check 0 "./parser_a 5000"
+done
+
+echo "[Success] All tests passed..."
+exit 0
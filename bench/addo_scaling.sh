@@ -0,0 +1,40 @@
+#!/bin/bash
+
+usage()
+{
+    echo "Usage ./addo_scaling.sh <opt> <libAddOPass.so> [addO options]"
+}
+
+case  $1 in
+    -h | --help )
+	echo "Time addO on synthetic functions with 10k, 100k and 1M add instructions"
+	usage
+	exit 0
+	;;
+    *)
+esac
+
+if [ "$2" == "" ]; then
+    usage
+    exit 1
+fi
+
+opt=$1 # opt executable
+pass=$2 # addO pass library
+options="${@:3}" # addO options (e.g. -addo-rounds=2 -addo-max-insts=1000000)
+dir=$(dirname "$0")
+
+printf "%10s %10s %14s\n" "adds" "seconds" "us/add"
+
+# One function of 100 basic blocks, so that a single function holds all adds
+for adds in 10000 100000 1000000; do
+    module=addo_${adds}.ll
+
+    python3 ${dir}/gen_ir.py --blocks 100 --adds $((adds / 100)) > ${module}
+
+    start=$(date +%s.%N)
+    ${opt} -load ${pass} -addO ${options} ${module} -o /dev/null 2> /dev/null
+    end=$(date +%s.%N)
+
+    python3 -c "print('%10d %10.3f %14.2f' % (${adds}, ${end} - ${start}, (${end} - ${start}) * 1e6 / ${adds}))"
+done
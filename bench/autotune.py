@@ -0,0 +1,306 @@
+#!/usr/bin/python3
+
+# Per-function settings of the obfuscation passes that maximize code metrics under a budget of measured runtime
+# overhead, written as a configuration file the passes read (common/ObfConfig.h).
+#
+# For each function of the module the search chooses whether flattenO and addO obfuscate it, and the -ipred-prob
+# (0: no ipredO) and -ipred-times of ipredO. A candidate is built with llvm-obf -obf-config, run --trials times with
+# perfstat on the benchmark input, and scored from the metrics of llvm-obf -metrics:
+#
+#   score = added cyclomatic complexity + --predicate-weight * predicates + --mba-weight * addO instructions
+#
+# where the predicates are the cyclomatic complexity added by ipredO (each invariant predicate is one conditional
+# branch) and the addO instructions those added by addO. A candidate is feasible if the upper end of the 95%
+# confidence interval of its cycles (wall time without counters) is at most --budget percent over the unobfuscated
+# build, and it exits with the status of the unobfuscated build.
+#
+# The search is a hill climb from the unobfuscated configuration. Each round mutates the best feasible
+# configuration into --candidates new ones, evaluates them and keeps the best, until --rounds rounds or --patience
+# rounds without improvement. Candidates are built on --jobs threads; their timed runs take turns unless
+# --parallel-runs. Results are cached in --cache by a hash of the module, llvm-obf, the options, the configuration
+# and the benchmark, so a repeated or interrupted search does not measure a candidate twice. The choices depend only
+# on --seed and the measurements.
+#
+# The best configuration is written to --out, with its score, overhead and llvm-obf command line as comments, and
+# every evaluated candidate to the CSV --log.
+#
+# python3 autotune.py --obf llvm-obf --perfstat perfstat --module ../programs/ll/interp.ll --args 2000000 \
+#     --budget 30 --jobs 8 --out interp.config
+
+import argparse
+import concurrent.futures
+import hashlib
+import json
+import os
+import random
+import shlex
+import subprocess
+import threading
+import time
+
+from overhead import mean_ci, revision
+
+PASSES = 'flattenO,ipredO,addO'
+
+# The 'array' encoding of flattenO calls an external permute(), so the search uses a self-contained one
+OPTIONS = '-flatten-encoding=xor -ipred-rng=xorshift'
+
+# Values of the settings of a function, in the order of the tuples of a configuration. The first are those of the
+# unobfuscated configuration
+FLATTEN = [0, 1]
+PROB = [0, 10, 25, 50, 75, 100]
+TIMES = [1, 2, 3]
+ADDO = [0, 1]
+DOMAINS = [FLATTEN, PROB, TIMES, ADDO]
+
+
+def config_text(functions, config):
+    """Configuration file lines of 'config', a (flattenO, ipred-prob, ipred-times, addO) tuple per function"""
+    lines = ['* flattenO=0 ipredO=0 addO=0']
+    for name, (flatten, prob, times, addo) in zip(functions, config):
+        lines.append('%s flattenO=%d ipredO=%d ipred-prob=%d ipred-times=%d addO=%d'
+                     % (name, flatten, 1 if prob else 0, prob, times, addo))
+    return '\n'.join(lines) + '\n'
+
+
+def mutate(rng, config):
+    """'config' with one or more settings of random functions changed"""
+    config = list(config)
+    changes = 1
+    while rng.random() < 0.3:
+        changes += 1
+
+    for _ in range(changes):
+        f = rng.randrange(len(config))
+        k = rng.randrange(len(DOMAINS))
+        settings = list(config[f])
+        settings[k] = rng.choice([v for v in DOMAINS[k] if v != settings[k]])
+        config[f] = tuple(settings)
+
+    return tuple(config)
+
+
+def read_metrics(path):
+    """Per stage of llvm-obf -metrics ("before", "after flattenO", ...), in order, the sums of the cyclomatic
+    complexity and of the instructions of the functions, and the defined functions before the passes"""
+    stages = []
+    functions = []
+    with open(path) as f:
+        for line in f:
+            m = json.loads(line)
+            stages.append((m['stage'], sum(fn['cyclomatic'] for fn in m['functions']),
+                           sum(fn['instructions'] for fn in m['functions'])))
+            if len(stages) == 1:
+                functions = [fn['name'] for fn in m['functions'] if fn['instructions'] > 0]
+
+    if not stages:
+        raise RuntimeError('%s: no metrics written by llvm-obf -metrics-json' % path)
+    return stages, functions
+
+
+def stage_delta(stages, name, index):
+    """Growth of the metric 'index' in the stage 'name'"""
+    for i in range(1, len(stages)):
+        if stages[i][0] == name:
+            return stages[i][index] - stages[i - 1][index]
+    return 0
+
+
+class Tuner:
+    def __init__(self, args, workdir):
+        self.args = args
+        self.workdir = workdir
+        self.options = shlex.split(args.options)
+        self.program_args = shlex.split(args.args)
+        self.stdin = open(args.stdin).read() if args.stdin else ''
+        self.libs = shlex.split(args.libs)
+        self.run_lock = threading.Lock()
+        self.cache_lock = threading.Lock()
+        self.cache = {}
+
+        if os.path.exists(args.cache):
+            with open(args.cache) as f:
+                self.cache = json.load(f)
+
+        with open(args.module, 'rb') as f:
+            module_hash = hashlib.sha256(f.read()).hexdigest()
+        obf = os.stat(args.obf)
+        self.identity = [module_hash, obf.st_size, obf.st_mtime_ns, args.passes, self.options, args.seed, args.cc,
+                         self.libs, self.program_args, self.stdin, args.trials, args.warmup]
+
+    def key(self, passes, text):
+        return hashlib.sha256(json.dumps(self.identity + [passes, text]).encode()).hexdigest()
+
+    def build(self, passes, text, key):
+        """Binary of the configuration 'text', and its metrics (read_metrics)"""
+        stem = os.path.join(self.workdir, key[:16])
+        with open(stem + '.config', 'w') as f:
+            f.write(text)
+        if os.path.exists(stem + '.jsonl'):
+            os.remove(stem + '.jsonl')
+
+        cmd = [self.args.obf, self.args.module, '-rng-seed=%d' % self.args.seed, '-o', stem + '.o',
+               '-obf-config=' + stem + '.config', '-metrics', '-metrics-json=' + stem + '.jsonl'] + self.options
+        if passes:
+            cmd.append('-passes=' + passes)
+
+        subprocess.run(cmd, check=True, stderr=subprocess.DEVNULL)
+        subprocess.run([self.args.cc, stem + '.o', '-o', stem] + self.libs, check=True)
+
+        return stem, read_metrics(stem + '.jsonl')
+
+    def run(self, binary):
+        """Mean and 95% confidence interval of the cycles (or wall ns), and the exit status"""
+        wall, cycles, status = [], [], None
+
+        for _ in range(self.args.warmup + self.args.trials):
+            out = subprocess.run([self.args.perfstat, binary] + self.program_args, input=self.stdin,
+                                 stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout.split()
+            wall.append(int(out[0]))
+            cycles.append(int(out[1]))
+            status = int(out[3])
+
+        n = self.args.warmup
+        mean, ci = mean_ci(cycles[n:])
+        if mean is None:
+            mean, ci = mean_ci(wall[n:])
+        return mean, ci, status
+
+    def evaluate(self, passes, text):
+        """Result of the configuration 'text', from the cache if it was measured before"""
+        key = self.key(passes, text)
+        with self.cache_lock:
+            if key in self.cache:
+                return self.cache[key]
+
+        start = time.perf_counter()
+        binary, (stages, functions) = self.build(passes, text, key)
+        compile_ms = (time.perf_counter() - start) * 1e3
+
+        if self.args.parallel_runs:
+            mean, ci, status = self.run(binary)
+        else:
+            with self.run_lock:
+                mean, ci, status = self.run(binary)
+
+        result = {
+            'key': key,
+            'cyclomatic': stages[-1][1] - stages[0][1],
+            'predicates': stage_delta(stages, 'after ipredO', 1),
+            'mba': stage_delta(stages, 'after addO', 2),
+            'cost': mean,
+            'cost_ci95': ci,
+            'status': status,
+            'compile_ms': compile_ms,
+            'functions': functions,
+        }
+        result['score'] = (result['cyclomatic'] + self.args.predicate_weight * result['predicates'] +
+                           self.args.mba_weight * result['mba'])
+
+        with self.cache_lock:
+            self.cache[key] = result
+            with open(self.args.cache + '.tmp', 'w') as f:
+                json.dump(self.cache, f)
+            os.replace(self.args.cache + '.tmp', self.args.cache)
+
+        return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Tune the per-function settings of the obfuscation passes under a '
+                                                 'runtime overhead budget')
+    parser.add_argument('--obf', required=True, help='llvm-obf executable')
+    parser.add_argument('--perfstat', required=True, help='perfstat executable')
+    parser.add_argument('--module', required=True, help='.ll or .bc module of the program')
+    parser.add_argument('--args', default='', help='arguments of the benchmark run')
+    parser.add_argument('--stdin', default='', help='file given as standard input of the benchmark run')
+    parser.add_argument('--libs', default='', help='libraries linked with the program (e.g. -lm)')
+    parser.add_argument('--cc', default='clang', help='compiler used to link the objects')
+    parser.add_argument('--passes', default=PASSES, help='pipeline of llvm-obf')
+    parser.add_argument('--options', default=OPTIONS, help='further options of llvm-obf (give as --options=...)')
+    parser.add_argument('--budget', type=float, default=20, help='maximum cycles overhead in percent')
+    parser.add_argument('--predicate-weight', type=float, default=1, help='score of an invariant predicate')
+    parser.add_argument('--mba-weight', type=float, default=0.1, help='score of an instruction added by addO')
+    parser.add_argument('--trials', type=int, default=5, help='measured runs per candidate')
+    parser.add_argument('--warmup', type=int, default=1, help='unmeasured runs per candidate')
+    parser.add_argument('--rounds', type=int, default=30, help='maximum rounds of the search')
+    parser.add_argument('--patience', type=int, default=5, help='rounds without improvement before stopping')
+    parser.add_argument('--candidates', type=int, default=8, help='candidates per round')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count(), help='candidates built concurrently')
+    parser.add_argument('--parallel-runs', action='store_true', help='also time candidates concurrently (noisier)')
+    parser.add_argument('--seed', type=int, default=42, help='seed of the search and -rng-seed of llvm-obf')
+    parser.add_argument('--cache', default='autotune_cache.json', help='results of the evaluated candidates')
+    parser.add_argument('--log', default='autotune.csv', help='CSV of the evaluated candidates')
+    parser.add_argument('--out', default='obf.config', help='configuration file of the best candidate')
+    args = parser.parse_args()
+
+    workdir = os.path.abspath('autotune_bin')
+    os.makedirs(workdir, exist_ok=True)
+    tuner = Tuner(args, workdir)
+    rng = random.Random(args.seed)
+
+    # The functions of the module (that a configuration file can name), from the build without passes
+    base = tuner.evaluate('', '')
+    functions = [name for name in base['functions'] if not any(c in name for c in ' \t#')]
+    limit = base['cost'] + base['cost'] * args.budget / 100
+
+    print('%s: %d functions, baseline %.0f +-%.0f, limit %.0f' % (args.module, len(functions), base['cost'],
+                                                                   base['cost_ci95'], limit))
+
+    best = tuple((FLATTEN[0], PROB[0], TIMES[0], ADDO[0]) for _ in functions)
+    best_result = {'score': 0, 'cost': base['cost'], 'cost_ci95': base['cost_ci95']}
+    seen = {best}
+    stale = 0
+
+    with open(args.log, 'w') as log, concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        log.write('round,key,score,cyclomatic,predicates,mba_instructions,cost,cost_ci95,overhead_pct,status,'
+                  'feasible,compile_ms\n')
+
+        for r in range(args.rounds):
+            candidates = []
+            for _ in range(100 * args.candidates):
+                if len(candidates) == args.candidates:
+                    break
+                c = mutate(rng, best)
+                if c not in seen:
+                    seen.add(c)
+                    candidates.append(c)
+
+            results = list(pool.map(lambda c: tuner.evaluate(args.passes, config_text(functions, c)), candidates))
+            improved = False
+
+            for c, res in zip(candidates, results):
+                feasible = res['status'] == base['status'] and res['cost'] + res['cost_ci95'] <= limit
+                overhead = 100.0 * (res['cost'] - base['cost']) / base['cost']
+                log.write('%d,%s,%.1f,%d,%d,%d,%.0f,%.0f,%.2f,%d,%d,%.1f\n'
+                          % (r, res['key'][:16], res['score'], res['cyclomatic'], res['predicates'], res['mba'],
+                             res['cost'], res['cost_ci95'], overhead, res['status'], feasible, res['compile_ms']))
+
+                if feasible and (res['score'], -res['cost']) > (best_result['score'], -best_result['cost']):
+                    best, best_result, improved = c, res, True
+
+            log.flush()
+            stale = 0 if improved else stale + 1
+            print('round %2d: score %8.1f, overhead %6.2f%%' % (r, best_result['score'],
+                                                                  100.0 * (best_result['cost'] - base['cost']) /
+                                                                  base['cost']))
+
+            if stale >= args.patience:
+                break
+
+    overhead = 100.0 * (best_result['cost'] - base['cost']) / base['cost']
+    command = ' '.join([os.path.basename(args.obf), args.module, '-passes=' + args.passes] + tuner.options +
+                       ['-rng-seed=%d' % args.seed, '-obf-config=' + args.out])
+
+    with open(args.out, 'w') as f:
+        f.write('# Written by autotune.py %s: score %.1f, overhead %.2f%% (budget %g%%) on %s\n'
+                % (revision(), best_result['score'], overhead, args.budget,
+                   ' '.join([os.path.basename(args.module)] + tuner.program_args)))
+        f.write('# %s\n' % command)
+        f.write(config_text(functions, best))
+
+    print('%s: score %.1f, overhead %.2f%%' % (args.out, best_result['score'], overhead))
+
+
+if __name__ == '__main__':
+    main()
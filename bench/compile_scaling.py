@@ -0,0 +1,141 @@
+#!/usr/bin/python3
+
+# Compile-time scaling of the obfuscation passes on synthetic modules of gen_ir.py.
+#
+# For each size, a module is generated and each pass is run on it alone with opt (-load <pass library>). Per size
+# and pass the CSV holds the wall time of opt, its peak resident set size and the instructions and basic blocks
+# before and after the pass. The row of the pass 'none' is opt parsing and printing the module, the cost every
+# other row includes.
+#
+# python3 compile_scaling.py --opt opt --pass flattenO=libFlattenOPass.so --pass addO=libAddOPass.so --out scaling.csv
+
+import argparse
+import os
+import re
+import signal
+import subprocess
+import sys
+import time
+
+# Name, functions and basic blocks per function; with the default shape a basic block holds 17 instructions
+SIZES = [
+    ('17k', 10, 100),
+    ('170k', 100, 100),
+    ('1.7m', 100, 1000),
+    ('3.4m', 200, 1000),
+]
+
+# Options a pass needs to do any work on a generated module
+PASS_OPTIONS = {
+    'checkerT': ['-checkfn=f0', '-checkbb=bb1'],
+    'splitWM': ['-splits=3,5,7'],
+}
+
+INSTRUCTION = re.compile(r'^  [^ ;\]]')
+TERMINATOR = re.compile(r'^  (br|switch|indirectbr|ret|unreachable|invoke|resume|callbr) ')
+
+
+def count(module):
+    """Instructions and basic blocks of the function bodies of the textual 'module'"""
+    insts, blocks = 0, 0
+    with open(module) as f:
+        for line in f:
+            if INSTRUCTION.match(line):
+                insts += 1
+            if TERMINATOR.match(line):
+                blocks += 1
+    return insts, blocks
+
+
+def run(cmd, timeout):
+    """Wall seconds, peak RSS (MiB) and exit status of 'cmd', None for the status after 'timeout' seconds"""
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+    while True:
+        pid, status, usage = os.wait4(proc.pid, os.WNOHANG)
+        if pid:
+            break
+        if time.perf_counter() - start > timeout:
+            proc.send_signal(signal.SIGKILL)
+            pid, status, usage = os.wait4(proc.pid, 0)
+            status = None
+            break
+        time.sleep(0.01)
+
+    seconds = time.perf_counter() - start
+    proc.returncode = status
+    return seconds, usage.ru_maxrss / 1024.0, status
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description='Measure the compile-time scaling of the obfuscation passes')
+    parser.add_argument('--opt', required=True, help='opt executable')
+    parser.add_argument('--pass', dest='passes', action='append', default=[], metavar='NAME=LIBRARY',
+                        help='pass and the library registering it, e.g. flattenO=libFlattenOPass.so')
+    parser.add_argument('--sizes', default='', help='comma separated sizes (default: all of %s)' %
+                        ','.join(s[0] for s in SIZES))
+    parser.add_argument('--arith', type=int, default=8, help='mixed arithmetic instructions per basic block')
+    parser.add_argument('--phis', type=int, default=2, help='PHI nodes per basic block')
+    parser.add_argument('--loop-depth', type=int, default=2, help='nested counted loops per function')
+    parser.add_argument('--seed', type=int, default=0, help='seed of gen_ir.py')
+    parser.add_argument('--timeout', type=float, default=600, help='seconds after which a pass is stopped')
+    parser.add_argument('--out', default='compile_scaling.csv', help='CSV output')
+    args = parser.parse_args()
+
+    passes = [('none', None)] + [tuple(p.split('=', 1)) for p in args.passes]
+    sizes = [s for s in SIZES if not args.sizes or s[0] in args.sizes.split(',')]
+    workdir = os.path.abspath('compile_scaling')
+    os.makedirs(workdir, exist_ok=True)
+    failed = False
+
+    print('%-6s %-10s %10s %10s %8s %10s %10s %10s' % ('size', 'pass', 'insts', 'out insts', 'growth', 'seconds',
+                                                         'us/inst', 'peak MiB'))
+
+    with open(args.out, 'w') as csv:
+        csv.write('size,functions,blocks_per_function,pass,instructions,blocks,out_instructions,out_blocks,growth,'
+                  'seconds,us_per_instruction,peak_rss_mib,status\n')
+
+        for size, functions, blocks in sizes:
+            module = os.path.join(workdir, 'gen_%s.ll' % size)
+            with open(module, 'w') as f:
+                subprocess.run([sys.executable, os.path.join(here, 'gen_ir.py'), '--functions', str(functions),
+                                '--blocks', str(blocks), '--arith', str(args.arith), '--phis', str(args.phis),
+                                '--loop-depth', str(args.loop_depth), '--seed', str(args.seed)], stdout=f, check=True)
+            insts, bbs = count(module)
+
+            for name, library in passes:
+                output = os.path.join(workdir, 'gen_%s_%s.ll' % (size, name))
+                cmd = [args.opt, module, '-S', '-o', output]
+                if library:
+                    cmd += ['-load', library, '-' + name] + PASS_OPTIONS.get(name, [])
+
+                seconds, rss, status = run(cmd, args.timeout)
+
+                if status == 0:
+                    out_insts, out_bbs = count(output)
+                    result = 'ok'
+                else:
+                    out_insts, out_bbs = 0, 0
+                    result = 'timeout' if status is None else 'failed'
+                    failed = True
+
+                if os.path.exists(output):
+                    os.remove(output)
+
+                growth = float(out_insts) / insts if out_insts else 0.0
+                csv.write('%s,%d,%d,%s,%d,%d,%d,%d,%.3f,%.3f,%.3f,%.1f,%s\n' %
+                          (size, functions, blocks, name, insts, bbs, out_insts, out_bbs, growth, seconds,
+                           seconds * 1e6 / insts, rss, result))
+                csv.flush()
+
+                print('%-6s %-10s %10d %10d %8.2f %10.3f %10.3f %10.1f%s' %
+                      (size, name, insts, out_insts, growth, seconds, seconds * 1e6 / insts, rss,
+                       '' if result == 'ok' else '  ' + result))
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+usage()
+{
+    echo "Usage ./flatten_scaling.sh <opt> <libFlattenOPass.so> [flattenO options]"
+}
+
+case  $1 in
+    -h | --help )
+	echo "Time flattenO on synthetic modules with 1k, 10k and 100k basic blocks"
+	usage
+	exit 0
+	;;
+    *)
+esac
+
+if [ "$2" == "" ]; then
+    usage
+    exit 1
+fi
+
+opt=$1 # opt executable
+pass=$2 # flattenO pass library
+options="${@:3}" # flattenO options
+dir=$(dirname "$0")
+
+printf "%10s %10s %14s\n" "blocks" "seconds" "us/block"
+
+for blocks in 1000 10000 100000; do
+    module=flatten_${blocks}.ll
+
+    python3 ${dir}/gen_ir.py --blocks ${blocks} > ${module}
+
+    start=$(date +%s.%N)
+    ${opt} -load ${pass} -flattenO ${options} ${module} -o /dev/null 2> /dev/null
+    end=$(date +%s.%N)
+
+    python3 -c "print('%10d %10.3f %14.2f' % (${blocks}, ${end} - ${start}, (${end} - ${start}) * 1e6 / ${blocks}))"
+done
@@ -0,0 +1,142 @@
+#!/usr/bin/python3
+
+# python3 gen_ir.py --blocks 1000 > module.ll
+# python3 gen_ir.py --blocks 100 --adds 10000 > kernel.ll  (1M adds in one function)
+# python3 gen_ir.py --functions 100 --blocks 1000 --arith 8 --phis 2 --loop-depth 2 > large.ll  (1.7M instructions)
+#
+# Each function keeps its state in an alloca. Its basic blocks form a chain in which each block falls through to the
+# next one or branches back a few blocks, wrapped into --loop-depth nested counted loops. --phis PHI nodes per block
+# merge values of its predecessors and --arith mixed arithmetic instructions per block combine the values of the block.
+# The defaults give the modules of the first versions of the generator, with one add per block.
+
+import argparse
+import random
+
+# Binary operators of --arith; shifts take a constant amount
+ARITH_OPS = ['add', 'sub', 'xor', 'and', 'or', 'mul', 'shl', 'lshr']
+
+# Iterations of the counted loops of --loop-depth
+LOOP_TRIPS = 8
+
+
+def gen_function(out, name, blocks, adds, arith, phis, loop_depth, rng):
+    # Draw the CFG first, in the order of the first versions, so that the defaults give the same modules
+    consts, limits, others = [], [], []
+    for k in range(blocks):
+        consts.append(rng.randint(1, 100))
+        if k < blocks - 1:
+            limits.append(rng.randint(0, 1 << 16))
+            others.append(max(0, k - rng.randint(1, 8)))
+
+    # Predecessors of the blocks with the values they pass to even and odd PHIs
+    preds = [[] for _ in range(blocks)]
+    if loop_depth:
+        preds[0].append(('loop%d' % (loop_depth - 1), '%%i%d' % (loop_depth - 1), '%%i%d' % (loop_depth - 1)))
+    else:
+        preds[0].append(('entry', '%n', '%n'))
+    for k in range(blocks - 1):
+        preds[k + 1].append(('bb%d' % k, '%%b%d' % k, '%%a%d' % k))
+        preds[others[k]].append(('bb%d' % k, '%%b%d' % k, '%%a%d' % k))
+
+    out.append('define i32 @%s(i32 %%n) {' % name)
+    out.append('entry:')
+    out.append('  %acc = alloca i32, align 4')
+    out.append('  store i32 %n, i32* %acc, align 4')
+    out.append('  br label %%%s' % ('loop0' if loop_depth else 'bb0'))
+
+    for d in range(loop_depth):
+        out.append('')
+        out.append('loop%d:' % d)
+        outer = 'loop%d' % (d - 1) if d else 'entry'
+        out.append('  %%i%d = phi i32 [ 0, %%%s ], [ %%i%d.next, %%latch%d ]' % (d, outer, d, d))
+        out.append('  br label %%%s' % ('loop%d' % (d + 1) if d + 1 < loop_depth else 'bb0'))
+
+    for k in range(blocks):
+        out.append('')
+        out.append('bb%d:' % k)
+
+        for j in range(phis):
+            incoming = ', '.join('[ %s, %%%s ]' % (values[j % 2], pred) for pred, *values in preds[k])
+            out.append('  %%p%d.%d = phi i32 %s' % (k, j, incoming))
+
+        out.append('  %%a%d = load i32, i32* %%acc, align 4' % k)
+
+        # Merge the PHIs into the value of the block
+        last = '%%a%d' % k
+        pool = [last]
+        for j in range(phis):
+            out.append('  %%q%d.%d = add i32 %s, %%p%d.%d' % (k, j, last, k, j))
+            last = '%%q%d.%d' % (k, j)
+            pool.append('%%p%d.%d' % (k, j))
+
+        # A chain of adds, each depending on the previous one, like an unrolled arithmetic kernel
+        for j in range(adds - 1):
+            out.append('  %%t%d.%d = add i32 %s, %%a%d' % (k, j, last, k))
+            last = '%%t%d.%d' % (k, j)
+
+        # Mixed arithmetic on the values of the block and constants
+        for j in range(arith):
+            op = rng.choice(ARITH_OPS)
+            if op in ('shl', 'lshr'):
+                operand = str(rng.randint(1, 31))
+            elif rng.randint(0, 3) == 0:
+                operand = str(rng.randint(1, 1 << 16))
+            else:
+                operand = rng.choice(pool)
+            out.append('  %%x%d.%d = %s i32 %s, %s' % (k, j, op, last, operand))
+            last = '%%x%d.%d' % (k, j)
+            pool.append(last)
+
+        out.append('  %%b%d = add i32 %s, %d' % (k, last, consts[k]))
+        out.append('  store i32 %%b%d, i32* %%acc, align 4' % k)
+
+        if k == blocks - 1:
+            if loop_depth:
+                out.append('  br label %%latch%d' % (loop_depth - 1))
+            else:
+                out.append('  ret i32 %%b%d' % k)
+            continue
+
+        # Fall through to the next block, or branch back a few blocks to form loops
+        out.append('  %%c%d = icmp slt i32 %%b%d, %d' % (k, k, limits[k]))
+        out.append('  br i1 %%c%d, label %%bb%d, label %%bb%d' % (k, k + 1, others[k]))
+
+    for d in reversed(range(loop_depth)):
+        out.append('')
+        out.append('latch%d:' % d)
+        out.append('  %%i%d.next = add i32 %%i%d, 1' % (d, d))
+        out.append('  %%l%d = icmp slt i32 %%i%d.next, %d' % (d, d, LOOP_TRIPS))
+        out.append('  br i1 %%l%d, label %%loop%d, label %%%s' % (d, d, 'latch%d' % (d - 1) if d else 'exit'))
+
+    if loop_depth:
+        out.append('')
+        out.append('exit:')
+        out.append('  %r = load i32, i32* %acc, align 4')
+        out.append('  ret i32 %r')
+
+    out.append('}')
+    out.append('')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate a synthetic LLVM IR module')
+    parser.add_argument('--functions', type=int, default=1, help='number of functions')
+    parser.add_argument('--blocks', type=int, default=100, help='basic blocks per function')
+    parser.add_argument('--adds', type=int, default=1, help='add instructions per basic block')
+    parser.add_argument('--arith', type=int, default=0, help='mixed arithmetic instructions per basic block')
+    parser.add_argument('--phis', type=int, default=0, help='PHI nodes per basic block')
+    parser.add_argument('--loop-depth', type=int, default=0, help='nested counted loops around the blocks')
+    parser.add_argument('--seed', type=int, default=0, help='seed of the generator')
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    out = ['; ModuleID = \'gen_ir\'', 'source_filename = "gen_ir"', '']
+
+    for f in range(args.functions):
+        gen_function(out, 'f%d' % f, args.blocks, args.adds, args.arith, args.phis, args.loop_depth, rng)
+
+    print('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,188 @@
+#!/usr/bin/python3
+
+# Runtime overhead of the obfuscation passes on the programs of programs/ll.
+#
+# Each program is built without passes (baseline) and under each configuration of passes and options with
+# llvm-obf, and run --trials times with perfstat. Per program and configuration the CSV holds the mean and the
+# 95% confidence interval of the wall time, cycles and instructions, the .text size, the compile time of
+# llvm-obf and the overheads relative to the baseline. Every binary must exit with the status of its baseline.
+#
+# python3 overhead.py --obf llvm-obf --perfstat perfstat --trials 20 --out overhead.csv
+
+import argparse
+import math
+import os
+import statistics
+import subprocess
+import sys
+import time
+
+# Program, arguments, standard input and libraries; the exit status is the result (0 for the kernels when their
+# output matches its check)
+PROGRAMS = [
+    ('sum100', [], '', []),
+    ('fac', ['10'], '', []),
+    ('fib', ['25'], '', []),
+    ('pow', ['3', '5'], '', []),
+    ('prime_test', [], '97\n7919\n65535\n0\n', ['-lm']),
+    ('twofunc', [], '', []),
+    ('matmul', ['128'], '', []),
+    ('quicksort', ['200000'], '', []),
+    ('hashtable', ['500000'], '', []),
+    ('interp', ['2000000'], '', []),
+    ('crc', ['1048576'], '', []),
+    ('parser', ['1048576'], '', []),
+]
+
+# Name, passes and options. The 'array' encoding of flattenO calls an external permute(), so only the
+# self-contained encodings are measured
+CONFIGS = [
+    ('baseline', '', []),
+    ('flatten-affine', 'flattenO', ['-flatten-encoding=affine']),
+    ('flatten-xor-threaded', 'flattenO', ['-flatten-encoding=xor', '-flatten-dispatch=threaded']),
+    ('flatten-xor-ssa', 'flattenO', ['-flatten-encoding=xor', '-flatten-ssa']),
+    ('flatten-budget40', 'flattenO', ['-flatten-encoding=xor', '-flatten-budget=40']),
+    ('ipred', 'ipredO', []),
+    ('ipred-xorshift', 'ipredO', ['-ipred-rng=xorshift']),
+    ('ipred-p60-t2', 'ipredO', ['-ipred-prob=60', '-ipred-times=2']),
+    ('ipred-budget20', 'ipredO', ['-ipred-budget=20']),
+    ('addo', 'addO', []),
+    ('addo-all-r2', 'addO', ['-addo-ops=add,sub,xor,or,and,cmp', '-addo-rounds=2']),
+    ('flatten-ipred-addo', 'flattenO,ipredO,addO', ['-flatten-encoding=xor', '-ipred-rng=xorshift']),
+]
+
+# Two-sided 95% quantiles of Student's t distribution by degrees of freedom
+T95 = {1: 12.706, 2: 4.303, 3: 3.182, 4: 2.776, 5: 2.571, 6: 2.447, 7: 2.365, 8: 2.306, 9: 2.262, 10: 2.228,
+       12: 2.179, 15: 2.131, 20: 2.086, 25: 2.060, 30: 2.042}
+
+
+def t95(df):
+    if df > 30:
+        return 1.96
+    return T95[max(k for k in T95 if k <= df)]
+
+
+def mean_ci(samples):
+    """Mean and half width of the 95% confidence interval, None for unavailable counters (-1)"""
+    if not samples or min(samples) < 0:
+        return None, None
+    if len(samples) == 1:
+        return float(samples[0]), 0.0
+    return statistics.mean(samples), t95(len(samples) - 1) * statistics.stdev(samples) / math.sqrt(len(samples))
+
+
+def text_size(binary):
+    """Bytes of the .text sections (.text, .text.unlikely, ...) of 'binary'"""
+    out = subprocess.run(['size', '-A', binary], stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout
+    return sum(int(line.split()[1]) for line in out.splitlines() if line.startswith('.text'))
+
+
+def build(args, program, libs, config, workdir):
+    name, passes, options = config
+    source = os.path.join(args.programs, program + '.ll')
+    obj = os.path.join(workdir, '%s_%s.o' % (program, name))
+    binary = os.path.join(workdir, '%s_%s' % (program, name))
+    cmd = [args.obf, source, '-rng-seed=%d' % args.seed, '-o', obj] + options
+    if passes:
+        cmd.append('-passes=' + passes)
+
+    start = time.perf_counter()
+    subprocess.run(cmd, check=True, stderr=subprocess.DEVNULL)
+    compile_ms = (time.perf_counter() - start) * 1e3
+
+    subprocess.run([args.cc, obj, '-o', binary] + libs, check=True)
+
+    return binary, compile_ms
+
+
+def run(args, binary, program_args, stdin):
+    """Samples of wall time (ms), cycles and instructions, and the exit status"""
+    wall, cycles, insts, status = [], [], [], None
+
+    for _ in range(args.warmup + args.trials):
+        out = subprocess.run([args.perfstat, binary] + program_args, input=stdin, stdout=subprocess.PIPE,
+                             universal_newlines=True, check=True).stdout.split()
+        wall.append(int(out[0]) / 1e6)
+        cycles.append(int(out[1]))
+        insts.append(int(out[2]))
+        status = int(out[3])
+
+    n = args.warmup
+    return wall[n:], cycles[n:], insts[n:], status
+
+
+def overhead(value, base):
+    if value is None or not base:
+        return ''
+    return '%.2f' % (100.0 * (value - base) / base)
+
+
+def fmt(value):
+    return '' if value is None else '%.3f' % value
+
+
+def revision():
+    try:
+        return subprocess.run(['git', 'rev-parse', '--short', 'HEAD'], stdout=subprocess.PIPE,
+                              stderr=subprocess.DEVNULL, universal_newlines=True,
+                              cwd=os.path.dirname(os.path.abspath(__file__))).stdout.strip()
+    except OSError:
+        return ''
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description='Measure the runtime overhead of the obfuscation passes')
+    parser.add_argument('--obf', required=True, help='llvm-obf executable')
+    parser.add_argument('--perfstat', required=True, help='perfstat executable')
+    parser.add_argument('--cc', default='clang', help='compiler used to link the objects')
+    parser.add_argument('--programs', default=os.path.join(here, '..', 'programs', 'll'), help='.ll directory')
+    parser.add_argument('--trials', type=int, default=10, help='measured runs per binary')
+    parser.add_argument('--warmup', type=int, default=1, help='unmeasured runs per binary')
+    parser.add_argument('--seed', type=int, default=42, help='-rng-seed of llvm-obf')
+    parser.add_argument('--configs', default='', help='comma separated configurations (default: all)')
+    parser.add_argument('--out', default='overhead.csv', help='CSV output')
+    args = parser.parse_args()
+
+    configs = [c for c in CONFIGS if not args.configs or c[0] == 'baseline' or c[0] in args.configs.split(',')]
+    workdir = os.path.abspath('overhead_bin')
+    os.makedirs(workdir, exist_ok=True)
+
+    rev = revision()
+    failed = False
+
+    with open(args.out, 'w') as csv:
+        csv.write('revision,program,config,passes,options,trials,wall_ms,wall_ms_ci95,cycles,cycles_ci95,'
+                  'instructions,instructions_ci95,text_bytes,compile_ms,wall_overhead_pct,cycles_overhead_pct,'
+                  'instructions_overhead_pct,text_overhead_pct\n')
+
+        for program, program_args, stdin, libs in PROGRAMS:
+            base = None
+
+            for config in configs:
+                binary, compile_ms = build(args, program, libs, config, workdir)
+                wall, cycles, insts, status = run(args, binary, program_args, stdin)
+                row = (mean_ci(wall), mean_ci(cycles), mean_ci(insts), text_size(binary))
+
+                if base is None:
+                    base = (row, status)
+                elif status != base[1]:
+                    print('%s %s: exit status %d, expected %d' % (program, config[0], status, base[1]),
+                          file=sys.stderr)
+                    failed = True
+
+                csv.write(','.join([rev, program, config[0], config[1].replace(',', '+'), ' '.join(config[2]),
+                                    str(args.trials), fmt(row[0][0]), fmt(row[0][1]), fmt(row[1][0]),
+                                    fmt(row[1][1]), fmt(row[2][0]), fmt(row[2][1]), str(row[3]),
+                                    '%.1f' % compile_ms, overhead(row[0][0], base[0][0][0]),
+                                    overhead(row[1][0], base[0][1][0]), overhead(row[2][0], base[0][2][0]),
+                                    overhead(row[3], base[0][3])]) + '\n')
+
+                print('%-12s %-22s %10.3f ms +-%7.3f  %8d bytes .text' % (program, config[0], row[0][0],
+                                                                          row[0][1], row[3]))
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
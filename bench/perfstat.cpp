@@ -0,0 +1,126 @@
+// perfstat: Run a command once and print its wall time, and the user-space cycles and instructions it executed.
+//
+//   perfstat ./fib_c 25
+//   123456789 98765432 87654321 25      (wall ns, cycles, instructions, exit status)
+//
+// The counters are opened with perf_event_open on the child before it execs the command and enabled on the
+// exec, so the fork and the harness are not counted. Where perf_event_open is not available (other systems,
+// kernel.perf_event_paranoid too high, no PMU in a VM) cycles and instructions are printed as -1. The output of
+// the command is discarded.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+/// Open a counter of 'Config' (PERF_COUNT_HW_*) of the process 'Pid', enabled when it calls exec. -1 on failure
+static int openCounter(pid_t Pid, uint64_t Config) {
+#ifdef __linux__
+    struct perf_event_attr Attr;
+
+    memset(&Attr, 0, sizeof(Attr));
+    Attr.size = sizeof(Attr);
+    Attr.type = PERF_TYPE_HARDWARE;
+    Attr.config = Config;
+    Attr.disabled = 1;
+    Attr.enable_on_exec = 1;
+    Attr.inherit = 1;
+    Attr.exclude_kernel = 1;
+    Attr.exclude_hv = 1;
+
+    return syscall(__NR_perf_event_open, &Attr, Pid, -1, -1, 0);
+#else
+    (void) Pid;
+    (void) Config;
+    return -1;
+#endif
+}
+
+static long long readCounter(int Fd) {
+    long long Value;
+
+    if (Fd < 0 || read(Fd, &Value, sizeof(Value)) != sizeof(Value)) {
+        return -1;
+    }
+
+    return Value;
+}
+
+int main(int argc, char **argv) {
+    int Go[2];
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <command> [args...]\n", argv[0]);
+        return 1;
+    }
+
+    if (pipe(Go) != 0) {
+        perror("pipe");
+        return 1;
+    }
+
+    pid_t Pid = fork();
+
+    if (Pid < 0) {
+        perror("fork");
+        return 1;
+    }
+
+    if (Pid == 0) {
+        char C;
+        int Null = open("/dev/null", O_WRONLY);
+
+        // Wait until the counters are attached
+        close(Go[1]);
+        if (read(Go[0], &C, 1) != 1) {
+            _exit(127);
+        }
+
+        dup2(Null, STDOUT_FILENO);
+        execvp(argv[1], argv + 1);
+        perror(argv[1]);
+        _exit(127);
+    }
+
+    close(Go[0]);
+
+    int Cycles = -1;
+    int Insts = -1;
+
+#ifdef __linux__
+    Cycles = openCounter(Pid, PERF_COUNT_HW_CPU_CYCLES);
+    Insts = openCounter(Pid, PERF_COUNT_HW_INSTRUCTIONS);
+#endif
+
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+    if (write(Go[1], "g", 1) != 1) {
+        perror("write");
+        return 1;
+    }
+
+    int Status;
+    waitpid(Pid, &Status, 0);
+
+    std::chrono::steady_clock::time_point End = std::chrono::steady_clock::now();
+
+    if (!WIFEXITED(Status)) {
+        fprintf(stderr, "%s: terminated by signal %d\n", argv[1], WTERMSIG(Status));
+        return 1;
+    }
+
+    printf("%lld %lld %lld %d\n",
+           (long long) std::chrono::duration_cast<std::chrono::nanoseconds>(End - Start).count(),
+           readCounter(Cycles), readCounter(Insts), WEXITSTATUS(Status));
+
+    return 0;
+}
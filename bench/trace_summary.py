@@ -0,0 +1,65 @@
+#!/usr/bin/python3
+
+# Functions ranked by the time the obfuscation passes spent on them, from a trace of llvm-obf -time-trace or
+# OBF_TIME_TRACE (common/ObfTrace.h).
+#
+# Per pass and function the table holds the total duration of its "obf.function" events, its share of the time of
+# the pass on the modules ("obf.module" events) and the instructions and basic blocks before and after.
+#
+# python3 trace_summary.py llvm-obf.trace.json --top 20
+
+import argparse
+import json
+import sys
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Rank functions by the compile time of the obfuscation passes')
+    parser.add_argument('trace', help='Chrome trace JSON')
+    parser.add_argument('--top', type=int, default=20, help='rows to print, 0 for all')
+    parser.add_argument('--pass', dest='only', default='', help='only events of this pass')
+    args = parser.parse_args()
+
+    with open(args.trace) as f:
+        events = json.load(f)['traceEvents']
+
+    module_time = {}
+    functions = {}
+
+    for e in events:
+        if args.only and e['name'] != args.only:
+            continue
+
+        if e.get('cat') == 'obf.module':
+            module_time[e['name']] = module_time.get(e['name'], 0) + e['dur']
+        elif e.get('cat') == 'obf.function':
+            a = e['args']
+            key = (e['name'], a['detail'])
+            row = functions.setdefault(key, [0, 0, 0, 0, 0, 0])
+            row[0] += e['dur']
+            row[1] += 1
+            row[2] += a['instructions_before']
+            row[3] += a['instructions_after']
+            row[4] += a['blocks_before']
+            row[5] += a['blocks_after']
+
+    if not functions:
+        print('%s: no function events' % args.trace, file=sys.stderr)
+        sys.exit(1)
+
+    ranked = sorted(functions.items(), key=lambda item: -item[1][0])
+    if args.top:
+        ranked = ranked[:args.top]
+
+    print('%-10s %-32s %6s %12s %7s %10s %10s %8s %8s' % ('pass', 'function', 'runs', 'ms', 'share', 'insts',
+                                                            'out insts', 'blocks', 'out bbs'))
+
+    for (name, function), (dur, runs, insts, out_insts, bbs, out_bbs) in ranked:
+        total = module_time.get(name, 0)
+        share = '%6.1f%%' % (100.0 * dur / total) if total else '%7s' % '-'
+        print('%-10s %-32s %6d %12.3f %s %10d %10d %8d %8d' % (name, function[:32], runs, dur / 1000.0, share,
+                                                               insts, out_insts, bbs, out_bbs))
+
+
+if __name__ == '__main__':
+    main()
@@ -17,7 +17,13 @@
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/CFG.h>
+#include "ObfCompat.h"
+#include "ObfInstrument.h"
+#include "ObfOptions.h"
+#include "ObfPasses.h"
+#include "ObfTrace.h"
 #include <algorithm>
+#include <random>
 
 #define DEBUG_TYPE "CheckerT"
 #define RED_ZONE 128
@@ -31,21 +37,22 @@ static int defaultCVal = 0x00;
 static int defaultSeed = 0x00;
 
 
-static cl::opt<std::string> CheckFn("checkfn",
+static cl::opt<std::string> CheckFn(CheckFnOption.Name,
                                     cl::desc("Function containing basic block to check"),
                                     cl::value_desc("Function identifier"), cl::init(defaultCheckFn), cl::Optional);
 
-static cl::opt<std::string> CheckBB("checkbb",
+static cl::opt<std::string> CheckBB(CheckBBOption.Name,
                                     cl::desc("Basic block that should be checked"),
-                                    cl::value_desc("Basic block identifier"), cl::Required);
+                                    cl::value_desc("Basic block identifier"), cl::init(defaultCheckBB),
+                                    cl::Optional);
 
 static cl::opt<std::string> CheckPID("checkpid",
                                      cl::desc("Identifer prefix of inserted checker"),
                                      cl::value_desc("Checker identifier prefix"), cl::init(defaultCheckPID),
                                      cl::Optional);
 
-static cl::opt<int> Seed("seed",
-                         cl::desc("Seed for generating random numbers using the C library"),
+static cl::opt<int> Seed(CheckerSeedOption.Name,
+                         cl::desc("Seed for choosing the position of the additional checker"),
                          cl::value_desc("Seed for random number generation"), cl::init(defaultSeed), cl::Optional);
 
 static cl::opt<int> CVal0("cval0",
@@ -56,128 +63,160 @@ static cl::opt<int> CVal1("cval1",
                           cl::desc("Value to be filled into corrector slot for inserted checker"),
                           cl::value_desc("Corrector slot value"), cl::init(defaultCVal), cl::Optional);
 
+static cl::opt<bool> Instrument("checker-instrument",
+                                cl::desc("Count the executions of the checkers (link with libObfInstrRuntime.a)"),
+                                cl::init(false), cl::Optional);
+
 namespace {
     struct CheckerT : public ModulePass {
         static char ID;
 
-        CheckerT() : ModulePass(ID) {
-            // Both passes should insert additional checker at same position
-            srand(Seed);
-        }
+        std::minstd_rand RNG; // Not rand(): modules may be checked concurrently (llvm-obf)
+
+        CheckerT() : ModulePass(ID) {}
 
         BasicBlock *insertCheckerBefore(BasicBlock *BB, std::string &Id);
 
         bool insertCorrectorSlot(BasicBlock *BB, std::string &Id, int CVal);
 
         virtual bool runOnModule(Module &M) {
+            ObfTraceScope Scope("checkerT", M);
 
-            DEBUG(errs() << std::string(0, ' ') << "Searching for basic block \'" << CheckBB << "\' in "
-                         << (CheckFn.empty() ? "any function" : (std::string("function ") + CheckFn)) << " ("
-                         << M.getName() << ")" "\n");
+            // Optional so that the pass can be linked into llvm-obf, but required to run
+            if (CheckBB.empty()) {
+                errs() << "checkerT: no basic block to check, use -checkbb=<basic block>\n";
+                return false;
+            }
+
+            // Both passes should insert additional checker at same position
+            RNG.seed(Seed);
 
-            DEBUG(errs() << std::string(2, ' ') << "Searching functions in module \'" << M.getName() << "\'" << "\n");
+            LLVM_DEBUG(errs() << std::string(0, ' ') << "Searching for basic block \'" << CheckBB << "\' in "
+                              << (CheckFn.empty() ? "any function" : (std::string("function ") + CheckFn)) << " ("
+                              << M.getName() << ")" "\n");
+
+            LLVM_DEBUG(errs() << std::string(2, ' ') << "Searching functions in module \'" << M.getName()
+                              << "\'" << "\n");
 
             bool foundFunction = false;
 
             for (auto &F : M) {
 
-                DEBUG(errs() << std::string(4, ' ') << "Checking function \'" << F.getName() << "\'" << "\n");
+                LLVM_DEBUG(errs() << std::string(4, ' ') << "Checking function \'" << F.getName() << "\'" << "\n");
 
                 if (CheckFn.empty() || CheckFn == F.getName()) {
 
+                    ObfTraceScope FScope("checkerT", F);
+
                     if (!CheckFn.empty()) {
-                        DEBUG(errs() << std::string(4, ' ') << "Found function \'" << CheckFn << "\'" << "\n");
+                        LLVM_DEBUG(errs() << std::string(4, ' ') << "Found function \'" << CheckFn << "\'" << "\n");
                     } else {
-                        DEBUG(errs() << std::string(4, ' ') << "Function \'" << F.getName() << "\' match criteria <any>"
-                                     << "\n");
+                        LLVM_DEBUG(errs() << std::string(4, ' ') << "Function \'" << F.getName()
+                                          << "\' match criteria <any>"
+                                          << "\n");
                     }
 
                     foundFunction = true;
 
-                    DEBUG(errs() << std::string(4, ' ') << "Searching basic blocks in function \'" << F.getName()
-                                 << "\'" << "\n");
+                    LLVM_DEBUG(errs() << std::string(4, ' ') << "Searching basic blocks in function \'" << F.getName()
+                                      << "\'" << "\n");
 
                     for (auto &BB : F) {
 
-                        DEBUG(errs() << std::string(6, ' ') << "Checking basic block \'" << BB.getName() << "\'"
-                                     << "\n");
+                        LLVM_DEBUG(errs() << std::string(6, ' ') << "Checking basic block \'" << BB.getName() << "\'"
+                                          << "\n");
 
                         if (!BB.getName().compare(CheckBB)) {
 
-                            DEBUG(errs() << std::string(6, ' ') << "Found basic block \'" << BB.getName() << "\'"
-                                         << "\n");
+                            LLVM_DEBUG(errs() << std::string(6, ' ') << "Found basic block \'" << BB.getName() << "\'"
+                                              << "\n");
 
                             if (&F.getEntryBlock() == &BB) {
-                                DEBUG(errs() << std::string(8, ' ') << "Basic block \'" << CheckBB
-                                             << "\' is entry point of function."
-                                             << "\n");
-                                DEBUG(errs() << std::string(0, ' ') << "Failed to insert checker for basic block \'"
-                                             << CheckBB << "\'" << "\n");
+                                LLVM_DEBUG(errs() << std::string(8, ' ') << "Basic block \'" << CheckBB
+                                                  << "\' is entry point of function."
+                                                  << "\n");
+                                LLVM_DEBUG(errs() << std::string(0, ' ')
+                                                  << "Failed to insert checker for basic block \'"
+                                                  << CheckBB << "\'" << "\n");
                                 return false;
                             }
 
                             if (pred_empty(&BB)) {
-                                DEBUG(errs() << std::string(8, ' ') << "Basic block \'" << CheckBB
-                                             << "\' has no predecessors." << "\n");
-                                DEBUG(errs() << std::string(0, ' ') << "Failed to insert checker for basic block \'"
-                                             << CheckBB << "\'" << "\n");
+                                LLVM_DEBUG(errs() << std::string(8, ' ') << "Basic block \'" << CheckBB
+                                                  << "\' has no predecessors." << "\n");
+                                LLVM_DEBUG(errs() << std::string(0, ' ')
+                                                  << "Failed to insert checker for basic block \'"
+                                                  << CheckBB << "\'" << "\n");
                                 return false;
                             }
 
                             std::string Id0 = CheckPID + std::to_string(0);
 
                             // Insert corrector slot into basic block
-                            DEBUG(errs() << std::string(8, ' ') << "Inserting corrector slot into basic block \'"
-                                         << BB.getName() << "\'"
-                                         << "\n");
+                            LLVM_DEBUG(errs() << std::string(8, ' ') << "Inserting corrector slot into basic block \'"
+                                              << BB.getName() << "\'"
+                                              << "\n");
                             insertCorrectorSlot(&BB, Id0, CVal0);
 
                             // Insert checker before basic block that dominates all uses
-                            DEBUG(errs() << std::string(8, ' ') << "Inserting dominating checker \'" << Id0
-                                         << "\' for basic block \'"
-                                         << BB.getName() << "\'" << "\n");
+                            LLVM_DEBUG(errs() << std::string(8, ' ') << "Inserting dominating checker \'" << Id0
+                                              << "\' for basic block \'"
+                                              << BB.getName() << "\'" << "\n");
                             BasicBlock *Checker = insertCheckerBefore(&BB, Id0);
 
                             std::string Id1 = CheckPID + std::to_string(1);
 
                             // Insert corrector slot into checker
-                            DEBUG(errs() << std::string(8, ' ') << "Inserting corrector slot into checker \'" << Id0
-                                         << "\'" << "\n");
+                            LLVM_DEBUG(errs() << std::string(8, ' ') << "Inserting corrector slot into checker \'"
+                                              << Id0
+                                              << "\'" << "\n");
                             insertCorrectorSlot(Checker, Id1, CVal1);
 
                             // Insert checker at random position into CFG to check inserted checker
                             int numBasicBlocks = F.getBasicBlockList().size();
-                            int randPos = rand() % numBasicBlocks;
+                            int randPos = RNG() % numBasicBlocks;
                             randPos = randPos == 0 ? randPos + 1 : randPos; // Prevent inserting checker before 'entry'
                             Function::iterator It = F.begin();
                             std::advance(It, randPos);
                             BasicBlock *InsertBB = &*It;
-                            DEBUG(errs() << std::string(8, ' ') << "Inserted checker \'" << Id1 << "\' for checker \'"
-                                         << Id0
-                                         << "\' before basic block \'" << InsertBB->getName() << "\'" << "\n");
-                            insertCheckerBefore(InsertBB, Id1);
+                            LLVM_DEBUG(errs() << std::string(8, ' ') << "Inserted checker \'" << Id1
+                                              << "\' for checker \'"
+                                              << Id0
+                                              << "\' before basic block \'" << InsertBB->getName() << "\'" << "\n");
+                            BasicBlock *Checker1 = insertCheckerBefore(InsertBB, Id1);
+
+                            // Each checker is counted for the BasicBlock it checks. The increments are placed
+                            // before the checked bytes, which start after the first insertion point of 'Checker'
+                            if (Instrument) {
+                                ObfInstrumenter Instr(M, "checkerT");
+                                Instr.count("check", Checker->getTerminator()->getSuccessor(0),
+                                            &*Checker->getFirstInsertionPt());
+                                Instr.count("check", Checker, &*Checker1->getFirstInsertionPt());
+                                Instr.finish();
+                            }
 
-                            DEBUG(errs() << std::string(0, ' ') << "Succeeded to insert checker for basic block \'"
-                                         << CheckBB << "\'" << "\n");
+                            LLVM_DEBUG(errs() << std::string(0, ' ') << "Succeeded to insert checker for basic block \'"
+                                              << CheckBB << "\'" << "\n");
 
-                            DEBUG(F.viewCFG());
+                            LLVM_DEBUG(F.viewCFG());
 
                             return true;
                         }
                     }
                 }
 
-                DEBUG(errs() << std::string(4, ' ') << "Could not find basic block \'" << CheckBB << "\' in function \'"
-                             << F.getName() << "\'" << "\n");
+                LLVM_DEBUG(errs() << std::string(4, ' ') << "Could not find basic block \'" << CheckBB
+                                  << "\' in function \'"
+                                  << F.getName() << "\'" << "\n");
             }
 
             if (!foundFunction && !CheckFn.empty()) {
-                DEBUG(errs() << std::string(2, ' ') << "Could not find function \'" << CheckFn << "\'"
-                             << " in module \'" << M.getName() << "\'" << "\n");
+                LLVM_DEBUG(errs() << std::string(2, ' ') << "Could not find function \'" << CheckFn << "\'"
+                                  << " in module \'" << M.getName() << "\'" << "\n");
             }
 
-            DEBUG(errs() << std::string(0, ' ') << "Failed to insert checker for basic block \'" << CheckBB << "\'"
-                         << "\n");
+            LLVM_DEBUG(errs() << std::string(0, ' ') << "Failed to insert checker for basic block \'" << CheckBB << "\'"
+                              << "\n");
 
             return false;
         }
@@ -221,7 +260,7 @@ BasicBlock *CheckerT::insertCheckerBefore(BasicBlock *BB, std::string &Id) {
     BasicBlock *SplitBB = BB->splitBasicBlock(SplitInst, BB->getName()); // Contains all instructions after PHI nodes
 
     // Restore names
-    std::string Name = BB->getName();
+    std::string Name = BB->getName().str();
     BB->setName(Id);
     SplitBB->setName(Name);
 
@@ -255,3 +294,12 @@ BasicBlock *CheckerT::insertCheckerBefore(BasicBlock *BB, std::string &Id) {
 }
 
 static RegisterPass<CheckerT> X("checkerT", "Inserts checkers before basic blocks for tamper proofing", false, false);
+
+#if LLVM_VERSION_MAJOR >= 7
+PreservedAnalyses CheckerTPass::run(Module &M, ModuleAnalysisManager &) {
+    CheckerT Impl; // Same implementation as the legacy pass
+
+    // Checkers are split off the checked BasicBlocks
+    return Impl.runOnModule(M) ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
+#endif
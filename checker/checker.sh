@@ -14,6 +14,8 @@ case  $1 in
     *)
 esac
 
+obf=../cmake-build-debug/driver/llvm-obf # all passes are linked into the driver
+
 if [ "$1" == "" ]; then
     echo "Missing parameter: <program>" 
     usage
@@ -31,16 +33,14 @@ basic_block=$2 # basic block
 fn=$3 # function
 
 base=$(basename "$program" ".ll")
-checked=${base}\_c.ll
-assembly=${base}\_c.s
+object=${base}\_c.o
 binary=${base}\_c
 #checkid=`cat /proc/sys/kernel/random/uuid`
 checkpid="c$(($RANDOM % 100))"
 seed=$RANDOM
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 cval0="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\0 .cend_$checkpid\0; echo $?)"
 cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1; echo $?)"
@@ -49,9 +49,8 @@ cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1;
 echo "Corrector value for basic block: ${cval0}"
 echo "Corrector value for checker: ${cval1}"
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed} -debug
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed} -debug
+clang -no-pie ${object} -o ${binary}
 
 
 
@@ -7,7 +7,6 @@ usage()
 
 error()
 {
-    opt -view-cfg ${checked}
     exit -1
 }
 
@@ -20,6 +19,8 @@ case  $1 in
     *)
 esac
 
+obf=../cmake-build-debug/driver/llvm-obf # all passes are linked into the driver
+
 # fac
 
 fac_t1="./fac_c 1"
@@ -35,8 +36,7 @@ fac_t10="./fac_c 10"
 
 program="../programs/ll/fac.ll"
 base=$(basename "$program" ".ll")
-checked=${base}\_c.ll
-assembly=${base}\_c.s
+object=${base}\_c.o
 binary=${base}\_c
 
 # fac: if.then
@@ -48,9 +48,8 @@ fn="fac"
 checkpid="c$(($RANDOM % 100))"
 seed=$RANDOM
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 cval0="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\0 .cend_$checkpid\0; echo $?)"
 cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1; echo $?)"
@@ -58,9 +57,8 @@ cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1;
 #echo "Corrector value for basic block: ${cval0}"
 #echo "Corrector value for checker: ${cval1}"
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 res=$($fac_t1; echo $?)
 
@@ -92,9 +90,8 @@ fn="fac"
 checkpid="c$(($RANDOM % 100))"
 seed=$RANDOM
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 cval0="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\0 .cend_$checkpid\0; echo $?)"
 cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1; echo $?)"
@@ -102,9 +99,8 @@ cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1;
 #echo "Corrector value for basic block: ${cval0}"
 #echo "Corrector value for checker: ${cval1}"
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 res=$($fac_t1; echo $?)
 
@@ -137,8 +133,7 @@ pow_t5_2="./pow_c 5 2"
 
 program="../programs/ll/pow.ll"
 base=$(basename "$program" ".ll")
-checked=${base}\_c.ll
-assembly=${base}\_c.s
+object=${base}\_c.o
 binary=${base}\_c
 
 # pow: if.else
@@ -150,9 +145,8 @@ fn="power"
 checkpid="c$(($RANDOM % 100))"
 seed=$RANDOM
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 cval0="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\0 .cend_$checkpid\0; echo $?)"
 cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1; echo $?)"
@@ -160,9 +154,8 @@ cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1;
 #echo "Corrector value for basic block: ${cval0}"
 #echo "Corrector value for checker: ${cval1}"
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 res=$($pow_t1_5; echo $?)
 
@@ -194,9 +187,8 @@ fn="power"
 checkpid="c$(($RANDOM % 100))"
 seed=${seed}
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 cval0="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\0 .cend_$checkpid\0; echo $?)"
 cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1; echo $?)"
@@ -204,9 +196,8 @@ cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1;
 #echo "Corrector value for basic block: ${cval0}"
 #echo "Corrector value for checker: ${cval1}"
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 res=$($pow_t1_5; echo $?)
 
@@ -240,8 +231,7 @@ fib_t10="./fib_c 10"
 
 program="../programs/ll/fib.ll"
 base=$(basename "$program" ".ll")
-checked=${base}\_c.ll
-assembly=${base}\_c.s
+object=${base}\_c.o
 binary=${base}\_c
 
 # fib: if.else
@@ -253,9 +243,8 @@ fn="fib"
 checkpid="c$(($RANDOM % 100))"
 seed=$RANDOM
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 cval0="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\0 .cend_$checkpid\0; echo $?)"
 cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1; echo $?)"
@@ -263,9 +252,8 @@ cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1;
 #echo "Corrector value for basic block: ${cval0}"
 #echo "Corrector value for checker: ${cval1}"
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 res=$($fib_t1; echo $?)
 
@@ -297,9 +285,8 @@ fn="fib"
 checkpid="c$(($RANDOM % 100))"
 seed=${seed}
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 cval0="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\0 .cend_$checkpid\0; echo $?)"
 cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1; echo $?)"
@@ -307,9 +294,8 @@ cval1="$(objdump -d ${binary} | ./cval.py .cstart_$checkpid\1 .cend_$checkpid\1;
 #echo "Corrector value for basic block: ${cval0}"
 #echo "Corrector value for checker: ${cval1}"
 
-opt -load ../cmake-build-debug/checker/libCheckerTPass.so -checkerT -S ${program} -o ${checked} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
-llc ${checked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=checkerT -relocation-model=static -o ${object} -checkbb=${basic_block} -checkfn=${fn} -cval0=${cval0} -cval1=${cval1} -checkpid=${checkpid} -seed=${seed}
+clang -no-pie ${object} -o ${binary}
 
 res=$($fib_t1; echo $?)
 
@@ -0,0 +1,77 @@
+// Compatibility of the passes with the versions of LLVM they are built against.
+//
+// The passes are written against the API of LLVM 6. The definitions below cover what later versions renamed or
+// removed, so that the same sources build the legacy passes and the pass plugin of the new pass manager (LLVM 7 and
+// later). Terminators are plain Instructions (LLVM 8 removed TerminatorInst).
+
+#ifndef OBF_COMPAT_H
+#define OBF_COMPAT_H
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/GlobalObject.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/RandomNumberGenerator.h"
+#include "llvm/Support/Threading.h"
+
+#include <memory>
+
+// LLVM 7 renamed DEBUG to LLVM_DEBUG
+#ifndef LLVM_DEBUG
+#define LLVM_DEBUG(X) DEBUG(X)
+#endif
+
+// LLVM 9 renamed the F_* open flags to OF_*
+#if LLVM_VERSION_MAJOR >= 9
+const llvm::sys::fs::OpenFlags ObfOpenNone = llvm::sys::fs::OF_None;
+const llvm::sys::fs::OpenFlags ObfOpenText = llvm::sys::fs::OF_Text;
+const llvm::sys::fs::OpenFlags ObfOpenAppend = llvm::sys::fs::OF_Append;
+#else
+const llvm::sys::fs::OpenFlags ObfOpenNone = llvm::sys::fs::F_None;
+const llvm::sys::fs::OpenFlags ObfOpenText = llvm::sys::fs::F_Text;
+const llvm::sys::fs::OpenFlags ObfOpenAppend = llvm::sys::fs::F_Append;
+#endif
+
+/// The function 'Name' of 'M', declared with the type 'Ty' if 'M' has none (LLVM 9 returns a FunctionCallee)
+inline llvm::Constant *getOrInsertObfFunction(llvm::Module &M, llvm::StringRef Name, llvm::FunctionType *Ty) {
+#if LLVM_VERSION_MAJOR >= 9
+    return llvm::cast<llvm::Constant>(M.getOrInsertFunction(Name, Ty).getCallee());
+#else
+    return M.getOrInsertFunction(Name, Ty);
+#endif
+}
+
+/// The random number generator of the pass 'P' on 'M' (LLVM 11 seeds it by the pass name)
+inline std::unique_ptr<llvm::RandomNumberGenerator> createObfRNG(llvm::Module &M, const llvm::Pass *P) {
+#if LLVM_VERSION_MAJOR >= 11
+    return M.createRNG(P->getPassName());
+#else
+    return M.createRNG(P);
+#endif
+}
+
+/// Align 'GO' to 'Align' bytes (LLVM 10 takes a MaybeAlign)
+inline void setObfAlignment(llvm::GlobalObject &GO, unsigned Align) {
+#if LLVM_VERSION_MAJOR >= 10
+    GO.setAlignment(llvm::MaybeAlign(Align));
+#else
+    GO.setAlignment(Align);
+#endif
+}
+
+/// The argument of a ThreadPool of 'Threads' threads (LLVM 11 takes a ThreadPoolStrategy)
+#if LLVM_VERSION_MAJOR >= 11
+inline llvm::ThreadPoolStrategy getObfThreads(unsigned Threads) {
+    return llvm::hardware_concurrency(Threads);
+}
+#else
+inline unsigned getObfThreads(unsigned Threads) {
+    return Threads;
+}
+#endif
+
+#endif
@@ -0,0 +1,117 @@
+// Per-function configuration of the obfuscation passes (e.g. written by bench/autotune.py).
+//
+// A configuration file holds one line per function: its name, followed by key=value settings that override the
+// options of the passes for that function. The line of '*' applies to the functions without a line of their own,
+// and '#' starts a comment:
+//
+//   # flattenO,ipredO,addO -flatten-encoding=xor -rng-seed=42
+//   *    flattenO=0 ipredO=0 addO=0
+//   run  flattenO=1 ipredO=1 ipred-prob=60 ipred-times=2 addO=0
+//   main ipredO=1 ipred-prob=20
+//
+// flattenO=0, ipredO=0 and addO=0 leave a function alone, ipred-prob and ipred-times replace -ipred-prob and
+// -ipred-times. The file is given by llvm-obf -obf-config, or by OBF_CONFIG=<file> in the environment of any tool
+// loading the passes (opt -load). Without a file the options apply to every function.
+
+#ifndef OBF_CONFIG_H
+#define OBF_CONFIG_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+
+/// Settings of the functions, read once before the passes run
+class ObfConfig {
+    typedef std::map<std::string, int> Settings;
+
+    std::map<std::string, Settings> Functions; // By function name, "*" for the others
+
+public:
+    ObfConfig() {
+        const char *Env = getenv("OBF_CONFIG");
+
+        if (Env && *Env) {
+            load(Env);
+        }
+    }
+
+    /// Read the configuration file 'Path', replacing the settings read so far. False on failure
+    bool load(llvm::StringRef Path) {
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer> > Buffer = llvm::MemoryBuffer::getFile(Path);
+
+        if (!Buffer) {
+            llvm::errs() << Path << ": " << Buffer.getError().message() << "\n";
+            return false;
+        }
+
+        llvm::SmallVector<llvm::StringRef, 64> Lines;
+        (*Buffer)->getBuffer().split(Lines, '\n');
+        Functions.clear();
+
+        for (unsigned I = 0; I < Lines.size(); ++I) {
+            llvm::SmallVector<llvm::StringRef, 8> Fields;
+            llvm::SplitString(Lines[I].split('#').first, Fields, " \t\r");
+
+            if (Fields.empty()) {
+                continue;
+            }
+
+            Settings &S = Functions[Fields[0].str()];
+
+            for (unsigned J = 1; J < Fields.size(); ++J) {
+                std::pair<llvm::StringRef, llvm::StringRef> KeyValue = Fields[J].split('=');
+                int Value;
+
+                if (KeyValue.first.empty() || KeyValue.second.getAsInteger(10, Value)) {
+                    llvm::errs() << Path << ":" << I + 1 << ": expected key=integer, got '" << Fields[J] << "'\n";
+                    return false;
+                }
+
+                S[KeyValue.first.str()] = Value;
+            }
+        }
+
+        return true;
+    }
+
+    /// The setting 'Key' of 'F', of '*' if 'F' has none, 'Default' if neither has one
+    int get(const llvm::Function &F, llvm::StringRef Key, int Default) const {
+        std::string Names[] = {F.getName().str(), "*"};
+
+        for (const std::string &N : Names) {
+            std::map<std::string, Settings>::const_iterator It = Functions.find(N);
+
+            if (It != Functions.end()) {
+                Settings::const_iterator Value = It->second.find(Key.str());
+
+                if (Value != It->second.end()) {
+                    return Value->second;
+                }
+            }
+        }
+
+        return Default;
+    }
+
+    /// Whether the pass 'Pass' (flattenO, ipredO, addO) obfuscates 'F'
+    bool isEnabled(llvm::StringRef Pass, const llvm::Function &F) const {
+        return get(F, Pass, 1) != 0;
+    }
+};
+
+/// The configuration of the process
+inline ObfConfig &getObfConfig() {
+    static ObfConfig Config;
+    return Config;
+}
+
+#endif
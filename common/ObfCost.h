@@ -0,0 +1,130 @@
+// Runtime overhead budget of the obfuscation passes (-flatten-budget, -ipred-budget, -addo-budget).
+//
+// Costs are estimated in dynamic instructions per call of a function: the instructions a transformation adds
+// to a BasicBlock times the number of times the BasicBlock executes per call. The frequencies come from
+// BlockFrequencyInfo, so profile data (branch weights from clang -fprofile-use) is used where the module has it
+// and static estimates elsewhere. Spending the budget on the coldest BasicBlocks first keeps hot loops fast and
+// concentrates the transformations on rarely executed code. Under the new pass manager the loops and frequencies
+// are the cached results of its FunctionAnalysisManager; the legacy passes compute their own.
+
+#ifndef OBF_COST_H
+#define OBF_COST_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+/// Loops and BasicBlock frequencies of a function
+class ObfFunctionInfo {
+    std::unique_ptr<llvm::DominatorTree> OwnDT;
+    std::unique_ptr<llvm::LoopInfo> OwnLI;
+    std::unique_ptr<llvm::BranchProbabilityInfo> OwnBPI;
+    std::unique_ptr<llvm::BlockFrequencyInfo> OwnBFI;
+    llvm::LoopInfo *LI;
+    llvm::BlockFrequencyInfo *BFI;
+
+public:
+    /// The analyses of 'F' cached by 'FAM' (new pass manager), or computed here if 'FAM' is null (legacy passes)
+    ObfFunctionInfo(llvm::Function &F, llvm::FunctionAnalysisManager *FAM) {
+        if (FAM) {
+            LI = &FAM->getResult<llvm::LoopAnalysis>(F);
+            BFI = &FAM->getResult<llvm::BlockFrequencyAnalysis>(F);
+            return;
+        }
+
+        OwnDT.reset(new llvm::DominatorTree(F));
+        OwnLI.reset(new llvm::LoopInfo(*OwnDT));
+        OwnBPI.reset(new llvm::BranchProbabilityInfo(F, *OwnLI));
+        OwnBFI.reset(new llvm::BlockFrequencyInfo(F, *OwnBPI, *OwnLI));
+        LI = OwnLI.get();
+        BFI = OwnBFI.get();
+    }
+
+    llvm::LoopInfo &getLoopInfo() const {
+        return *LI;
+    }
+
+    llvm::BlockFrequencyInfo &getBFI() const {
+        return *BFI;
+    }
+};
+
+/// Budget on the estimated dynamic instruction increase of one function
+class ObfBudget {
+    llvm::DenseMap<const llvm::BasicBlock *, double> Frequency; // Executions per call
+    double Base;  // Estimated dynamic instructions per call before the transformation
+    double Limit; // Allowed increase
+    double Spent; // Estimated increase so far
+
+public:
+    /// The increase of 'F' is limited to 'Percent' of its estimated dynamic instruction count. The frequencies are
+    /// taken from 'FAM' if given, so the budget must be created before the transformation changes 'F'
+    ObfBudget(llvm::Function &F, unsigned Percent, llvm::FunctionAnalysisManager *FAM = nullptr) : Base(0), Spent(0) {
+        ObfFunctionInfo Info(F, FAM);
+        llvm::BlockFrequencyInfo &BFI = Info.getBFI();
+        double EntryFreq = BFI.getEntryFreq();
+
+        for (llvm::BasicBlock &BB : F) {
+            double Freq = BFI.getBlockFreq(&BB).getFrequency() / EntryFreq;
+            Frequency[&BB] = Freq;
+            Base += Freq * BB.size();
+        }
+
+        Limit = Base * Percent / 100;
+    }
+
+    /// Executions of 'BB' per call. BasicBlocks the budget does not know are assumed to be cold
+    double getFrequency(const llvm::BasicBlock *BB) const {
+        return Frequency.lookup(BB);
+    }
+
+    /// Set the frequency of a BasicBlock created by the transformation
+    void setFrequency(const llvm::BasicBlock *BB, double Freq) {
+        Frequency[BB] = Freq;
+    }
+
+    /// Order 'BBs' by ascending frequency, so that the budget is spent on the coldest BasicBlocks first
+    void sortColdestFirst(std::vector<llvm::BasicBlock *> &BBs) const {
+        std::stable_sort(BBs.begin(), BBs.end(), [this](llvm::BasicBlock *A, llvm::BasicBlock *B) {
+            return getFrequency(A) < getFrequency(B);
+        });
+    }
+
+    /// Spend 'Cost' instructions per execution of 'BB' if the budget allows it
+    bool spend(const llvm::BasicBlock *BB, unsigned Cost) {
+        double Increase = getFrequency(BB) * Cost;
+
+        if (Spent + Increase > Limit) {
+            return false;
+        }
+
+        Spent += Increase;
+        return true;
+    }
+
+    /// Spend 'Cost' instructions per execution of 'BB' regardless of the budget
+    void charge(const llvm::BasicBlock *BB, unsigned Cost) {
+        Spent += getFrequency(BB) * Cost;
+    }
+
+    /// Print the estimated dynamic instruction increase of 'F'
+    void report(llvm::StringRef Pass, const llvm::Function &F, llvm::raw_ostream &OS) const {
+        OS << Pass << ": " << F.getName() << ": estimated +" << llvm::format("%.1f", Spent)
+           << " dynamic instructions per call (" << llvm::format("%.1f", Base ? 100 * Spent / Base : 0.0)
+           << "% of " << llvm::format("%.1f", Base) << ", budget " << llvm::format("%.1f", Limit) << ")\n";
+    }
+};
+
+#endif // OBF_COST_H
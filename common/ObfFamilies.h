@@ -0,0 +1,129 @@
+// Families of invariant predicates (ipredO) and MBA identities (addO), with their costs.
+//
+// ipredO chooses the family of each invariant predicate and addO the identity of each operation by the costs below.
+// overheadA computes the expected cost of a predicate and of an MBA expression from the same tables and the options
+// the passes run with (-ipred-predicates, -ipred-select, -addo-max-overhead), so that the estimate follows the
+// passes. The costs are those of x86-64: a multiply takes 3 cycles, a load 5, a remainder by a constant 8 (a
+// multiply, shifts and a subtraction) and any other instruction 1.
+
+#ifndef OBF_FAMILIES_H
+#define OBF_FAMILIES_H
+
+#include "ObfOptions.h"
+
+#include <vector>
+
+/// Cost of a family of invariant predicates on the predicate state 'x'
+struct PredicateCost {
+    const char *Name;
+    unsigned Latency; // Estimated cycles from the load of 'x' to the branch (x86-64, L1 hit)
+    unsigned Insts;   // Dynamic instructions, including the load of 'x' and the branch
+};
+
+// Indexed by PredicateKind
+const PredicateCost PredicateCosts[] = {
+        // Name      Latency Insts
+        {"qr19",     27,     8},
+        {"qr11",     27,     9},
+        {"qr31",     30,     10},
+        {"parity",   11,     6},
+        {"square",   10,     5},
+        {"bitwise",  8,      6},
+        {"table",    13,     7},
+};
+
+/// The families of -ipred-predicates 'Selected'. x*x % 4 < 2 only tests bit 1 of a square, which is always zero,
+/// and x*(x+1) being even is the textbook opaque predicate: both are easily broken. They are cheap, but only used
+/// if -ipred-predicates asks for them
+inline std::vector<PredicateKind> getPredicateKinds(const std::vector<PredicateKind> &Selected) {
+    std::vector<PredicateKind> Kinds(Selected);
+
+    if (Kinds.empty()) {
+        for (unsigned K = QR19Predicate; K <= TablePredicate; ++K) {
+            if (K != ParityPredicate && K != SquarePredicate) {
+                Kinds.push_back(PredicateKind(K));
+            }
+        }
+    }
+
+    return Kinds;
+}
+
+/// Weight of the family 'K' in the choice of a predicate. -ipred-select=cost weights the families by 1/latency
+/// (1/latency^2 in BasicBlocks executed more than once per call): every family still occurs, but the expected
+/// latency approaches the one of the cheapest families
+inline unsigned getPredicateWeight(PredicateKind K, SelectKind Select, bool Hot) {
+    unsigned Latency = PredicateCosts[K].Latency;
+
+    if (Select == UniformSelect) {
+        return 1;
+    }
+
+    return 1000000 / (Hot ? Latency * Latency : Latency);
+}
+
+/// Cost of an MBA identity for one operator. A scaled add (2*a + b) is one LEA and an and-not (a & ~b) one ANDN
+/// with BMI. Vectors have no LEA, but PANDN
+struct MBAIdentityCost {
+    OpKind Op;
+    bool Relational; // Comparisons: only for relational ones, the others only for equality
+    const char *Form;
+    unsigned Insts;  // Instructions besides the ones below
+    unsigned Scaled; // Scaled adds
+    unsigned AndNot; // And-nots
+    unsigned Muls;   // Multiplies, 3 cycles each
+};
+
+// The counts of the final operation and of the negations (NOT, NEG) are included in Insts
+const MBAIdentityCost MBAIdentityCosts[] = {
+        // Op    Rel    Form                                      Insts Scaled AndNot Muls
+        { AddOp, false, "(x ^ y) + 2*(x & y)",                    2,    1,     0,     0 },
+        { AddOp, false, "(x | y) + (x & y)",                      3,    0,     0,     0 },
+        { AddOp, false, "2*(x | y) - (x ^ y)",                    4,    0,     0,     0 },
+        { AddOp, false, "x - ~y - 1",                             3,    0,     0,     0 },
+        { SubOp, false, "(x ^ -y) + 2*(x & -y)",                  3,    1,     0,     0 },
+        { SubOp, false, "x + ~y + 1",                             3,    0,     0,     0 },
+        { SubOp, false, "(x & ~y) - (y & ~x)",                    1,    0,     2,     0 },
+        { SubOp, false, "2*(x & ~y) - (x ^ y)",                   3,    0,     1,     0 },
+        { XorOp, false, "(x | y) - (x & y)",                      3,    0,     0,     0 },
+        { XorOp, false, "(x & ~y) | (y & ~x)",                    1,    0,     2,     0 },
+        { XorOp, false, "x + y - 2*(x & y)",                      4,    0,     0,     0 },
+        { OrOp,  false, "(x ^ y) + (x & y)",                      3,    0,     0,     0 },
+        { OrOp,  false, "(x & ~y) + y",                           1,    0,     1,     0 },
+        { OrOp,  false, "x + y - (x & y)",                        3,    0,     0,     0 },
+        { AndOp, false, "(x | y) - (x ^ y)",                      3,    0,     0,     0 },
+        { AndOp, false, "x - (x & ~y)",                           1,    0,     1,     0 },
+        { AndOp, false, "x + y - (x | y)",                        3,    0,     0,     0 },
+        { MulOp, false, "(x & y)*(x | y) + (x & ~y)*(y & ~x)",    3,    0,     2,     2 },
+        { CmpOp, false, "(x ^ y) == 0",                           2,    0,     0,     0 },
+        { CmpOp, false, "(x - y) == 0",                           2,    0,     0,     0 },
+        { CmpOp, true,  "x <s y: (x ^ MIN) <u (y ^ MIN)",         3,    0,     0,     0 },
+};
+
+const unsigned NumMBAIdentities = sizeof(MBAIdentityCosts) / sizeof(MBAIdentityCosts[0]);
+
+/// Whether 'Id' rewrites an operation 'Kind' ('Relational' for a relational comparison)
+inline bool isMBAApplicable(const MBAIdentityCost &Id, OpKind Kind, bool Relational) {
+    return Id.Op == Kind && (Kind != CmpOp || Id.Relational == Relational);
+}
+
+/// Estimated instructions of 'Id' on vectors or scalars, with or without BMI
+inline unsigned getMBAInsts(const MBAIdentityCost &Id, bool Vector, bool BMI) {
+    return Id.Insts + Id.Scaled * (Vector ? 2 : 1) + Id.AndNot * (Vector || BMI ? 1 : 2) + Id.Muls;
+}
+
+/// Estimated cycles 'Id' adds to the operation it replaces
+inline unsigned getMBAOverhead(const MBAIdentityCost &Id, bool Vector, bool BMI) {
+    unsigned Cycles = getMBAInsts(Id, Vector, BMI) + 2 * Id.Muls;
+    unsigned Base = Id.Op == MulOp ? 3 : 1;
+
+    return Cycles > Base ? Cycles - Base : 0;
+}
+
+/// Weight of 'Id' in the choice among the identities within -addo-max-overhead, inversely proportional to the
+/// cycles it adds
+inline unsigned getMBAWeight(const MBAIdentityCost &Id, bool Vector, bool BMI) {
+    return 1000000 / (getMBAOverhead(Id, Vector, BMI) + 1);
+}
+
+#endif // OBF_FAMILIES_H
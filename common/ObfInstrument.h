@@ -0,0 +1,250 @@
+// Instrumentation mode of the obfuscation passes (-flatten-instrument, -ipred-instrument, -addo-instrument,
+// -checker-instrument, -wm-instrument).
+//
+// Each construct a pass inserts increments a counter labeled with its kind (e.g. "dispatch") and the function,
+// BasicBlock and source location it was inserted for. The counters of a pass are a thread_local array, so an
+// increment is a plain load, add and store: no atomics and no cache line shared between threads. The first call
+// of an instrumented function in a thread attaches the array of the thread to the runtime
+// (runtime/ObfInstrRuntime.c), which merges the counts of the threads and writes them as JSON at exit. Programs
+// built with instrumented modules are linked with libObfInstrRuntime.a and -lpthread.
+
+#ifndef OBF_INSTRUMENT_H
+#define OBF_INSTRUMENT_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+
+#include "ObfCompat.h"
+
+#include <string>
+#include <vector>
+
+/// Execution counters of the constructs one pass inserts into a module
+class ObfInstrumenter {
+    /// Where a counted construct was inserted
+    struct Site {
+        std::string Kind;
+        std::string Function;
+        std::string Block;    // Name, or position in the original function ("#3")
+        std::string Location; // "file:line" of the BasicBlock, empty without debug info
+    };
+
+    llvm::Module &M;
+    std::string Pass;
+    llvm::GlobalVariable *Placeholder; // Stands for the counters until their number is known
+    std::vector<Site> Sites;           // Indexed by counter
+    llvm::SetVector<llvm::Function *> Functions; // Functions with counters, attached on entry
+    llvm::SmallPtrSet<const llvm::Function *, 16> Numbered;
+    llvm::DenseMap<const llvm::BasicBlock *, std::pair<std::string, std::string> > Labels; // Block and Location
+    llvm::StringMap<llvm::Constant *> Strings;
+
+    static void tag(llvm::Value *V) {
+        if (llvm::Instruction *I = llvm::dyn_cast<llvm::Instruction>(V)) {
+            I->setMetadata("obf.instr", llvm::MDNode::get(I->getContext(), llvm::None));
+        }
+    }
+
+    static std::string getLocation(const llvm::BasicBlock &BB) {
+        for (const llvm::Instruction &I : BB) {
+            if (const llvm::DILocation *Loc = I.getDebugLoc()) {
+                return Loc->getFilename().str() + ":" + std::to_string(Loc->getLine());
+            }
+        }
+        return "";
+    }
+
+    /// Private constant C string
+    llvm::Constant *getString(llvm::StringRef S) {
+        llvm::Constant *&Str = Strings[S];
+
+        if (!Str) {
+            llvm::Constant *Init = llvm::ConstantDataArray::getString(M.getContext(), S);
+            llvm::GlobalVariable *GV = new llvm::GlobalVariable(M, Init->getType(), true,
+                                                                llvm::GlobalValue::PrivateLinkage, Init,
+                                                                "__obf_instr.str");
+            GV->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+            Str = llvm::ConstantExpr::getBitCast(GV, llvm::Type::getInt8PtrTy(M.getContext()));
+        }
+
+        return Str;
+    }
+
+public:
+    ObfInstrumenter(llvm::Module &M, llvm::StringRef Pass) : M(M), Pass(Pass) {
+        llvm::Type *Int64Ty = llvm::Type::getInt64Ty(M.getContext());
+
+        Placeholder = new llvm::GlobalVariable(M, Int64Ty, false, llvm::GlobalValue::InternalLinkage,
+                                               llvm::ConstantInt::get(Int64Ty, 0), "__obf_instr.placeholder");
+    }
+
+    /// Whether 'I' increments a counter or attaches them, passes leave those instructions alone
+    static bool isInstrumentation(const llvm::Instruction *I) {
+        return I->getMetadata("obf.instr") != nullptr;
+    }
+
+    /// Label the BasicBlocks of 'F' before the pass changes its CFG, so that unnamed BasicBlocks are labeled by
+    /// their original position. Done on the first count in 'F' otherwise
+    void addFunction(llvm::Function &F) {
+        if (!Numbered.insert(&F).second) {
+            return;
+        }
+
+        unsigned N = 0;
+        for (llvm::BasicBlock &BB : F) {
+            Labels[&BB] = std::make_pair(BB.hasName() ? BB.getName().str() : "#" + std::to_string(N),
+                                         getLocation(BB));
+            N += 1;
+        }
+    }
+
+    /// Count 'Amount' executions of a construct of 'Kind' inserted for 'Origin', with an increment before
+    /// 'InsertBefore'
+    void count(llvm::StringRef Kind, llvm::BasicBlock *Origin, llvm::Instruction *InsertBefore,
+               unsigned Amount = 1) {
+        llvm::Type *Int64Ty = llvm::Type::getInt64Ty(M.getContext());
+        llvm::Constant *Counter = llvm::ConstantExpr::getInBoundsGetElementPtr(
+                Int64Ty, Placeholder, llvm::ConstantInt::get(Int64Ty, Sites.size()));
+
+        llvm::IRBuilder<> Builder(InsertBefore);
+        llvm::Value *Load = Builder.CreateLoad(Int64Ty, Counter, "obf.count");
+        llvm::Value *Add = Builder.CreateAdd(Load, llvm::ConstantInt::get(Int64Ty, Amount));
+        tag(Load);
+        tag(Add);
+        tag(Builder.CreateStore(Add, Counter));
+
+        addFunction(*Origin->getParent());
+
+        Site S;
+        S.Kind = Kind.str();
+        S.Function = Origin->getParent()->getName().str();
+
+        auto It = Labels.find(Origin);
+        if (It != Labels.end()) {
+            S.Block = It->second.first;
+            S.Location = It->second.second;
+        } else {
+            // Created by the pass
+            S.Block = Origin->getName().str();
+            S.Location = getLocation(*Origin);
+        }
+
+        Sites.push_back(S);
+        Functions.insert(InsertBefore->getFunction());
+    }
+
+    /// Create the counters and the table of their sites, and attach the counters at the entry of each function
+    /// with counters. False if nothing was counted, the module is then left as it was
+    bool finish() {
+        llvm::LLVMContext &Ctx = M.getContext();
+
+        if (Sites.empty()) {
+            Placeholder->eraseFromParent();
+            return false;
+        }
+
+        llvm::Type *Int8Ty = llvm::Type::getInt8Ty(Ctx);
+        llvm::Type *Int8PtrTy = llvm::Type::getInt8PtrTy(Ctx);
+        llvm::Type *Int64Ty = llvm::Type::getInt64Ty(Ctx);
+        llvm::ArrayType *CountersTy = llvm::ArrayType::get(Int64Ty, Sites.size());
+        std::string Prefix = "__obf_instr." + Pass;
+
+        // One array per thread, merged by the runtime
+        llvm::GlobalVariable *Counters = new llvm::GlobalVariable(
+                M, CountersTy, false, llvm::GlobalValue::InternalLinkage,
+                llvm::ConstantAggregateZero::get(CountersTy), Prefix + ".counters", nullptr,
+                llvm::GlobalValue::GeneralDynamicTLSModel);
+        Placeholder->replaceAllUsesWith(llvm::ConstantExpr::getBitCast(Counters, Int64Ty->getPointerTo()));
+        Placeholder->eraseFromParent();
+
+        llvm::GlobalVariable *Totals = new llvm::GlobalVariable(M, CountersTy, false,
+                                                                llvm::GlobalValue::InternalLinkage,
+                                                                llvm::ConstantAggregateZero::get(CountersTy),
+                                                                Prefix + ".totals");
+
+        // struct ObfInstrSite of the runtime
+        llvm::Type *SiteFields[] = {Int8PtrTy, Int8PtrTy, Int8PtrTy, Int8PtrTy};
+        llvm::StructType *SiteTy = llvm::StructType::get(Ctx, llvm::makeArrayRef(SiteFields));
+        std::vector<llvm::Constant *> SiteInits;
+
+        for (const Site &S : Sites) {
+            llvm::Constant *Fields[] = {getString(S.Kind), getString(S.Function), getString(S.Block),
+                                        getString(S.Location)};
+            SiteInits.push_back(llvm::ConstantStruct::get(SiteTy, Fields));
+        }
+
+        llvm::ArrayType *SitesTy = llvm::ArrayType::get(SiteTy, Sites.size());
+        llvm::GlobalVariable *SiteTable = new llvm::GlobalVariable(M, SitesTy, true,
+                                                                   llvm::GlobalValue::PrivateLinkage,
+                                                                   llvm::ConstantArray::get(SitesTy, SiteInits),
+                                                                   Prefix + ".sites");
+
+        // struct ObfInstrTable of the runtime, its last field links the tables the runtime knows
+        llvm::Type *TableFields[] = {Int8PtrTy, Int8PtrTy, Int64Ty, SiteTy->getPointerTo(),
+                                     Int64Ty->getPointerTo(), Int8PtrTy};
+        llvm::StructType *TableTy = llvm::StructType::get(Ctx, llvm::makeArrayRef(TableFields));
+        llvm::Constant *TableInit[] = {getString(M.getModuleIdentifier()), getString(Pass),
+                                       llvm::ConstantInt::get(Int64Ty, Sites.size()),
+                                       llvm::ConstantExpr::getBitCast(SiteTable, SiteTy->getPointerTo()),
+                                       llvm::ConstantExpr::getBitCast(Totals, Int64Ty->getPointerTo()),
+                                       llvm::ConstantPointerNull::get(llvm::Type::getInt8PtrTy(Ctx))};
+        llvm::GlobalVariable *Table = new llvm::GlobalVariable(M, TableTy, false, llvm::GlobalValue::InternalLinkage,
+                                                               llvm::ConstantStruct::get(TableTy, TableInit),
+                                                               Prefix + ".table");
+
+        llvm::GlobalVariable *Attached = new llvm::GlobalVariable(M, Int8Ty, false,
+                                                                  llvm::GlobalValue::InternalLinkage,
+                                                                  llvm::ConstantInt::get(Int8Ty, 0),
+                                                                  Prefix + ".attached", nullptr,
+                                                                  llvm::GlobalValue::GeneralDynamicTLSModel);
+
+        llvm::Type *AttachArgs[] = {Int8PtrTy, Int64Ty->getPointerTo()};
+        llvm::FunctionType *AttachTy = llvm::FunctionType::get(llvm::Type::getVoidTy(Ctx), AttachArgs, false);
+        llvm::Constant *Attach = getOrInsertObfFunction(M, "__obf_instr_attach", AttachTy);
+
+        // if (!attached) { __obf_instr_attach(&table, counters); attached = 1; } after the allocas of the entry, which
+        // must stay in the 'entry' BasicBlock. Increments before the attachment count all the same
+        for (llvm::Function *F : Functions) {
+            llvm::BasicBlock::iterator SplitPt = F->getEntryBlock().getFirstInsertionPt();
+            while (llvm::isa<llvm::AllocaInst>(SplitPt) || isInstrumentation(&*SplitPt)) {
+                ++SplitPt;
+            }
+
+            llvm::IRBuilder<> Builder(&*SplitPt);
+            llvm::Value *IsAttached = Builder.CreateLoad(Int8Ty, Attached, "obf.attached");
+            llvm::Value *Cond = Builder.CreateICmpEQ(IsAttached, llvm::ConstantInt::get(Int8Ty, 0));
+            tag(IsAttached);
+            tag(Cond);
+
+            // Taken once per thread
+            llvm::Instruction *Then = llvm::SplitBlockAndInsertIfThen(
+                    Cond, &*SplitPt, false, llvm::MDBuilder(Ctx).createBranchWeights(1, 1 << 20));
+            Then->getParent()->setName("obf.attach");
+            Then->getSuccessor(0)->setName("obf.cont");
+
+            Builder.SetInsertPoint(Then);
+            llvm::Value *Args[] = {llvm::ConstantExpr::getBitCast(Table, Int8PtrTy),
+                                   llvm::ConstantExpr::getBitCast(Counters, Int64Ty->getPointerTo())};
+            tag(Builder.CreateCall(AttachTy, Attach, Args));
+            tag(Builder.CreateStore(llvm::ConstantInt::get(Int8Ty, 1), Attached));
+        }
+
+        return true;
+    }
+};
+
+#endif
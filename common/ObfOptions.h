@@ -0,0 +1,136 @@
+// Options of the passes read by other passes.
+//
+// overheadA estimates a pipeline with the settings the passes would run with, so it reads their options (e.g.
+// -ipred-prob, -flatten-encoding) from the registry of llvm::cl by name. The options it reads are declared here with
+// the type of their values, and the pass defining an option names it by its declaration, so that the definition and
+// the readers agree on the type. An option is only registered when the library of its pass is loaded, which
+// llvm-obf and ObfPlugin always do; otherwise the given default is used.
+
+#ifndef OBF_OPTIONS_H
+#define OBF_OPTIONS_H
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+
+#include <cassert>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/// -flatten-encoding
+enum SwitchIndexEncoding {
+    ArrayEncoding,  // Opaque values computed from an aliasing array permuted by permute()
+    AffineEncoding, // switch_index = A * ID + key, decoded with a sub and a mul
+    XorEncoding     // switch_index = ID ^ key, decoded with a single xor
+};
+
+/// -flatten-dispatch
+enum DispatchKind {
+    SwitchDispatch,  // One 'switch' BasicBlock that every flattened BasicBlock branches to
+    ThreadedDispatch // An indirectbr through a table of BasicBlock addresses at the end of each BasicBlock
+};
+
+/// -ipred-rng
+enum RNGKind {
+    LibcRNG,    // call i32 @rand()
+    XorShiftRNG // Inlined xorshift32 step on function-local state
+};
+
+/// -ipred-select
+enum SelectKind {
+    UniformSelect, // Every family equally likely
+    CostSelect     // Likelihood inversely proportional to the latency, squared in hot BasicBlocks
+};
+
+/// -ipred-predicates
+enum PredicateKind {
+    QR19Predicate,    // (4*v*v + 4) % 19 != 0, v = x % 19
+    QR11Predicate,    // (v*v + 4*v + 5) % 11 != 0, v = x % 11
+    QR31Predicate,    // (5*v*v + 6*v + 2) % 31 != 0, v = x % 31
+    ParityPredicate,  // x*(x+1) is even
+    SquarePredicate,  // x*x % 4 < 2
+    BitwisePredicate, // (x|y) >= (x&y), y = x + c
+    TablePredicate    // T[x % 16] is even, T is a weak global
+};
+
+/// -addo-ops
+enum OpKind {
+    AddOp, // x + y
+    SubOp, // x - y
+    XorOp, // x ^ y
+    OrOp,  // x | y
+    AndOp, // x & y
+    MulOp, // x * y
+    CmpOp  // icmp
+};
+
+/// An option read by name, whose cl::opt (or cl::list) holds values of type T
+template <typename T>
+struct ObfOption {
+    llvm::StringRef Name;
+};
+
+// flattenO
+const ObfOption<SwitchIndexEncoding> FlattenEncodingOption = {"flatten-encoding"};
+const ObfOption<DispatchKind> FlattenDispatchOption = {"flatten-dispatch"};
+const ObfOption<unsigned> FlattenRegionSizeOption = {"flatten-region-size"};
+const ObfOption<unsigned> FlattenBudgetOption = {"flatten-budget"};
+
+// ipredO
+const ObfOption<int> IPredProbOption = {"ipred-prob"};
+const ObfOption<int> IPredTimesOption = {"ipred-times"};
+const ObfOption<unsigned> IPredBudgetOption = {"ipred-budget"};
+const ObfOption<RNGKind> IPredRNGOption = {"ipred-rng"};
+const ObfOption<PredicateKind> IPredPredicatesOption = {"ipred-predicates"}; // cl::list
+const ObfOption<SelectKind> IPredSelectOption = {"ipred-select"};
+
+// addO
+const ObfOption<OpKind> AddOOpsOption = {"addo-ops"}; // cl::list
+const ObfOption<unsigned> AddOMaxOverheadOption = {"addo-max-overhead"};
+const ObfOption<unsigned> AddORoundsOption = {"addo-rounds"};
+const ObfOption<unsigned> AddOBudgetOption = {"addo-budget"};
+
+// checkerT
+const ObfOption<std::string> CheckFnOption = {"checkfn"};
+const ObfOption<std::string> CheckBBOption = {"checkbb"};
+const ObfOption<int> CheckerSeedOption = {"seed"};
+
+// splitWM
+const ObfOption<unsigned> SplitsOption = {"splits"}; // cl::list
+
+/// Value of the cl::opt of 'Option', 'Default' if no loaded pass defines it
+template <typename T>
+T getObfOption(const ObfOption<T> &Option, T Default) {
+    llvm::StringMap<llvm::cl::Option *> &Options = llvm::cl::getRegisteredOptions();
+    llvm::StringMap<llvm::cl::Option *>::iterator It = Options.find(Option.Name);
+
+    if (It == Options.end()) {
+        return Default;
+    }
+
+    // A cl::list (ZeroOrMore) or a cl::opt<bool> (value optional) under the name of another type
+    assert(It->second->getNumOccurrencesFlag() != llvm::cl::ZeroOrMore && "-option is a cl::list");
+    assert((It->second->getValueExpectedFlag() == llvm::cl::ValueOptional) == (std::is_same<T, bool>::value) &&
+           "-option is not of the declared type");
+
+    return static_cast<llvm::cl::opt<T> *>(It->second)->getValue();
+}
+
+/// Values of the cl::list of 'Option', empty if no loaded pass defines it
+template <typename T>
+std::vector<T> getObfListOption(const ObfOption<T> &Option) {
+    llvm::StringMap<llvm::cl::Option *> &Options = llvm::cl::getRegisteredOptions();
+    llvm::StringMap<llvm::cl::Option *>::iterator It = Options.find(Option.Name);
+
+    if (It == Options.end()) {
+        return std::vector<T>();
+    }
+
+    assert(It->second->getNumOccurrencesFlag() == llvm::cl::ZeroOrMore && "-option is not a cl::list");
+
+    llvm::cl::list<T> *List = static_cast<llvm::cl::list<T> *>(It->second);
+    return std::vector<T>(List->begin(), List->end());
+}
+
+#endif // OBF_OPTIONS_H
@@ -0,0 +1,69 @@
+// New pass manager versions of the passes of this project.
+//
+// Each pass runs the implementation of its legacy pass and reports explicitly what it preserves. They are
+// registered by the ObfPlugin pass plugin (plugin/ObfPlugin.cpp). The plugin interface (PassPlugin.h)
+// exists from LLVM 7 on. Legacy passes that llvm-obf creates with arguments are declared here as well.
+
+#ifndef OBF_PASSES_H
+#define OBF_PASSES_H
+
+#include "llvm/Config/llvm-config.h"
+
+#include <string>
+#include <vector>
+
+namespace llvm {
+    class ModulePass;
+    class StringRef;
+}
+
+/// Legacy cyclomaticA labeling its metrics with 'Stage' (llvm-obf -metrics)
+llvm::ModulePass *createCyclomaticAPass(llvm::StringRef Stage);
+
+/// Legacy overheadA estimating the passes 'Pipeline' (llvm-obf -estimate)
+llvm::ModulePass *createOverheadAPass(const std::vector<std::string> &Pipeline);
+
+#if LLVM_VERSION_MAJOR >= 7
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PassManager.h"
+
+/// Flattens the CFG by means of switching (flattenO)
+struct FlattenOPass : public llvm::PassInfoMixin<FlattenOPass> {
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM);
+};
+
+/// Obfuscates the CFG by inserting invariant predicates (ipredO)
+struct IPredOPass : public llvm::PassInfoMixin<IPredOPass> {
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM);
+};
+
+/// MBA obfuscation of integer operations (addO)
+struct AddOPass : public llvm::PassInfoMixin<AddOPass> {
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM);
+};
+
+/// Inserts checkers before basic blocks for tamper proofing (checkerT)
+struct CheckerTPass : public llvm::PassInfoMixin<CheckerTPass> {
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM);
+};
+
+/// Inserts a CRT-split watermark into module (splitWM)
+struct ChineseWMPass : public llvm::PassInfoMixin<ChineseWMPass> {
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM);
+};
+
+/// Computes the code metrics of each function (cyclomaticA)
+struct CyclomaticAPass : public llvm::PassInfoMixin<CyclomaticAPass> {
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM);
+};
+
+/// Estimates the runtime overhead of an obfuscation pipeline (overheadA)
+struct OverheadAPass : public llvm::PassInfoMixin<OverheadAPass> {
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM);
+};
+
+#endif // LLVM_VERSION_MAJOR >= 7
+
+#endif // OBF_PASSES_H
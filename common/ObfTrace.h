@@ -0,0 +1,283 @@
+// Time tracing of the obfuscation passes in the Chrome trace event format (chrome://tracing, Perfetto, speedscope).
+//
+// Each pass opens an ObfTraceScope around its run on a module and around its work on each function. A scope
+// becomes a complete event ("ph":"X") named after the pass, of the category "obf.module" or "obf.function". Its
+// detail is the module or function, its arguments the instructions, BasicBlocks and IR bytes before and after,
+// and the change of the heap in use and of the peak resident set size. Tracing is enabled by llvm-obf
+// -time-trace, or by OBF_TIME_TRACE=<file> in the environment of any tool loading the passes (opt -load), and
+// costs a flag test per scope otherwise. From LLVM 9 on, the scopes are also TimeTraceScopes, so they show up in
+// the trace of a tool run with LLVM's -time-trace.
+//
+// The heap and the peak RSS are those of the process: with modules compiled concurrently (llvm-obf -j) the deltas
+// include the other threads.
+
+#ifndef OBF_TRACE_H
+#define OBF_TRACE_H
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "ObfCompat.h"
+
+#if LLVM_VERSION_MAJOR >= 9
+#include "llvm/Support/TimeProfiler.h"
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// Size of IR: instructions, BasicBlocks and the bytes of their objects and operands
+struct ObfIRSize {
+    int64_t Insts;
+    int64_t Blocks;
+    int64_t Bytes;
+
+    ObfIRSize() : Insts(0), Blocks(0), Bytes(0) {}
+
+    void add(const llvm::Function &F) {
+        for (const llvm::BasicBlock &BB : F) {
+            Blocks += 1;
+            Bytes += sizeof(llvm::BasicBlock);
+
+            for (const llvm::Instruction &I : BB) {
+                Insts += 1;
+                Bytes += sizeof(llvm::Instruction) + I.getNumOperands() * sizeof(llvm::Use);
+            }
+        }
+    }
+
+    void add(const llvm::Module &M) {
+        for (const llvm::Function &F : M) {
+            add(F);
+        }
+    }
+};
+
+/// Events of the scopes of the process, written as one trace
+class ObfTraceCollector {
+    struct Event {
+        std::string Name;
+        std::string Detail;
+        const char *Category;
+        uint64_t Start;    // Microseconds since the collector was created
+        uint64_t Duration; // Microseconds
+        unsigned Thread;
+        std::vector<std::pair<const char *, int64_t> > Args;
+    };
+
+    std::mutex Mutex;
+    std::vector<Event> Events;
+    std::map<std::thread::id, unsigned> Threads; // Small thread ids, in order of their first event
+    std::chrono::steady_clock::time_point Begin;
+    std::string EnvFile; // OBF_TIME_TRACE, written when the process exits
+    bool Enabled;
+
+    static void printJSONString(llvm::raw_ostream &OS, llvm::StringRef S) {
+        OS << '"';
+        for (unsigned char C : S) {
+            if (C == '"' || C == '\\') {
+                OS << '\\' << C;
+            } else if (C < 0x20) {
+                OS << llvm::format("\\u%04x", C);
+            } else {
+                OS << C;
+            }
+        }
+        OS << '"';
+    }
+
+public:
+    ObfTraceCollector() : Begin(std::chrono::steady_clock::now()), Enabled(false) {
+        const char *Env = getenv("OBF_TIME_TRACE");
+
+        if (Env && *Env) {
+            EnvFile = Env;
+            Enabled = true;
+        }
+    }
+
+    ~ObfTraceCollector() {
+        if (!EnvFile.empty()) {
+            write(EnvFile);
+        }
+    }
+
+    void enable() {
+        Enabled = true;
+    }
+
+    bool isEnabled() const {
+        return Enabled;
+    }
+
+    uint64_t now() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - Begin)
+                .count();
+    }
+
+    void add(llvm::StringRef Name, llvm::StringRef Detail, const char *Category, uint64_t Start,
+             std::vector<std::pair<const char *, int64_t> > &Args) {
+        uint64_t End = now();
+        std::lock_guard<std::mutex> Lock(Mutex);
+        unsigned Thread = Threads.insert(std::make_pair(std::this_thread::get_id(), Threads.size())).first->second;
+
+        Events.push_back(Event());
+        Event &E = Events.back();
+        E.Name = Name.str();
+        E.Detail = Detail.str();
+        E.Category = Category;
+        E.Start = Start;
+        E.Duration = End - Start;
+        E.Thread = Thread;
+        E.Args.swap(Args);
+    }
+
+    /// Write the events as {"traceEvents":[...]}, false on failure
+    bool write(llvm::StringRef Path) {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        std::error_code EC;
+        llvm::raw_fd_ostream OS(Path, EC, ObfOpenText);
+
+        if (EC) {
+            llvm::errs() << Path << ": " << EC.message() << "\n";
+            return false;
+        }
+
+        OS << "{\"traceEvents\":[";
+
+        for (unsigned I = 0; I < Events.size(); ++I) {
+            const Event &E = Events[I];
+
+            OS << (I ? ",\n" : "\n") << "{\"name\":";
+            printJSONString(OS, E.Name);
+            OS << ",\"cat\":\"" << E.Category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << E.Thread
+               << ",\"ts\":" << E.Start << ",\"dur\":" << E.Duration << ",\"args\":{\"detail\":";
+            printJSONString(OS, E.Detail);
+            for (const std::pair<const char *, int64_t> &Arg : E.Args) {
+                OS << ",\"" << Arg.first << "\":" << Arg.second;
+            }
+            OS << "}}";
+        }
+
+        OS << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+        return true;
+    }
+};
+
+/// The collector of the process
+inline ObfTraceCollector &getObfTrace() {
+    static ObfTraceCollector Trace;
+    return Trace;
+}
+
+/// A traced region of a pass on a module or on one function
+class ObfTraceScope {
+    const llvm::Module *M;
+    const llvm::Function *F;
+    std::string Name;
+    std::string Detail;
+    uint64_t Start;
+    ObfIRSize Before;
+    size_t Heap;
+    long PeakRSS; // KiB
+
+#if LLVM_VERSION_MAJOR >= 9
+    llvm::TimeTraceScope LLVMScope;
+#endif
+
+    static long getPeakRSS() {
+        struct rusage Usage;
+        return getrusage(RUSAGE_SELF, &Usage) == 0 ? Usage.ru_maxrss : 0;
+    }
+
+    void begin(llvm::StringRef PassName, llvm::StringRef Region) {
+        if (!getObfTrace().isEnabled()) {
+            M = nullptr;
+            F = nullptr;
+            return;
+        }
+
+        Name = PassName.str();
+        Detail = Region.str();
+
+        if (F) {
+            Before.add(*F);
+        } else {
+            Before.add(*M);
+        }
+
+        Heap = llvm::sys::Process::GetMallocUsage();
+        PeakRSS = getPeakRSS();
+        Start = getObfTrace().now();
+    }
+
+public:
+    /// Region of the pass 'Name' on the module 'M'
+    ObfTraceScope(llvm::StringRef Name, const llvm::Module &M)
+        : M(&M), F(nullptr)
+#if LLVM_VERSION_MAJOR >= 9
+        , LLVMScope(Name, M.getModuleIdentifier())
+#endif
+    {
+        begin(Name, M.getModuleIdentifier());
+    }
+
+    /// Region of the pass 'Name' on the function 'F'. Declarations are not traced
+    ObfTraceScope(llvm::StringRef Name, const llvm::Function &F)
+        : M(F.getParent()), F(&F)
+#if LLVM_VERSION_MAJOR >= 9
+        , LLVMScope(Name, F.getName())
+#endif
+    {
+        if (F.isDeclaration()) {
+            this->M = nullptr;
+            this->F = nullptr;
+            return;
+        }
+
+        begin(Name, F.getName());
+    }
+
+    ~ObfTraceScope() {
+        if (!M) {
+            return;
+        }
+
+        ObfIRSize After;
+
+        if (F) {
+            After.add(*F);
+        } else {
+            After.add(*M);
+        }
+
+        std::vector<std::pair<const char *, int64_t> > Args;
+        Args.push_back(std::make_pair("instructions_before", Before.Insts));
+        Args.push_back(std::make_pair("instructions_after", After.Insts));
+        Args.push_back(std::make_pair("blocks_before", Before.Blocks));
+        Args.push_back(std::make_pair("blocks_after", After.Blocks));
+        Args.push_back(std::make_pair("ir_bytes_before", Before.Bytes));
+        Args.push_back(std::make_pair("ir_bytes_after", After.Bytes));
+        Args.push_back(std::make_pair("heap_delta", int64_t(llvm::sys::Process::GetMallocUsage()) - int64_t(Heap)));
+        Args.push_back(std::make_pair("peak_rss_delta_kib", int64_t(getPeakRSS() - PeakRSS)));
+
+        getObfTrace().add(Name, Detail, F ? "obf.function" : "obf.module", Start, Args);
+    }
+};
+
+#endif
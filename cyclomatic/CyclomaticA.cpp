@@ -1,42 +1,282 @@
+// CyclomaticA: Code metrics of the functions of a module.
+//
+// For each function with a body: the cyclomatic number (e - n + 2), the numbers of basic blocks and instructions,
+// the maximum loop nesting depth, the fan-in (distinct callers in the module), the fan-out (distinct callees) and
+// the estimated dynamic instructions per call (BlockFrequencyInfo). The instructions of the functions are scanned
+// concurrently on a thread pool. The loops and frequencies are computed on the calling thread, or taken from the
+// analysis manager of the new pass manager: BranchProbabilityInfo registers value handles in the LLVMContext shared
+// by the functions, which is not thread-safe. With -metrics-json
+// the metrics of each run are appended to a file as one JSON object per line, labeled with the module and the stage
+// (e.g. llvm-obf -metrics runs the pass before and after each obfuscation pass).
 
 #include "llvm/Pass.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/Function.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Instructions.h>
+#include "ObfCompat.h"
+#include "ObfCost.h"
+#include "ObfPasses.h"
+#include "ObfTrace.h"
 #include <algorithm>
-
-#define DEBUG 0
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace llvm;
+
+static cl::opt<std::string> MetricsJSON("metrics-json",
+                                        cl::desc("Append the metrics of each run as one JSON line to <file> "
+                                                 "instead of printing them"),
+                                        cl::value_desc("filename"), cl::init(""), cl::Optional);
+
+static cl::opt<unsigned> MetricsThreads("metrics-threads",
+                                        cl::desc("Number of threads scanning functions (0 = hardware concurrency)"),
+                                        cl::value_desc("threads"), cl::init(0), cl::Optional);
+
+// Functions analyzed by one task of the thread pool
+static const unsigned FunctionsPerTask = 64;
+
+// Serializes the appends to -metrics-json, modules may be analyzed concurrently (llvm-obf)
+static std::mutex MetricsMutex;
+
 namespace {
-    struct CyclomaticA : public FunctionPass {
+    /// Metrics of one function
+    struct FunctionMetrics {
+        Function *F;
+        int Cyclomatic;
+        unsigned Blocks;
+        unsigned Insts;
+        unsigned LoopDepth;    // Maximum loop nesting depth, 0 without loops
+        unsigned FanIn;        // Distinct functions of the module calling 'F'
+        unsigned FanOut;       // Distinct functions called by 'F'
+        double DynamicInsts;   // Estimated instructions executed per call
+        std::vector<Function *> Callees;
+    };
+
+    struct CyclomaticA : public ModulePass {
         static char ID;
 
-        CyclomaticA() : FunctionPass(ID) {}
-
-        virtual bool runOnFunction(Function &F) {
-            int n = 0; // #basic blocks
-            int e = 0; // #edges
-            for (auto BI = F.begin(), BE = F.end(); BI != BE; ++BI) {
-                TerminatorInst* TermInst = BI->getTerminator();
-                auto Succ = TermInst->successors();
-                e += std::distance(Succ.begin(), Succ.end());
-                ++n;
-#if DEBUG
-                errs() << BI->getName() << " has successors: " << "\n";
-                for (auto SI = Succ.begin(), SE = Succ.end(); SI != SE; ++SI) {
-                    errs() << SI->getName() << "\n";
+        std::string Stage; // Label of the metrics, e.g. "before" or "after flattenO"
+
+        FunctionAnalysisManager *FAM; // Cached analyses of the new pass manager, null under the legacy one
+
+        CyclomaticA(StringRef Stage = "") : ModulePass(ID), Stage(Stage), FAM(nullptr) {}
+
+        virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+            AU.setPreservesAll();
+        }
+
+        virtual bool runOnModule(Module &M) {
+            ObfTraceScope Scope("cyclomaticA", M);
+
+            std::vector<FunctionMetrics> Metrics;
+
+            for (Function &F : M) {
+                if (!F.isDeclaration()) {
+                    Metrics.push_back(FunctionMetrics());
+                    Metrics.back().F = &F;
                 }
-#endif
             }
-            errs() << F.getName() << " has cyclomatic number: " << n + e + 2 << "\n";
+
+            analyzeFunctions(Metrics);
+
+            // Fan-in is known once the callees of all functions are
+            DenseMap<Function *, unsigned> Index;
+
+            for (unsigned I = 0; I < Metrics.size(); ++I) {
+                Index[Metrics[I].F] = I;
+            }
+
+            for (const FunctionMetrics &FM : Metrics) {
+                for (Function *Callee : FM.Callees) {
+                    auto It = Index.find(Callee);
+
+                    if (It != Index.end()) {
+                        Metrics[It->second].FanIn += 1;
+                    }
+                }
+            }
+
+            if (MetricsJSON.empty()) {
+                for (const FunctionMetrics &FM : Metrics) {
+                    errs() << FM.F->getName() << " has cyclomatic number: " << FM.Cyclomatic << " (blocks "
+                           << FM.Blocks << ", instructions " << FM.Insts << ", loop depth " << FM.LoopDepth
+                           << ", fan-in " << FM.FanIn << ", fan-out " << FM.FanOut << ", dynamic instructions "
+                           << format("%.1f", FM.DynamicInsts) << ")\n";
+                }
+            } else {
+                writeJSON(M, Metrics);
+            }
+
+            return false;
         }
+
+        void analyzeFunctions(std::vector<FunctionMetrics> &Metrics);
+
+        void writeJSON(Module &M, const std::vector<FunctionMetrics> &Metrics);
     };
 }
 
 char CyclomaticA::ID = 0;
 
-static RegisterPass<CyclomaticA> X("cyclomaticA", "Computes the cyclomatic number of each function in a module", false,
+static RegisterPass<CyclomaticA> X("cyclomaticA", "Computes the code metrics of each function in a module", false,
                                    false);
 
+ModulePass *createCyclomaticAPass(StringRef Stage) {
+    return new CyclomaticA(Stage);
+}
+
+/// Compute the metrics of 'FM.F' that only read its instructions: all but the loop depth, the dynamic instructions
+/// and the fan-in
+static void scanFunction(FunctionMetrics &FM) {
+    Function &F = *FM.F;
+    SmallPtrSet<Function *, 8> Callees;
+    unsigned Edges = 0;
+
+    FM.Blocks = FM.Insts = FM.LoopDepth = FM.FanIn = 0;
+    FM.DynamicInsts = 0;
+
+    for (BasicBlock &BB : F) {
+        FM.Blocks += 1;
+        FM.Insts += BB.size();
+        Edges += BB.getTerminator()->getNumSuccessors();
+
+        for (Instruction &I : BB) {
+            Function *Callee = nullptr;
+
+            if (CallInst *CI = dyn_cast<CallInst>(&I)) {
+                Callee = CI->getCalledFunction();
+            } else if (InvokeInst *II = dyn_cast<InvokeInst>(&I)) {
+                Callee = II->getCalledFunction();
+            }
+
+            if (Callee && !Callee->isIntrinsic()) {
+                Callees.insert(Callee);
+            }
+        }
+    }
+
+    FM.Cyclomatic = int(Edges) - int(FM.Blocks) + 2;
+    FM.Callees.assign(Callees.begin(), Callees.end());
+    FM.FanOut = FM.Callees.size();
+}
+
+/// Compute the loop depth and the dynamic instructions of 'FM.F'. Not thread-safe (value handles of BPI)
+static void analyzeFrequencies(FunctionMetrics &FM, FunctionAnalysisManager *FAM) {
+    Function &F = *FM.F;
+    ObfTraceScope Scope("cyclomaticA", F);
+    ObfFunctionInfo Info(F, FAM);
+    LoopInfo &LI = Info.getLoopInfo();
+    BlockFrequencyInfo &BFI = Info.getBFI();
+    double EntryFreq = BFI.getEntryFreq();
+
+    for (BasicBlock &BB : F) {
+        FM.LoopDepth = std::max(FM.LoopDepth, LI.getLoopDepth(&BB));
+        FM.DynamicInsts += BFI.getBlockFreq(&BB).getFrequency() / EntryFreq * BB.size();
+    }
+}
+
+/// Analyze the functions of 'Metrics': their instructions on -metrics-threads threads, in batches of
+/// FunctionsPerTask, then their loops and frequencies one by one
+void CyclomaticA::analyzeFunctions(std::vector<FunctionMetrics> &Metrics) {
+    unsigned Threads = MetricsThreads ? MetricsThreads : std::max(1U, std::thread::hardware_concurrency());
+
+    if (Threads == 1 || Metrics.size() <= FunctionsPerTask) {
+        for (FunctionMetrics &FM : Metrics) {
+            scanFunction(FM);
+        }
+    } else {
+        ThreadPool Pool(getObfThreads(Threads));
+
+        for (size_t Begin = 0; Begin < Metrics.size(); Begin += FunctionsPerTask) {
+            Pool.async([&Metrics, Begin] {
+                size_t End = std::min(Metrics.size(), Begin + FunctionsPerTask);
+
+                for (size_t I = Begin; I < End; ++I) {
+                    scanFunction(Metrics[I]);
+                }
+            });
+        }
+
+        Pool.wait();
+    }
+
+    for (FunctionMetrics &FM : Metrics) {
+        analyzeFrequencies(FM, FAM);
+    }
+}
+
+/// Print 'S' as a JSON string
+static void printJSONString(raw_ostream &OS, StringRef S) {
+    OS << '"';
+    for (unsigned char C : S) {
+        if (C == '"' || C == '\\') {
+            OS << '\\' << C;
+        } else if (C < 0x20) {
+            OS << format("\\u%04x", C);
+        } else {
+            OS << C;
+        }
+    }
+    OS << '"';
+}
+
+/// Append the metrics of 'M' as one line to -metrics-json
+void CyclomaticA::writeJSON(Module &M, const std::vector<FunctionMetrics> &Metrics) {
+    std::string Line;
+    raw_string_ostream OS(Line);
+
+    OS << "{\"module\":";
+    printJSONString(OS, M.getModuleIdentifier());
+    OS << ",\"stage\":";
+    printJSONString(OS, Stage);
+    OS << ",\"functions\":[";
+
+    for (unsigned I = 0; I < Metrics.size(); ++I) {
+        const FunctionMetrics &FM = Metrics[I];
+
+        OS << (I ? "," : "") << "{\"name\":";
+        printJSONString(OS, FM.F->getName());
+        OS << ",\"cyclomatic\":" << FM.Cyclomatic << ",\"blocks\":" << FM.Blocks << ",\"instructions\":" << FM.Insts
+           << ",\"loop_depth\":" << FM.LoopDepth << ",\"fan_in\":" << FM.FanIn << ",\"fan_out\":" << FM.FanOut
+           << ",\"dynamic_instructions\":" << format("%.3f", FM.DynamicInsts) << "}";
+    }
+
+    OS << "]}\n";
+    OS.flush();
+
+    std::lock_guard<std::mutex> Lock(MetricsMutex);
+    std::error_code EC;
+    raw_fd_ostream Out(MetricsJSON, EC, ObfOpenAppend);
+
+    if (EC) {
+        errs() << MetricsJSON << ": " << EC.message() << "\n";
+        return;
+    }
+
+    Out << Line;
+}
+
+#if LLVM_VERSION_MAJOR >= 7
+PreservedAnalyses CyclomaticAPass::run(Module &M, ModuleAnalysisManager &AM) {
+    CyclomaticA Impl; // Same implementation as the legacy pass
+    Impl.FAM = &AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    Impl.runOnModule(M);
+
+    return PreservedAnalyses::all();
+}
+#endif
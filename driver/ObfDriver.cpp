@@ -0,0 +1,398 @@
+// llvm-obf: Obfuscates modules with the passes of this project and compiles them to object files.
+//
+// The passes are linked in, so a module is parsed once, run through the pipeline given by -passes and
+// compiled in memory, without writing intermediate .ll or .s files. Several input modules are processed
+// concurrently on a thread pool (-jN), each in its own LLVMContext. An input is written to the file given
+// by -o, or to <input stem>.o if several inputs are given.
+//
+// With -split=N each module is additionally split into N partitions (SplitModule) that are obfuscated and
+// compiled on the pool, and the partition objects are linked into one relocatable object. The partitioning
+// and the random numbers of the passes (-rng-seed, module identifier and pass name) do not depend on the
+// number of threads, so neither does the output.
+//
+// With -metrics the code metrics of cyclomaticA are computed before the first and after each obfuscation pass,
+// e.g. appended as JSON lines to the file given by -metrics-json.
+//
+// With -time-trace the passes trace their run on each module and function (common/ObfTrace.h), and the trace is
+// written in the Chrome trace event format to the file given by -time-trace-file. The event "llvm-obf" of a
+// module spans its passes and code generation.
+//
+// With -estimate overheadA prints the estimated runtime overhead of the pipeline, with the options given to the
+// passes, before running it (e.g. appended as JSON lines to the file given by -overhead-json).
+//
+// With -obf-config the passes read per-function settings from a configuration file (common/ObfConfig.h), e.g.
+// written by bench/autotune.py.
+//
+//   llvm-obf fac.ll fib.ll pow.ll -passes=flattenO,ipredO,addO -j4 -rng-seed=42
+//   llvm-obf fac.ll -passes=flattenO,ipredO,addO -split=8 -j4 -rng-seed=42 -o fac.o
+//   llvm-obf fac.ll -passes=flattenO,ipredO -metrics -metrics-json=metrics.jsonl
+//   llvm-obf big.ll -passes=flattenO,ipredO,addO -time-trace -time-trace-file=big.trace.json
+//   llvm-obf fac.ll -passes=flattenO,ipredO -ipred-prob=60 -ipred-times=2 -estimate
+//   llvm-obf interp.ll -passes=flattenO,ipredO,addO -obf-config=interp.config -rng-seed=1
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Pass.h"
+#include "llvm/PassInfo.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "ObfCompat.h"
+#include "ObfConfig.h"
+#include "ObfPasses.h"
+#include "ObfTrace.h"
+
+#if LLVM_VERSION_MAJOR >= 14
+#include "llvm/MC/TargetRegistry.h"
+#else
+#include "llvm/Support/TargetRegistry.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string> InputFilenames(cl::Positional, cl::desc("<input modules>"), cl::OneOrMore);
+
+static cl::opt<std::string> OutputFilename("o", cl::desc("Output object file (single input only)"),
+                                           cl::value_desc("filename"));
+
+static cl::list<std::string> Passes("passes", cl::CommaSeparated,
+                                    cl::desc("Obfuscation passes to run, in order (e.g. flattenO,ipredO,addO)"),
+                                    cl::value_desc("pass,pass,..."));
+
+static cl::opt<unsigned> NumPartitions("split", cl::desc("Number of partitions obfuscated and compiled in parallel"),
+                                       cl::value_desc("partitions"), cl::init(1));
+
+static cl::opt<unsigned> NumThreads("j", cl::desc("Number of worker threads (0 = hardware concurrency)"),
+                                    cl::value_desc("threads"), cl::init(0), cl::Prefix);
+
+static cl::opt<bool> Metrics("metrics", cl::desc("Compute the code metrics of cyclomaticA before the first and "
+                                                 "after each pass"), cl::init(false));
+
+static cl::opt<bool> Estimate("estimate", cl::desc("Estimate the runtime overhead of the passes with overheadA "
+                                                   "before running them"), cl::init(false));
+
+static cl::opt<std::string> ConfigFile("obf-config", cl::desc("Per-function settings of the passes (replaces "
+                                                               "OBF_CONFIG)"),
+                                       cl::value_desc("filename"));
+
+static cl::opt<bool> TimeTrace("time-trace", cl::desc("Trace the time, IR growth and memory of the passes on each "
+                                                     "module and function"), cl::init(false));
+
+static cl::opt<std::string> TimeTraceFile("time-trace-file", cl::desc("Chrome trace output of -time-trace"),
+                                          cl::value_desc("filename"), cl::init("llvm-obf.trace.json"));
+
+static cl::opt<Reloc::Model> RelocModel("relocation-model", cl::desc("Relocation model of the emitted objects"),
+                                        cl::init(Reloc::PIC_),
+                                        cl::values(clEnumValN(Reloc::Static, "static",
+                                                              "Non-relocatable code (absolute addressing, "
+                                                              "e.g. for checkerT)"),
+                                                   clEnumValN(Reloc::PIC_, "pic", "Position independent code")));
+
+namespace {
+    /// One input module and the objects compiled from it
+    struct CompileUnit {
+        std::string Input;
+        std::string Output;
+        std::vector<SmallVector<char, 0> > Bitcodes; // Partitions (-split)
+        std::vector<SmallVector<char, 0> > Objects;
+    };
+}
+
+/// Run the obfuscation passes on 'M' and emit an object file into 'Object'
+static bool obfuscateAndCompile(Module &M, SmallVectorImpl<char> &Object) {
+    std::string Error;
+    Triple TT(M.getTargetTriple().empty() ? sys::getDefaultTargetTriple() : M.getTargetTriple());
+    const Target *T = TargetRegistry::lookupTarget(TT.str(), Error);
+
+    if (!T) {
+        errs() << M.getModuleIdentifier() << ": " << Error << "\n";
+        return false;
+    }
+
+    std::unique_ptr<TargetMachine> TM(
+            T->createTargetMachine(TT.str(), "generic", "", TargetOptions(), Optional<Reloc::Model>(RelocModel)));
+    M.setDataLayout(TM->createDataLayout());
+
+    ObfTraceScope Scope("llvm-obf", M);
+    legacy::PassManager PM;
+
+    if (Estimate) {
+        PM.add(createOverheadAPass(std::vector<std::string>(Passes.begin(), Passes.end())));
+    }
+
+    if (Metrics) {
+        PM.add(createCyclomaticAPass("before"));
+    }
+
+    for (const std::string &Name : Passes) {
+        PM.add(PassRegistry::getPassRegistry()->getPassInfo(Name)->createPass());
+
+        if (Metrics) {
+            PM.add(createCyclomaticAPass("after " + Name));
+        }
+    }
+    PM.add(createVerifierPass());
+
+    raw_svector_ostream OS(Object);
+
+#if LLVM_VERSION_MAJOR >= 10
+    if (TM->addPassesToEmitFile(PM, OS, nullptr, CGFT_ObjectFile)) {
+#elif LLVM_VERSION_MAJOR >= 7
+    if (TM->addPassesToEmitFile(PM, OS, nullptr, TargetMachine::CGFT_ObjectFile)) {
+#else
+    if (TM->addPassesToEmitFile(PM, OS, TargetMachine::CGFT_ObjectFile)) {
+#endif
+        errs() << M.getModuleIdentifier() << ": target does not support object file emission\n";
+        return false;
+    }
+
+    PM.run(M);
+
+    return true;
+}
+
+/// Parse the input of 'Unit' and either compile it or split it into bitcode partitions
+static bool parseUnit(CompileUnit &Unit) {
+    LLVMContext Ctx;
+    SMDiagnostic Err;
+    std::unique_ptr<Module> M = parseIRFile(Unit.Input, Err, Ctx);
+
+    if (!M) {
+        Err.print("llvm-obf", errs());
+        return false;
+    }
+
+    if (NumPartitions <= 1) {
+        Unit.Objects.resize(1);
+        return obfuscateAndCompile(*M, Unit.Objects[0]);
+    }
+
+    // Partitions are cloned into the context of 'M', so they are handed to the workers as bitcode
+    auto WritePartition = [&](std::unique_ptr<Module> MPart) {
+        Unit.Bitcodes.emplace_back();
+        raw_svector_ostream OS(Unit.Bitcodes.back());
+#if LLVM_VERSION_MAJOR >= 7
+        WriteBitcodeToFile(*MPart, OS);
+#else
+        WriteBitcodeToFile(MPart.get(), OS);
+#endif
+    };
+
+#if LLVM_VERSION_MAJOR >= 13
+    SplitModule(*M, NumPartitions, WritePartition);
+#else
+    SplitModule(std::move(M), NumPartitions, WritePartition);
+#endif
+
+    Unit.Objects.resize(Unit.Bitcodes.size());
+
+    return true;
+}
+
+static bool compilePartition(CompileUnit &Unit, unsigned I) {
+    LLVMContext Ctx;
+    MemoryBufferRef Buffer(StringRef(Unit.Bitcodes[I].data(), Unit.Bitcodes[I].size()), Unit.Input);
+    Expected<std::unique_ptr<Module> > MPart = parseBitcodeFile(Buffer, Ctx);
+
+    if (!MPart) {
+        logAllUnhandledErrors(MPart.takeError(), errs(), "llvm-obf: ");
+        return false;
+    }
+
+    // The identifier salts the random numbers of the passes
+    (*MPart)->setModuleIdentifier(Unit.Input + ".part" + std::to_string(I));
+
+    return obfuscateAndCompile(**MPart, Unit.Objects[I]);
+}
+
+static bool writeFile(StringRef Filename, ArrayRef<char> Contents) {
+    std::error_code EC;
+    ToolOutputFile Out(Filename, EC, ObfOpenNone);
+
+    if (EC) {
+        errs() << Filename << ": " << EC.message() << "\n";
+        return false;
+    }
+
+    Out.os().write(Contents.data(), Contents.size());
+    Out.keep();
+
+    return true;
+}
+
+/// Link the partition objects into one relocatable object
+static bool linkObjects(const std::vector<std::string> &Objects, StringRef Output) {
+    ErrorOr<std::string> LD = sys::findProgramByName("ld");
+
+    if (!LD) {
+        errs() << "Could not find ld to link the partitions\n";
+        return false;
+    }
+
+    std::string OutputStr = Output.str();
+#if LLVM_VERSION_MAJOR >= 7
+    std::vector<StringRef> Args;
+#else
+    std::vector<const char *> Args;
+#endif
+
+    Args.push_back(LD->c_str());
+    Args.push_back("-r");
+    Args.push_back("-o");
+    Args.push_back(OutputStr.c_str());
+    for (const std::string &Object : Objects) {
+        Args.push_back(Object.c_str());
+    }
+
+    std::string ErrMsg;
+
+#if LLVM_VERSION_MAJOR >= 7
+    if (sys::ExecuteAndWait(*LD, Args, None, {}, 0, 0, &ErrMsg) != 0) {
+#else
+    Args.push_back(nullptr);
+
+    if (sys::ExecuteAndWait(*LD, Args.data(), nullptr, nullptr, 0, 0, &ErrMsg) != 0) {
+#endif
+        errs() << "Linking the partitions failed: " << ErrMsg << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+static bool writeUnit(const CompileUnit &Unit) {
+    if (Unit.Bitcodes.empty()) {
+        return writeFile(Unit.Output, Unit.Objects[0]);
+    }
+
+    std::vector<std::string> ObjectFiles;
+
+    for (unsigned I = 0; I < Unit.Objects.size(); ++I) {
+        ObjectFiles.push_back(Unit.Output + ".part" + std::to_string(I) + ".o");
+        if (!writeFile(ObjectFiles.back(), Unit.Objects[I])) {
+            return false;
+        }
+    }
+
+    bool Linked = linkObjects(ObjectFiles, Unit.Output);
+
+    for (const std::string &ObjectFile : ObjectFiles) {
+        sys::fs::remove(ObjectFile);
+    }
+
+    return Linked;
+}
+
+int main(int argc, char **argv) {
+    sys::PrintStackTraceOnErrorSignal(argv[0]);
+    PrettyStackTraceProgram X(argc, argv);
+    llvm_shutdown_obj Y;
+
+    InitializeAllTargetInfos();
+    InitializeAllTargets();
+    InitializeAllTargetMCs();
+    InitializeAllAsmPrinters();
+    InitializeAllAsmParsers(); // Inline asm (checkerT, splitWM)
+
+    cl::ParseCommandLineOptions(argc, argv, "obfuscate and compile LLVM modules\n");
+
+    if (TimeTrace) {
+        getObfTrace().enable();
+    }
+
+    if (!ConfigFile.empty() && !getObfConfig().load(ConfigFile)) {
+        return 1;
+    }
+
+    for (const std::string &Name : Passes) {
+        if (!PassRegistry::getPassRegistry()->getPassInfo(Name)) {
+            errs() << argv[0] << ": unknown pass '" << Name << "'\n";
+            return 1;
+        }
+    }
+
+    if (!OutputFilename.empty() && InputFilenames.size() > 1) {
+        errs() << argv[0] << ": -o cannot be used with multiple input modules\n";
+        return 1;
+    }
+
+    std::vector<CompileUnit> Units(InputFilenames.size());
+
+    for (unsigned I = 0; I < Units.size(); ++I) {
+        Units[I].Input = InputFilenames[I];
+        Units[I].Output = OutputFilename.empty() ? (sys::path::stem(InputFilenames[I]) + ".o").str() : OutputFilename;
+    }
+
+    std::atomic<bool> Failed(false);
+
+    {
+        ThreadPool Pool(getObfThreads(NumThreads ? NumThreads : std::max(1U, std::thread::hardware_concurrency())));
+
+        for (unsigned U = 0; U < Units.size(); ++U) {
+            Pool.async([&, U] {
+                if (!parseUnit(Units[U])) {
+                    Failed = true;
+                }
+            });
+        }
+
+        Pool.wait();
+
+        // Partitions of all modules share the pool
+        for (unsigned U = 0; U < Units.size(); ++U) {
+            for (unsigned I = 0; I < Units[U].Bitcodes.size(); ++I) {
+                Pool.async([&, U, I] {
+                    if (!compilePartition(Units[U], I)) {
+                        Failed = true;
+                    }
+                });
+            }
+        }
+
+        Pool.wait();
+    }
+
+    if (TimeTrace && !getObfTrace().write(TimeTraceFile)) {
+        return 1;
+    }
+
+    if (Failed) {
+        return 1;
+    }
+
+    for (const CompileUnit &Unit : Units) {
+        if (!writeUnit(Unit)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
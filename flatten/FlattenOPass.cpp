@@ -1,99 +1,229 @@
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/RandomNumberGenerator.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Utils/Local.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/PromoteMemToReg.h"
+#include "ObfCompat.h"
+#include "ObfConfig.h"
+#include "ObfCost.h"
+#include "ObfInstrument.h"
+#include "ObfOptions.h"
+#include "ObfPasses.h"
+#include "ObfTrace.h"
 
 #include <algorithm>
 #include <cstdlib>
 #include <iterator>
-#include <map>
 #include <string>
 #include <vector>
 
+#define DEBUG_TYPE "FlattenO"
+
+STATISTIC(FlattenedFunctions, "Number of functions flattened");
+STATISTIC(RetargetedBlocks, "Number of BasicBlocks branching to a dispatcher");
+
 using namespace llvm;
 
+static cl::opt<SwitchIndexEncoding>
+        Encoding(FlattenEncodingOption.Name, cl::desc("Encoding of the switch index stored on each transition"),
+                 cl::values(clEnumValN(ArrayEncoding, "array", "Array aliasing through permute() (default)"),
+                            clEnumValN(AffineEncoding, "affine", "Affine-encoded IDs decoded in the 'switch' block"),
+                            clEnumValN(XorEncoding, "xor", "Xor-encoded IDs decoded in the 'switch' block")),
+                 cl::init(ArrayEncoding), cl::Optional);
+
+static cl::opt<DispatchKind>
+        Dispatch(FlattenDispatchOption.Name, cl::desc("Dispatch between the flattened BasicBlocks"),
+                 cl::values(clEnumValN(SwitchDispatch, "switch", "Single 'switch' BasicBlock (default)"),
+                            clEnumValN(ThreadedDispatch, "threaded", "Replicated indirectbr dispatch (threaded code)")),
+                 cl::init(SwitchDispatch), cl::Optional);
+
+static cl::opt<unsigned>
+        RegionSize(FlattenRegionSizeOption.Name,
+                   cl::desc("Maximum number of BasicBlocks dispatched by one local dispatcher. The 'switch' "
+                            "BasicBlock then only dispatches between regions (0 = one dispatcher per function)"),
+                   cl::value_desc("number of BasicBlocks"), cl::init(0), cl::Optional);
+
+static cl::opt<unsigned>
+        Budget(FlattenBudgetOption.Name,
+               cl::desc("Maximum estimated dynamic instruction increase per function in percent. BasicBlocks are "
+                        "flattened coldest first, the hottest keep their branches (0 = flatten all)"),
+               cl::value_desc("percent"), cl::init(0), cl::Optional);
+
+static cl::opt<bool>
+        SSAForm("flatten-ssa",
+                cl::desc("Rebuild SSA form after flattening, keeping the switch index and values live across "
+                         "BasicBlocks in registers (phi nodes at the 'switch' BasicBlock)"),
+                cl::init(false), cl::Optional);
+
+static cl::opt<bool>
+        Instrument("flatten-instrument",
+                   cl::desc("Count the transitions through the dispatcher by BasicBlock (link with "
+                            "libObfInstrRuntime.a)"),
+                   cl::init(false), cl::Optional);
+
 namespace {
     struct FlattenO : public ModulePass {
 
         static char ID;
 
-        void assignIDToBasicBlocks(Function &F, std::map<BasicBlock *, int> &BBMap);
+        std::unique_ptr<RandomNumberGenerator> RNG; // Seeded by -rng-seed, the module and the pass
+
+        SwitchIndexEncoding ModuleEncoding; // Encoding used for the module being flattened
+        uint32_t AffineMul;                 // Odd multiplier of the affine encoding
+        uint32_t AffineMulInv;              // Inverse of 'AffineMul' modulo 2^32
+
+        FunctionAnalysisManager *FAM; // Cached analyses of the new pass manager, null under the legacy one
+
+        void assignIDToBasicBlocks(Function &F, DenseMap<BasicBlock *, int> &BBMap);
 
-        void printBasicBlocksWithIDs(std::map<BasicBlock *, int> &BBMap);
+        void printBasicBlocksWithIDs(DenseMap<BasicBlock *, int> &BBMap);
+
+        SwitchIndexEncoding getModuleEncoding(Module &M);
+
+        void insertSwitchIndex(Instruction *insertBefore, int target, Value *destination, Value *key);
 
         void insertOpaqueSwitchIndex(Instruction *insertBefore, int target, Value *destination);
 
-        void removePhiNodes(Function &F);
+        void insertEncodedSwitchIndex(Instruction *insertBefore, int target, Value *destination, Value *key);
 
-        void getAnalysisUsage(AnalysisUsage &Info) const;
+        Value *decodeSwitchIndex(IRBuilder<> &Builder, Value *encoded, Value *key);
 
-        FlattenO()
-                : ModulePass(ID) {
-        }
+        unsigned partitionIntoRegions(Function &F, DenseMap<BasicBlock *, int> &BBMap,
+                                      DenseMap<BasicBlock *, int> &BBRegion);
 
-        virtual bool runOnModule(Module &M) {
-            std::map<BasicBlock *, int> BBMap; // Mapping between BasicBlocks and their unique IDs
-            std::vector<BasicBlock *> BBSkip;  // BasicBlocks whose branch instructions are left unmodified
+        SwitchInst *createRegionDispatchers(BasicBlock *SwitchBB, Value *VIndex, AllocaInst *VAlloc, Value *VKey,
+                                            DenseMap<BasicBlock *, int> &BBMap, DenseMap<BasicBlock *, int> &BBRegion,
+                                            unsigned RegionShift, std::vector<BasicBlock *> &RegionBBs);
 
-            // Remove phi nodes
-            for (Function& F : M) {
-                removePhiNodes(F);
-            }
+        void threadDispatch(SwitchInst *ISwitch, AllocaInst *VAlloc, Value *VKey);
 
-            // Insert global array and initialize it
-            ArrayType *ArrayTy_0 = ArrayType::get(IntegerType::get(M.getContext(), 32), 10);
+        void removePhiNodes(Function &F, std::vector<AllocaInst *> &Allocas);
 
-            M.getOrInsertGlobal("g_array", ArrayTy_0);
-            GlobalVariable *GArray = M.getNamedGlobal("g_array");
-            GArray->setAlignment(4);
+        void demoteValuesLiveAcrossBlocks(Function &F, std::vector<AllocaInst *> &Allocas);
 
-            std::vector<llvm::Constant *> InitValues;
+        void getAnalysisUsage(AnalysisUsage &Info) const;
 
-            InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 22));  // [2] mod 5
-            InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 14));  // [4] mod 5
-            InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 73));  // [3] mod 5
-            InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 16));  // [5] mod 11
-            InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 37));  // [4] mod 11
-            InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 117)); // [7] mod 11
-            InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 2));   // [2] mod 11
-            InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 80));  // [3] mod 11
-            InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 19));  // [8] mod 11
-            InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 77));  // [0] mod 7
+        FlattenO()
+                : ModulePass(ID), FAM(nullptr) {
+        }
 
-            GArray->setInitializer(ConstantArray::get(ArrayTy_0, InitValues));
+        int nextRandom() {
+            return (*RNG)() & 0x7FFFFFFF;
+        }
 
-            // Insert global array index ("m" always points to [2] mod 5 "g_array")
-            M.getOrInsertGlobal("m", Type::getInt32Ty(M.getContext()));
-            GlobalVariable *GVar = M.getNamedGlobal("m");
-            GVar->setInitializer(ConstantInt::get(Type::getInt32Ty(M.getContext()), 0));
+        unsigned transitionCost() const;
 
-            // Insert permute function
-            std::vector<Type *> ArgsTy;
+        void skipHotBasicBlocks(Function &F, ObfBudget &FBudget, SmallPtrSetImpl<BasicBlock *> &BBSkip);
 
-            ArgsTy.push_back(Type::getInt32PtrTy(M.getContext()));
-            ArgsTy.push_back(Type::getInt32Ty(M.getContext()));
-            ArgsTy.push_back(Type::getInt32PtrTy(M.getContext()));
+        void setDispatchWeights(SwitchInst *ISwitch, ObfBudget *FBudget);
 
-            FunctionType *FunTy = FunctionType::get(Type::getVoidTy(M.getContext()), ArgsTy, false);
-            Function::Create(FunTy, Function::ExternalLinkage, "permute", &M);
+        virtual bool runOnModule(Module &M) {
+            ObfTraceScope Scope("flattenO", M);
+
+            RNG = createObfRNG(M, this);
+            ModuleEncoding = getModuleEncoding(M);
+
+            std::unique_ptr<ObfInstrumenter> Instr;
+            if (Instrument) {
+                Instr.reset(new ObfInstrumenter(M, "flattenO"));
+            }
+
+            if (ModuleEncoding == ArrayEncoding) {
+                // Insert global array and initialize it
+                ArrayType *ArrayTy_0 = ArrayType::get(IntegerType::get(M.getContext(), 32), 10);
+
+                M.getOrInsertGlobal("g_array", ArrayTy_0);
+                GlobalVariable *GArray = M.getNamedGlobal("g_array");
+                setObfAlignment(*GArray, 4);
+
+                std::vector<llvm::Constant *> InitValues;
+
+                InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 22));  // [2] mod 5
+                InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 14));  // [4] mod 5
+                InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 73));  // [3] mod 5
+                InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 16));  // [5] mod 11
+                InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 37));  // [4] mod 11
+                InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 117)); // [7] mod 11
+                InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 2));   // [2] mod 11
+                InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 80));  // [3] mod 11
+                InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 19));  // [8] mod 11
+                InitValues.push_back(ConstantInt::get(Type::getInt32Ty(M.getContext()), 77));  // [0] mod 7
+
+                GArray->setInitializer(ConstantArray::get(ArrayTy_0, InitValues));
+
+                // One copy per module: the partitions of llvm-obf -split each define their own and are linked together
+                GArray->setLinkage(GlobalValue::InternalLinkage);
+
+                // Insert global array index ("m" always points to [2] mod 5 "g_array")
+                M.getOrInsertGlobal("m", Type::getInt32Ty(M.getContext()));
+                GlobalVariable *GVar = M.getNamedGlobal("m");
+                GVar->setInitializer(ConstantInt::get(Type::getInt32Ty(M.getContext()), 0));
+                GVar->setLinkage(GlobalValue::InternalLinkage);
+
+                // Insert permute function
+                std::vector<Type *> ArgsTy;
+
+                ArgsTy.push_back(Type::getInt32PtrTy(M.getContext()));
+                ArgsTy.push_back(Type::getInt32Ty(M.getContext()));
+                ArgsTy.push_back(Type::getInt32PtrTy(M.getContext()));
+
+                FunctionType *FunTy = FunctionType::get(Type::getVoidTy(M.getContext()), ArgsTy, false);
+                Function::Create(FunTy, Function::ExternalLinkage, "permute", &M);
+            } else {
+                // Insert key global. It is not internal, so its value cannot be assumed at compile time.
+                // The encoding is correct for any key, so the definitions of several modules may be merged.
+                M.getOrInsertGlobal("flatten_key", Type::getInt32Ty(M.getContext()));
+                GlobalVariable *GKey = M.getNamedGlobal("flatten_key");
+                GKey->setInitializer(ConstantInt::get(Type::getInt32Ty(M.getContext()), nextRandom()));
+                GKey->setLinkage(GlobalValue::WeakAnyLinkage);
+
+                // Odd multipliers are invertible modulo 2^32 (Newton iteration doubles the correct bits)
+                AffineMul = ((uint32_t) nextRandom() << 1) | 1;
+                AffineMulInv = AffineMul;
+                for (int i = 0; i < 5; ++i) {
+                    AffineMulInv *= 2 - AffineMul * AffineMulInv;
+                }
+            }
 
             for (Module::iterator FI = M.begin(), FE = M.end(); FI != FE; ++FI) {
 
-                if (FI->isDeclaration()) {
+                if (FI->isDeclaration() || !getObfConfig().isEnabled("flattenO", *FI)) {
                     continue;
                 }
 
+                ObfTraceScope FScope("flattenO", *FI);
+
+                // Frequencies are estimated on the original CFG
+                std::unique_ptr<ObfBudget> FBudget;
+                if (Budget > 0) {
+                    FBudget.reset(new ObfBudget(*FI, Budget, FAM));
+                }
+
+                DenseMap<BasicBlock *, int> BBMap; // Mapping between BasicBlocks and their unique IDs
+                SmallPtrSet<BasicBlock *, 16> BBSkip; // BasicBlocks whose branch instructions are left unmodified
+
                 BasicBlock &EntryBB = FI->front();
                 EntryBB.setName("entry"); // Convenience name for 'entry' BasicBlock
 
-                BBSkip.push_back(&EntryBB); // The 'entry' BasicBlock should not have its branches modified
+                BBSkip.insert(&EntryBB); // The 'entry' BasicBlock should not have its branches modified
 
                 Instruction *TermInstEntryBB = EntryBB.getTerminator();
 
@@ -101,14 +231,14 @@ namespace {
                 if (std::distance(FI->begin(), FI->end()) == 1) {
                     errs() << FI->getName() << " consists only of one BasicBlock."
                            << "\n";
-                    return false;
+                    continue;
                 }
 
                 // Check whether other BasicBlocks are dead
                 if (TermInstEntryBB->getOpcode() == Instruction::Ret) {
                     errs() << FI->getName() << " has only one BasicBlock that is not dead."
                            << "\n";
-                    return false;
+                    continue;
                 }
 
                 // The 'entry' BasicBlock should branch
@@ -117,45 +247,82 @@ namespace {
                 if (!BrInstEntryBB) {
                     errs() << FI->getName() << " should end with a branch instruction"
                            << "\n";
-                    return false;
+                    continue;
                 }
 
+                // Remove phi nodes and values whose definitions will not dominate their uses after flattening. Only
+                // once the function is known to be flattened, as nothing promotes them back otherwise
+                std::vector<AllocaInst *> Allocas;
+                removePhiNodes(*FI, Allocas);
+                demoteValuesLiveAcrossBlocks(*FI, Allocas);
+
                 BasicBlock *SwitchBB = SplitBlock(&EntryBB, BrInstEntryBB);
                 SwitchBB->setName("switch");
-                BBSkip.push_back(SwitchBB);
+                BBSkip.insert(SwitchBB);
 
                 assignIDToBasicBlocks(*FI, BBMap);
 
+                // Partition large functions into regions with their own dispatcher (not needed by threaded dispatch)
+                DenseMap<BasicBlock *, int> BBRegion;
+                std::vector<BasicBlock *> RegionBBs;
+                unsigned RegionShift = 0;
+
+                if (RegionSize > 0 && Dispatch == SwitchDispatch) {
+                    RegionShift = partitionIntoRegions(*FI, BBMap, BBRegion);
+                }
+
+                // Transitions within a region only go through the dispatcher of that region
+                auto getDispatcher = [&](BasicBlock *From, BasicBlock *To) {
+                    DenseMap<BasicBlock *, int>::iterator FromRegion = BBRegion.find(From);
+                    if (RegionShift && FromRegion != BBRegion.end() && FromRegion->second == BBRegion.lookup(To)) {
+                        return RegionBBs[FromRegion->second];
+                    }
+                    return SwitchBB;
+                };
+
                 // Add 'switch_index' stack slot to 'entry' BasicBlock
                 IRBuilder<> Builder(&EntryBB.front());
-                Value *VAlloc = Builder.CreateAlloca(Type::getInt32Ty(FI->getContext()), 0, "switch_index");
+                AllocaInst *VAlloc = Builder.CreateAlloca(Type::getInt32Ty(FI->getContext()), 0, "switch_index");
+                Allocas.push_back(VAlloc);
+
+                // The key of encoded switch indices is loaded once per call and kept in a register
+                Value *VKey = nullptr;
+                if (ModuleEncoding != ArrayEncoding) {
+                    VKey = Builder.CreateLoad(Type::getInt32Ty(FI->getContext()), M.getNamedGlobal("flatten_key"),
+                                              "flatten_key");
+                }
+
+                if (Instr) {
+                    Instr->count("dispatch", &EntryBB, EntryBB.getTerminator());
+                }
 
                 if (BrInstEntryBB->isConditional()) {
-                    TerminatorInst *SplitTerm = EntryBB.getTerminator(); // br label %switch
-                    TerminatorInst *IfTrueTerm = SplitBlockAndInsertIfThen(BrInstEntryBB->getCondition(), SplitTerm,
-                                                                           false);
+                    Instruction *SplitTerm = EntryBB.getTerminator(); // br label %switch
+                    Instruction *IfTrueTerm = SplitBlockAndInsertIfThen(
+                            BrInstEntryBB->getCondition(), SplitTerm, false,
+                            BrInstEntryBB->getMetadata(LLVMContext::MD_prof)); // Keep the branch weights
 
                     // Setup 'if.true' BasicBlock
                     IfTrueTerm->getParent()->setName(std::string(EntryBB.getName()) + std::string(".if.true"));
                     // Builder.SetInsertPoint(IfTrueTerm);
                     // Builder.CreateStore(
                     //    ConstantInt::get(Type::getInt32Ty(F.getContext()), BBMap[BrInstEntryBB->getSuccessor(0)]), VAlloc);
-                    insertOpaqueSwitchIndex(IfTrueTerm, BBMap[BrInstEntryBB->getSuccessor(0)], VAlloc);
+                    insertSwitchIndex(IfTrueTerm, BBMap[BrInstEntryBB->getSuccessor(0)], VAlloc, VKey);
                     IfTrueTerm->setSuccessor(0, SwitchBB);
-                    BBSkip.push_back(IfTrueTerm->getParent());
+                    BBSkip.insert(IfTrueTerm->getParent());
 
                     // Setup 'if.cont' BasicBlock
                     SplitTerm->getParent()->setName(std::string(EntryBB.getName()) + std::string(".if.cont"));
                     // Builder.SetInsertPoint(SplitTerm);
                     // Builder.CreateStore(
                     //    ConstantInt::get(Type::getInt32Ty(F.getContext()), BBMap[BrInstEntryBB->getSuccessor(1)]), VAlloc);
-                    insertOpaqueSwitchIndex(SplitTerm, BBMap[BrInstEntryBB->getSuccessor(1)], VAlloc);
-                    BBSkip.push_back(SplitTerm->getParent());
+                    insertSwitchIndex(SplitTerm, BBMap[BrInstEntryBB->getSuccessor(1)], VAlloc, VKey);
+                    BBSkip.insert(SplitTerm->getParent());
                 } else {
                     // Builder.SetInsertPoint(EntryBB.getTerminator());
                     // Builder.CreateStore(
                     //    ConstantInt::get(Type::getInt32Ty(F.getContext()), BBMap[BrInstEntryBB->getSuccessor(0)]), VAlloc);
-                    insertOpaqueSwitchIndex(EntryBB.getTerminator(), BBMap[BrInstEntryBB->getSuccessor(0)], VAlloc);
+                    insertSwitchIndex(EntryBB.getTerminator(), BBMap[BrInstEntryBB->getSuccessor(0)], VAlloc, VKey);
                 }
 
                 BrInstEntryBB->eraseFromParent(); // Remove original 'entry' BasicBlock branch from 'switch' BasicBlock
@@ -163,20 +330,42 @@ namespace {
                 // Setup 'switch' BasicBlock
                 Builder.SetInsertPoint(SwitchBB);
                 Value *VLoad = Builder.CreateLoad(Type::getInt32Ty(FI->getContext()), VAlloc);
-                SwitchInst *ISwitch = Builder.CreateSwitch(VLoad, SwitchBB, BBMap.size());
+                if (ModuleEncoding != ArrayEncoding) {
+                    VLoad = decodeSwitchIndex(Builder, VLoad, VKey);
+                }
+                SwitchInst *ISwitch;
 
-                // Add cases to switch: One case for each BasicBlock in Function
-                for (std::map<BasicBlock *, int>::iterator MI = BBMap.begin(), ME = BBMap.end(); MI != ME; ++MI) {
-                    if (MI->second != 0) {
-                        ISwitch->addCase(ConstantInt::get(Type::getInt32Ty(FI->getContext()), MI->second), MI->first);
+                if (RegionShift) {
+                    ISwitch = createRegionDispatchers(SwitchBB, VLoad, VAlloc, VKey, BBMap, BBRegion, RegionShift,
+                                                      RegionBBs);
+                } else {
+                    ISwitch = Builder.CreateSwitch(VLoad, SwitchBB, BBMap.size());
+
+                    // Add cases to switch: One case for each BasicBlock in Function (in layout order)
+                    for (BasicBlock &BB : *FI) {
+                        DenseMap<BasicBlock *, int>::iterator MI = BBMap.find(&BB);
+                        if (MI != BBMap.end() && MI->second != 0) {
+                            ISwitch->addCase(ConstantInt::get(Type::getInt32Ty(FI->getContext()), MI->second),
+                                             MI->first);
+                        }
                     }
                 }
 
+                setDispatchWeights(ISwitch, FBudget.get());
+                for (BasicBlock *RegionBB : RegionBBs) {
+                    setDispatchWeights(cast<SwitchInst>(RegionBB->getTerminator()), FBudget.get());
+                }
+
+                if (FBudget) {
+                    FBudget->charge(&EntryBB, transitionCost());
+                    skipHotBasicBlocks(*FI, *FBudget, BBSkip);
+                }
+
                 // Retarget all branch instructions in BasicBlocks to 'switch' BasicBlock
                 for (Function::iterator BI = FI->begin(), BE = FI->end(); BI != BE; ++BI) {
 
-                    if (std::find(BBSkip.begin(), BBSkip.end(), &(*BI)) != BBSkip.end()) {
-                        errs() << "Skip: " << BI->getName() << "\n";
+                    if (BBSkip.count(&*BI)) {
+                        DEBUG_WITH_TYPE(DEBUG_TYPE, errs() << "Skip: " << BI->getName() << "\n");
                         continue;
                     }
 
@@ -186,36 +375,68 @@ namespace {
                         continue;
                     }
 
+                    RetargetedBlocks += 1;
+
+                    // One transition per execution, whichever successor it goes to
+                    if (Instr) {
+                        Instr->count("dispatch", &*BI, BrInst);
+                    }
+
                     if (BrInst->isConditional()) {
-                        TerminatorInst *IfTrueTerm = SplitBlockAndInsertIfThen(BrInst->getCondition(), BrInst, false);
+                        BasicBlock *TrueDispatcher = getDispatcher(&*BI, BrInst->getSuccessor(0));
+                        BasicBlock *FalseDispatcher = getDispatcher(&*BI, BrInst->getSuccessor(1));
+                        Instruction *IfTrueTerm = SplitBlockAndInsertIfThen(
+                                BrInst->getCondition(), BrInst, false,
+                                BrInst->getMetadata(LLVMContext::MD_prof)); // Keep the branch weights
 
                         // Setup 'if.true' BasicBlock
                         IfTrueTerm->getParent()->setName(std::string(BI->getName()) + std::string(".if.true"));
                         // Builder.SetInsertPoint(IfTrueTerm);
                         // Builder.CreateStore(
                         //    ConstantInt::get(Type::getInt32Ty(F.getContext()), BBMap[BrInst->getSuccessor(0)]), VAlloc);
-                        insertOpaqueSwitchIndex(IfTrueTerm, BBMap[BrInst->getSuccessor(0)], VAlloc);
-                        IfTrueTerm->setSuccessor(0, SwitchBB);
-                        BBSkip.push_back(IfTrueTerm->getParent());
+                        insertSwitchIndex(IfTrueTerm, BBMap[BrInst->getSuccessor(0)], VAlloc, VKey);
+                        IfTrueTerm->setSuccessor(0, TrueDispatcher);
+                        BBSkip.insert(IfTrueTerm->getParent());
 
                         // Setup 'if.cont' BasicBlock
                         BrInst->getParent()->setName(std::string(BI->getName()) + std::string(".if.cont"));
                         // Builder.SetInsertPoint(BrInst);
                         // Builder.CreateStore(
                         //    ConstantInt::get(Type::getInt32Ty(F.getContext()), BBMap[BrInst->getSuccessor(1)]), VAlloc);
-                        insertOpaqueSwitchIndex(BrInst, BBMap[BrInst->getSuccessor(1)], VAlloc);
-                        BBSkip.push_back(BrInst->getParent());
+                        insertSwitchIndex(BrInst, BBMap[BrInst->getSuccessor(1)], VAlloc, VKey);
+                        BBSkip.insert(BrInst->getParent());
                         Builder.SetInsertPoint(BrInst);
-                        Builder.CreateBr(SwitchBB);
+                        Builder.CreateBr(FalseDispatcher);
                         BrInst->eraseFromParent(); // Erase conditional branch
                     } else {
                         // Builder.SetInsertPoint(BrInst);
                         // Builder.CreateStore(
                         //    ConstantInt::get(Type::getInt32Ty(F.getContext()), BBMap[BrInst->getSuccessor(0)]), VAlloc);
-                        insertOpaqueSwitchIndex(BrInst, BBMap[BrInst->getSuccessor(0)], VAlloc);
-                        BrInst->setSuccessor(0, SwitchBB);
+                        insertSwitchIndex(BrInst, BBMap[BrInst->getSuccessor(0)], VAlloc, VKey);
+                        BrInst->setSuccessor(0, getDispatcher(&*BI, BrInst->getSuccessor(0)));
                     }
                 }
+
+                if (Dispatch == ThreadedDispatch) {
+                    threadDispatch(ISwitch, VAlloc, VKey);
+                }
+
+                // Promote 'switch_index' and the demoted values back to registers.
+                // The phi nodes are rebuilt at the 'switch' BasicBlock, where the flattened control flow joins
+                if (SSAForm) {
+                    DominatorTree DT(*FI);
+                    PromoteMemToReg(Allocas, DT);
+                }
+
+                if (FBudget) {
+                    FBudget->report("flattenO", *FI, errs());
+                }
+
+                FlattenedFunctions += 1;
+            }
+
+            if (Instr) {
+                Instr->finish();
             }
 
             return true;
@@ -231,7 +452,7 @@ void FlattenO::getAnalysisUsage(AnalysisUsage &AU) const {
 }
 
 /// Assign unique ID's to all BasicBlock's in Function 'F'
-void FlattenO::assignIDToBasicBlocks(Function &F, std::map<BasicBlock *, int> &BBMap) {
+void FlattenO::assignIDToBasicBlocks(Function &F, DenseMap<BasicBlock *, int> &BBMap) {
     int BBID = 0;
 
     for (Function::iterator BI = F.begin(), BE = F.end(); BI != BE; ++BI) {
@@ -244,13 +465,291 @@ void FlattenO::assignIDToBasicBlocks(Function &F, std::map<BasicBlock *, int> &B
     }
 }
 
+/// Estimated dynamic instructions of one transition through the dispatcher: storing the switch index,
+/// branching, loading it, computing the case and switching
+unsigned FlattenO::transitionCost() const {
+    switch (ModuleEncoding) {
+        case ArrayEncoding:
+            return 4 + 12; // permute() call and array loads
+        case AffineEncoding:
+            return 4 + 4;  // encode (mul, add) and decode (sub, mul)
+        default:
+            return 4 + 2;  // encode and decode xor
+    }
+}
+
+/// The default case of a dispatcher (back to 'switch') is never taken. With -flatten-budget the cases are weighted
+/// by the frequencies of their BasicBlocks before flattening, so that the hot BasicBlocks stay close together
+void FlattenO::setDispatchWeights(SwitchInst *ISwitch, ObfBudget *FBudget) {
+    SmallVector<uint32_t, 16> Weights;
+
+    Weights.push_back(0); // Default case
+    for (auto Case : ISwitch->cases()) {
+        double Freq = FBudget ? FBudget->getFrequency(Case.getCaseSuccessor()) : 0;
+        Weights.push_back(1 + static_cast<uint32_t>(std::min(Freq * 1000, 1e9)));
+    }
+
+    ISwitch->setMetadata(LLVMContext::MD_prof, MDBuilder(ISwitch->getContext()).createBranchWeights(Weights));
+}
+
+/// Leave the branches of the hottest BasicBlocks of 'F' unmodified (add them to 'BBSkip') so that the estimated
+/// cost of flattening the other BasicBlocks fits 'FBudget'. A skipped BasicBlock still has its case in the
+/// dispatcher, it just branches to its successors directly
+void FlattenO::skipHotBasicBlocks(Function &F, ObfBudget &FBudget, SmallPtrSetImpl<BasicBlock *> &BBSkip) {
+    std::vector<BasicBlock *> Candidates;
+
+    for (BasicBlock &BB : F) {
+        if (!BBSkip.count(&BB) && isa<BranchInst>(BB.getTerminator())) {
+            Candidates.push_back(&BB);
+        }
+    }
+
+    FBudget.sortColdestFirst(Candidates);
+
+    for (BasicBlock *BB : Candidates) {
+        if (!FBudget.spend(BB, transitionCost())) {
+            BBSkip.insert(BB);
+        }
+    }
+}
+
 /// Print BasicBlock's and their associated ID's
-void FlattenO::printBasicBlocksWithIDs(std::map<BasicBlock *, int> &BBMap) {
-    for (std::map<BasicBlock *, int>::iterator MI = BBMap.begin(), ME = BBMap.end(); MI != ME; ++MI) {
+void FlattenO::printBasicBlocksWithIDs(DenseMap<BasicBlock *, int> &BBMap) {
+    for (DenseMap<BasicBlock *, int>::iterator MI = BBMap.begin(), ME = BBMap.end(); MI != ME; ++MI) {
         errs() << MI->first->getName() << " has ID " << MI->second << "\n";
     }
 }
 
+/// Determine the switch index encoding of module 'M'.
+/// A "flatten-encoding" module flag overrides -flatten-encoding for that module
+SwitchIndexEncoding FlattenO::getModuleEncoding(Module &M) {
+    MDString *Flag = dyn_cast_or_null<MDString>(M.getModuleFlag("flatten-encoding"));
+
+    if (!Flag) {
+        return Encoding;
+    }
+
+    if (Flag->getString() == "array") {
+        return ArrayEncoding;
+    }
+    if (Flag->getString() == "affine") {
+        return AffineEncoding;
+    }
+    if (Flag->getString() == "xor") {
+        return XorEncoding;
+    }
+
+    errs() << "Unknown flatten-encoding module flag: " << Flag->getString() << "\n";
+    return Encoding;
+}
+
+/// Store the switch index of 'target' into 'destination' using the encoding of the module
+void FlattenO::insertSwitchIndex(Instruction *insertBefore, int target, Value *destination, Value *key) {
+    if (ModuleEncoding == ArrayEncoding) {
+        insertOpaqueSwitchIndex(insertBefore, target, destination);
+    } else {
+        insertEncodedSwitchIndex(insertBefore, target, destination, key);
+    }
+}
+
+/// Assign an encoded value as switch index.
+/// The stored value depends on the key loaded at function entry, and costs a single ALU op
+void FlattenO::insertEncodedSwitchIndex(Instruction *insertBefore, int target, Value *destination, Value *key) {
+    IRBuilder<> Builder(insertBefore);
+    Value *VTarget;
+
+    if (ModuleEncoding == AffineEncoding) {
+        VTarget = Builder.CreateAdd(key, ConstantInt::get(key->getType(), AffineMul * (uint32_t) target), "target_enc");
+    } else {
+        VTarget = Builder.CreateXor(key, ConstantInt::get(key->getType(), target), "target_enc");
+    }
+
+    Builder.CreateStore(VTarget, destination);
+}
+
+/// Recover the BasicBlock ID from an encoded switch index
+Value *FlattenO::decodeSwitchIndex(IRBuilder<> &Builder, Value *encoded, Value *key) {
+    if (ModuleEncoding == AffineEncoding) {
+        return Builder.CreateMul(Builder.CreateSub(encoded, key, "target_off"),
+                                 ConstantInt::get(key->getType(), AffineMulInv), "target");
+    }
+
+    return Builder.CreateXor(encoded, key, "target");
+}
+
+/// Partition the BasicBlocks of 'F' (except 'entry' and 'switch') into regions of at most -flatten-region-size
+/// BasicBlocks. Strongly connected components (loops) are kept in one region whenever they fit.
+/// BasicBlocks are renumbered to ((region + 1) << shift) | index, and the shift is returned
+unsigned FlattenO::partitionIntoRegions(Function &F, DenseMap<BasicBlock *, int> &BBMap,
+                                        DenseMap<BasicBlock *, int> &BBRegion) {
+    BasicBlock *EntryBB = &F.getEntryBlock();
+    BasicBlock *SwitchBB = EntryBB->getSingleSuccessor();
+    unsigned MaxSize = std::max(2U, (unsigned) RegionSize);
+    std::vector<std::vector<BasicBlock *> > Regions;
+
+    // SCCs are visited in reverse topological order, so neighbouring SCCs tend to share a region
+    for (scc_iterator<Function *> SI = scc_begin(&F); !SI.isAtEnd(); ++SI) {
+        const std::vector<BasicBlock *> &SCC = *SI;
+
+        if (Regions.empty() || Regions.back().size() + SCC.size() > MaxSize) {
+            Regions.push_back(std::vector<BasicBlock *>());
+        }
+
+        for (BasicBlock *BB : SCC) {
+            if (BB == EntryBB || BB == SwitchBB) {
+                continue;
+            }
+            if (Regions.back().size() == MaxSize) {
+                Regions.push_back(std::vector<BasicBlock *>()); // SCC larger than a region
+            }
+            Regions.back().push_back(BB);
+        }
+    }
+
+    unsigned Shift = 1;
+    while ((1U << Shift) < MaxSize) {
+        ++Shift;
+    }
+
+    for (unsigned R = 0; R < Regions.size(); ++R) {
+        for (unsigned Idx = 0; Idx < Regions[R].size(); ++Idx) {
+            BBMap[Regions[R][Idx]] = ((R + 1) << Shift) | Idx;
+            BBRegion[Regions[R][Idx]] = R;
+        }
+    }
+
+    DEBUG_WITH_TYPE(DEBUG_TYPE, errs() << F.getName() << " partitioned into " << Regions.size() << " regions." << "\n");
+
+    return Shift;
+}
+
+/// Setup 'switch' as top-level dispatcher, which selects a region from the high bits of the switch index.
+/// Each region gets a local dispatcher, which selects a BasicBlock of the region from the low bits.
+/// Returns the switch of the top-level dispatcher
+SwitchInst *FlattenO::createRegionDispatchers(BasicBlock *SwitchBB, Value *VIndex, AllocaInst *VAlloc, Value *VKey,
+                                              DenseMap<BasicBlock *, int> &BBMap,
+                                              DenseMap<BasicBlock *, int> &BBRegion, unsigned RegionShift,
+                                              std::vector<BasicBlock *> &RegionBBs) {
+    LLVMContext &Ctx = SwitchBB->getContext();
+    Function *F = SwitchBB->getParent();
+    int NumRegions = 0;
+
+    for (DenseMap<BasicBlock *, int>::iterator MI = BBRegion.begin(), ME = BBRegion.end(); MI != ME; ++MI) {
+        NumRegions = std::max(NumRegions, MI->second + 1);
+    }
+
+    IRBuilder<> Builder(SwitchBB);
+    SwitchInst *ISwitch = Builder.CreateSwitch(
+            Builder.CreateLShr(VIndex, ConstantInt::get(Type::getInt32Ty(Ctx), RegionShift), "region"), SwitchBB,
+            NumRegions);
+
+    std::vector<SwitchInst *> RegionSwitches;
+    BasicBlock *InsertBefore = SwitchBB->getNextNode();
+
+    for (int R = 0; R < NumRegions; ++R) {
+        BasicBlock *RegionBB = BasicBlock::Create(Ctx, "switch.region" + std::to_string(R), F, InsertBefore);
+        RegionBBs.push_back(RegionBB);
+        ISwitch->addCase(ConstantInt::get(Type::getInt32Ty(Ctx), R + 1), RegionBB);
+
+        Builder.SetInsertPoint(RegionBB);
+        Value *VLoad = Builder.CreateLoad(Type::getInt32Ty(Ctx), VAlloc);
+        if (VKey) {
+            VLoad = decodeSwitchIndex(Builder, VLoad, VKey);
+        }
+        Value *VLocal = Builder.CreateAnd(VLoad, ConstantInt::get(Type::getInt32Ty(Ctx), (1U << RegionShift) - 1),
+                                          "region_index");
+        RegionSwitches.push_back(Builder.CreateSwitch(VLocal, SwitchBB));
+    }
+
+    // Add cases to the local dispatchers: One case for each BasicBlock in the region
+    for (BasicBlock &BB : *F) {
+        DenseMap<BasicBlock *, int>::iterator MI = BBRegion.find(&BB);
+        if (MI != BBRegion.end()) {
+            RegionSwitches[MI->second]->addCase(
+                    ConstantInt::get(Type::getInt32Ty(Ctx), BBMap[&BB] & ((1 << RegionShift) - 1)), &BB);
+        }
+    }
+
+    return ISwitch;
+}
+
+/// Replace the 'switch' BasicBlock by an indirectbr at the end of each of its predecessors.
+/// The switch index selects the successor from a table of BasicBlock addresses, so each BasicBlock
+/// dispatches through its own indirect branch (as in direct-threaded interpreters)
+void FlattenO::threadDispatch(SwitchInst *ISwitch, AllocaInst *VAlloc, Value *VKey) {
+    BasicBlock *SwitchBB = ISwitch->getParent();
+    Function *F = SwitchBB->getParent();
+    LLVMContext &Ctx = F->getContext();
+
+    std::vector<BasicBlock *> Destinations;
+    SmallPtrSet<BasicBlock *, 16> Seen;
+    uint64_t NumIDs = 0;
+
+    for (auto Case : ISwitch->cases()) {
+        if (Case.getCaseSuccessor() == SwitchBB) {
+            continue;
+        }
+        if (Seen.insert(Case.getCaseSuccessor()).second) {
+            Destinations.push_back(Case.getCaseSuccessor());
+        }
+        NumIDs = std::max(NumIDs, Case.getCaseValue()->getZExtValue() + 1);
+    }
+
+    if (Destinations.empty()) {
+        return;
+    }
+
+    // IDs without a case ('entry' and 'switch') are never stored, any address will do
+    std::vector<Constant *> Addresses(NumIDs, BlockAddress::get(F, Destinations.front()));
+
+    for (auto Case : ISwitch->cases()) {
+        if (Case.getCaseSuccessor() != SwitchBB) {
+            Addresses[Case.getCaseValue()->getZExtValue()] = BlockAddress::get(F, Case.getCaseSuccessor());
+        }
+    }
+
+    ArrayType *TableTy = ArrayType::get(Type::getInt8PtrTy(Ctx), NumIDs);
+    GlobalVariable *Table = new GlobalVariable(*F->getParent(), TableTy, true, GlobalValue::PrivateLinkage,
+                                               ConstantArray::get(TableTy, Addresses), F->getName() + ".dispatch");
+
+    // Replace 'br label %switch' of every predecessor with its own indirect branch
+    std::vector<BasicBlock *> Predecessors;
+    Seen.clear();
+    for (BasicBlock *Pred : predecessors(SwitchBB)) {
+        if (Pred != SwitchBB && Seen.insert(Pred).second) {
+            Predecessors.push_back(Pred);
+        }
+    }
+
+    for (BasicBlock *Pred : Predecessors) {
+        Instruction *BrInst = Pred->getTerminator();
+        IRBuilder<> Builder(BrInst);
+
+        Value *VIndex = Builder.CreateLoad(Type::getInt32Ty(Ctx), VAlloc);
+        if (VKey) {
+            VIndex = decodeSwitchIndex(Builder, VIndex, VKey);
+        }
+
+        std::vector<Value *> IdxList;
+        IdxList.push_back(ConstantInt::get(Type::getInt32Ty(Ctx), 0));
+        IdxList.push_back(VIndex);
+
+        Value *VTargetPtr = Builder.CreateInBoundsGEP(TableTy, Table, ArrayRef<Value *>(IdxList), "dispatch_ptr");
+        Value *VTarget = Builder.CreateLoad(Type::getInt8PtrTy(Ctx), VTargetPtr, "dispatch_target");
+
+        IndirectBrInst *IBrInst = Builder.CreateIndirectBr(VTarget, Destinations.size());
+        for (BasicBlock *Destination : Destinations) {
+            IBrInst->addDestination(Destination);
+        }
+
+        BrInst->eraseFromParent();
+    }
+
+    // The 'switch' BasicBlock is now only reachable from itself
+    SwitchBB->dropAllReferences();
+    SwitchBB->eraseFromParent();
+}
+
 /// Assign an opaque value as switch index.
 /// The assigned value is equal to 'target', but is computed from array aliasing
 void FlattenO::insertOpaqueSwitchIndex(Instruction *insertBefore, int target, Value *destination) {
@@ -270,7 +769,7 @@ void FlattenO::insertOpaqueSwitchIndex(Instruction *insertBefore, int target, Va
     ArgsTy.push_back(Type::getInt32PtrTy(M->getContext()));
 
     FunctionType *FunTy = FunctionType::get(Type::getVoidTy(M->getContext()), ArgsTy, false);
-    Constant *Const = M->getOrInsertFunction("permute", FunTy);
+    Constant *Const = getOrInsertObfFunction(*M, "permute", FunTy);
 
     Function *FPermute = dyn_cast<Function>(Const);
 
@@ -687,7 +1186,7 @@ void FlattenO::insertOpaqueSwitchIndex(Instruction *insertBefore, int target, Va
     }
 }
 
-void FlattenO::removePhiNodes(Function &F) {
+void FlattenO::removePhiNodes(Function &F, std::vector<AllocaInst *> &Allocas) {
 
     if (F.isDeclaration()) {
         return;
@@ -702,16 +1201,60 @@ void FlattenO::removePhiNodes(Function &F) {
 
     Instruction* AllocaInsertPoint = &*BI;
 
-    std::list<Instruction*> WorkList;
+    std::list<PHINode*> WorkList;
     for (BasicBlock &BI : F) {
-        for (BasicBlock::iterator II = BI.begin(), IE = BI.end(); II != IE; ++IE) {
-            if (isa<PHINode>(*II)) {
-                WorkList.push_back(&*II);
+        for (BasicBlock::iterator II = BI.begin(), IE = BI.end(); II != IE && isa<PHINode>(*II); ++II) {
+            WorkList.push_back(cast<PHINode>(&*II));
+        }
+    }
+    for (PHINode* PHI : WorkList) {
+        DEBUG_WITH_TYPE(DEBUG_TYPE, errs() << "Removed phi node: " << PHI->getName() << "\n");
+        Allocas.push_back(DemotePHIToStack(PHI, AllocaInsertPoint));
+    }
+}
+
+/// Demote values used outside of their defining BasicBlock to the stack.
+/// Only the 'entry' BasicBlock still dominates the other BasicBlocks once they are reached through 'switch'
+void FlattenO::demoteValuesLiveAcrossBlocks(Function &F, std::vector<AllocaInst *> &Allocas) {
+
+    if (F.isDeclaration()) {
+        return;
+    }
+
+    BasicBlock* BBEntry = &F.getEntryBlock();
+    BasicBlock::iterator BI = BBEntry->begin();
+    while(isa<AllocaInst>(*BI)) {
+        ++BI;
+    }
+
+    Instruction* AllocaInsertPoint = &*BI;
+
+    std::list<Instruction*> WorkList;
+    for (BasicBlock &BB : F) {
+        if (&BB == BBEntry) {
+            continue;
+        }
+
+        for (Instruction &I : BB) {
+            for (User *U : I.users()) {
+                if (cast<Instruction>(U)->getParent() != &BB) {
+                    WorkList.push_back(&I);
+                    break;
+                }
             }
         }
     }
     for (Instruction* I : WorkList) {
-        errs() << "Removed phi node: " << I->getName() << "\n";
-        DemotePHIToStack(cast<PHINode>(I), AllocaInsertPoint);
+        Allocas.push_back(DemoteRegToStack(*I, false, AllocaInsertPoint));
     }
 }
+
+#if LLVM_VERSION_MAJOR >= 7
+PreservedAnalyses FlattenOPass::run(Module &M, ModuleAnalysisManager &AM) {
+    FlattenO Impl; // Same implementation as the legacy pass
+    Impl.FAM = &AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    // BasicBlocks are split and the CFG rebuilt around the dispatcher
+    return Impl.runOnModule(M) ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
+#endif
@@ -0,0 +1,15 @@
+// permute() called by the 'array' encoding of flattenO, linked into the programs of test.sh.
+//
+// The encoding decodes the switch index from elements of 'array' at fixed offsets from '*m'. Rotating the array
+// and moving '*m' along keeps those offsets pointing to the same elements, so any index stays decodable.
+
+void permute(int *array, int length, int *m) {
+    int first = array[0];
+
+    for (int i = 1; i < length; ++i) {
+        array[i - 1] = array[i];
+    }
+    array[length - 1] = first;
+
+    *m = (*m + length - 1) % length;
+}
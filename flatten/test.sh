@@ -0,0 +1,168 @@
+#!/bin/bash
+
+usage()
+{
+    echo "Usage ./test.sh"
+}
+
+error()
+{
+    exit -1
+}
+
+case  $1 in
+    -h | --help )
+	echo "Testing flattenO"
+	usage
+	exit 0
+	;;
+    *)
+esac
+
+obf=../cmake-build-debug/driver/llvm-obf # all passes are linked into the driver
+
+# The default 'array' encoding calls an external permute() function, so the modes
+# below use the self-contained encodings. The -split test links permute.c.
+
+modes=("-flatten-encoding=affine"
+       "-flatten-encoding=xor"
+       "-flatten-encoding=affine -flatten-ssa"
+       "-flatten-encoding=xor -flatten-dispatch=threaded"
+       "-flatten-encoding=xor -flatten-dispatch=threaded -flatten-ssa"
+       "-flatten-encoding=affine -flatten-region-size=2"
+       "-flatten-encoding=xor -flatten-region-size=4 -flatten-ssa"
+       "-flatten-encoding=xor -flatten-budget=40"
+       "-flatten-encoding=affine -flatten-budget=60 -flatten-ssa")
+
+# flatten <program> <mode>
+flatten()
+{
+    program=$1
+    base=$(basename "$program" ".ll")
+    object=${base}\_f.o
+    binary=${base}\_f
+
+    ${obf} ${program} -passes=flattenO $2 -o ${object} 2> /dev/null
+    clang ${object} -o ${binary}
+}
+
+# check <expected> <command>
+check()
+{
+    res=$($2 > /dev/null; echo $?)
+
+    if [ $res != $1 ]; then
+        echo "Fail: $2 ($res)"
+        error
+    fi
+}
+
+for mode in "${modes[@]}"; do
+
+    printf "[Testing] flattenO ${mode}\n"
+
+    # fac
+
+    flatten "../programs/ll/fac.ll" "${mode}"
+
+    check 1 "./fac_f 1"
+    check 24 "./fac_f 4"
+    check 120 "./fac_f 5"
+
+    # fib
+
+    flatten "../programs/ll/fib.ll" "${mode}"
+
+    check 1 "./fib_f 1"
+    check 5 "./fib_f 5"
+    check 55 "./fib_f 10"
+
+    # pow
+
+    flatten "../programs/ll/pow.ll" "${mode}"
+
+    check 1 "./pow_f 1 5"
+    check 128 "./pow_f 2 7"
+    check 64 "./pow_f 4 3"
+
+    # phi
+
+    flatten "../programs/ll/phi.ll" "${mode}"
+
+    check 3 "./phi_f"
+
+    # sum100
+
+    flatten "../programs/ll/sum100.ll" "${mode}"
+
+    check 30 "./sum100_f"
+
+    # twofunc
+
+    flatten "../programs/ll/twofunc.ll" "${mode}"
+
+    check 33 "./twofunc_f"
+
+    # kernels (exit status 0 when the output matches its check)
+
+    for kernel in matmul quicksort hashtable interp crc parser; do
+        flatten "../programs/ll/${kernel}.ll" "${mode}"
+    done
+
+    check 0 "./matmul_f 24"
+    check 0 "./quicksort_f 5000"
+    check 0 "./hashtable_f 5000"
+    check 0 "./interp_f 5000"
+    check 0 "./crc_f 5000"
+    check 0 "./parser_f 5000"
+done
+
+# partitions: llvm-obf -split obfuscates and compiles parts of each module on their own and links them into one
+# object. The default 'array' encoding defines its array in every partition, permute.c implements permute()
+
+printf "[Testing] flattenO -split=3\n"
+
+clang -c permute.c -o permute.o
+
+for program in twofunc matmul interp parser; do
+    ${obf} ../programs/ll/${program}.ll -passes=flattenO -split=3 -o ${program}_s.o 2> /dev/null
+    clang ${program}_s.o permute.o -o ${program}_s
+done
+
+check 33 "./twofunc_s"
+check 0 "./matmul_s 24"
+check 0 "./interp_s 5000"
+check 0 "./parser_s 5000"
+
+# instrumentation: the transitions are counted and written to obf_instr.json at exit
+
+printf "[Testing] flattenO -flatten-instrument\n"
+
+runtime=../cmake-build-debug/runtime/libObfInstrRuntime.a
+
+${obf} ../programs/ll/fib.ll -passes=flattenO -flatten-encoding=xor -flatten-instrument -o fib_i.o 2> /dev/null
+clang fib_i.o ${runtime} -lpthread -o fib_i
+rm -f obf_instr.json
+
+check 55 "./fib_i 10"
+
+if ! grep -q '"kind":"dispatch"' obf_instr.json; then
+    echo "Fail: no dispatch counters in obf_instr.json"
+    error
+fi
+
+printf "[Testing] ipredO -ipred-instrument\n"
+
+${obf} ../programs/ll/fib.ll -passes=ipredO -ipred-rng=xorshift -ipred-instrument -o fib_i.o 2> /dev/null
+clang fib_i.o ${runtime} -lpthread -o fib_i
+rm -f obf_instr.json
+
+check 55 "./fib_i 10"
+
+if ! grep -q '"kind":"predicate"' obf_instr.json; then
+    echo "Fail: no predicate counters in obf_instr.json"
+    error
+fi
+
+echo "[Success] All tests passed..."
+exit 0
@@ -36,14 +36,28 @@
 #include "llvm/IR/Function.h"
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
 #include <llvm/ADT/Statistic.h>
 #include <llvm/Support/Debug.h>
+#include <llvm/Support/RandomNumberGenerator.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Transforms/Utils/Cloning.h>
-#include <list>
+#include <llvm/Transforms/Utils/CodeExtractor.h>
+#include <vector>
 #include <algorithm>
+#include <limits>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/IRBuilder.h>
+#include "ObfCompat.h"
+#include "ObfConfig.h"
+#include "ObfCost.h"
+#include "ObfFamilies.h"
+#include "ObfInstrument.h"
+#include "ObfOptions.h"
+#include "ObfPasses.h"
+#include "ObfTrace.h"
 
 #define DEBUG_TYPE "IPredO"
 
@@ -52,6 +66,9 @@ STATISTIC(InitNumBasicBlocks, "Initial numbers of basic blocks");
 STATISTIC(ModifedNumBasicBlocks, "Modified number of basic blocks");
 STATISTIC(AddedNumBasicBlocks, "Added number of basic blocks");
 STATISTIC(FinalNumBasicBlocks, "Final number of basic blocks");
+STATISTIC(PredicateCycles, "Estimated cycles of the inserted invariant predicates");
+STATISTIC(OutlinedNumBasicBlocks, "Number of decoy basic blocks outlined into cold functions");
+STATISTIC(GrowthBudgetStops, "Number of functions in which the growth budget skipped basic blocks");
 
 using namespace llvm;
 
@@ -59,65 +76,247 @@ static const int defaultObfRate = 100;
 static const int defaultObfTime = 1;
 
 static cl::opt<int>
-        ObfProbRate("ipred-prob",
+        ObfProbRate(IPredProbOption.Name,
                     cl::desc("Probability [%] each basic blocks will be obfuscated"),
                     cl::value_desc("probability rate"), cl::init(defaultObfRate), cl::Optional);
 
 static cl::opt<int>
-        ObfTimes("ipred-times", cl::desc("Times the to loop on a function"),
+        ObfTimes(IPredTimesOption.Name, cl::desc("Times the to loop on a function"),
                  cl::value_desc("number of times"), cl::init(defaultObfTime), cl::Optional);
 
+static cl::opt<unsigned>
+        ObfBudgetPercent(IPredBudgetOption.Name,
+                         cl::desc("Maximum estimated dynamic instruction increase per function in percent. "
+                                  "BasicBlocks are obfuscated coldest first (0 = unlimited)"),
+                         cl::value_desc("percent"), cl::init(0), cl::Optional);
+
+static cl::opt<unsigned>
+        ObfGrowthPercent("ipred-growth",
+                         cl::desc("Maximum number of instructions added to a function, in percent of its size. "
+                                  "BasicBlocks are obfuscated coldest and smallest first (0 = unlimited)"),
+                         cl::value_desc("percent"), cl::init(0), cl::Optional);
+
+static cl::opt<unsigned>
+        ObfMaxInsts("ipred-max-insts", cl::desc("Maximum number of instructions added to the module (0 = unlimited)"),
+                    cl::value_desc("instructions"), cl::init(0), cl::Optional);
+
+static cl::opt<unsigned>
+        ObfDecoyPool("ipred-decoy-pool",
+                     cl::desc("Number of decoy BasicBlocks per function shared by all never taken edges, instead of "
+                              "one clone of each obfuscated BasicBlock (0 = clones)"),
+                     cl::value_desc("decoys"), cl::init(0), cl::Optional);
+
+static cl::opt<bool>
+        ObfColdDecoys("ipred-cold-decoys",
+                      cl::desc("Outline the 'modified' BasicBlocks (or decoys) into cold functions placed in "
+                               ".text.unlikely, so that they do not dilute the hot code"),
+                      cl::init(false), cl::Optional);
+
+static cl::opt<RNGKind>
+        ObfRNG(IPredRNGOption.Name, cl::desc("Random numbers stored into 'x' by the obfuscated code"),
+               cl::values(clEnumValN(LibcRNG, "libc", "Call rand() of the C library (default)"),
+                          clEnumValN(XorShiftRNG, "xorshift",
+                                     "Inlined xorshift32 on a stack slot seeded at function entry (no call, "
+                                     "no lock, no shared state)")),
+               cl::init(LibcRNG), cl::Optional);
+
+enum StorageKind {
+    GlobalStorage,  // One global 'x' shared by all threads
+    TLSStorage,     // One thread_local 'x' per thread
+    FunctionStorage // One cache line sized global 'x.<function>' per function
+};
+
+static cl::opt<StorageKind>
+        ObfStorage("ipred-storage", cl::desc("Storage of the predicate state 'x'"),
+                   cl::values(clEnumValN(GlobalStorage, "global", "One global shared by all threads (default)"),
+                              clEnumValN(TLSStorage, "tls", "Thread-local global, no cache line is shared between "
+                                                           "threads"),
+                              clEnumValN(FunctionStorage, "function",
+                                         "Per-function slots, each padded to its own 64 byte cache line")),
+                   cl::init(GlobalStorage), cl::Optional);
+
+static cl::list<PredicateKind>
+        ObfPredicates(IPredPredicatesOption.Name, cl::CommaSeparated,
+                      cl::desc("Families of invariant predicates to choose from (default: all but parity and square)"),
+                      cl::values(clEnumValN(QR19Predicate, "qr19", "Quadratic residues modulo 19"),
+                                 clEnumValN(QR11Predicate, "qr11", "Quadratic residues modulo 11"),
+                                 clEnumValN(QR31Predicate, "qr31", "Quadratic residues modulo 31"),
+                                 clEnumValN(ParityPredicate, "parity", "x*(x+1) is even (multiply only)"),
+                                 clEnumValN(SquarePredicate, "square", "Squares are 0 or 1 modulo 4 (multiply only)"),
+                                 clEnumValN(BitwisePredicate, "bitwise", "(x|y) >= (x&y) (bitwise only)"),
+                                 clEnumValN(TablePredicate, "table",
+                                            "Load from a weak global table the optimizer cannot see through")));
+
+static cl::opt<SelectKind>
+        ObfSelect(IPredSelectOption.Name, cl::desc("How the family of each invariant predicate is chosen"),
+                  cl::values(clEnumValN(UniformSelect, "uniform", "Uniformly"),
+                             clEnumValN(CostSelect, "cost", "Favor cheap families, most of all in BasicBlocks "
+                                                            "executed more than once per call (default)")),
+                  cl::init(CostSelect), cl::Optional);
+
+static cl::opt<bool>
+        ObfInstrument("ipred-instrument",
+                      cl::desc("Count the executed invariant predicates and updates of 'x' by BasicBlock (link with "
+                               "libObfInstrRuntime.a)"),
+                      cl::init(false), cl::Optional);
+
+// Branch weights of the edges of an invariant predicate
+static const uint32_t TakenWeight = 1 << 20;
+static const uint32_t NeverTakenWeight = 1;
+
+// Instructions of one decoy BasicBlock (-ipred-decoy-pool)
+static const unsigned DecoyInsts = 6;
+
+// Estimated dynamic instructions added per execution of an obfuscated basic block besides its two invariant
+// predicates: two updates of 'x'
+static const unsigned UpdateCost = 6;
+
 namespace {
+    struct IPredO;
+
+    /// A family of invariant predicates on the predicate state 'x'
+    struct PredicateFamily {
+        const PredicateCost &Cost; // common/ObfFamilies.h
+        Value *(IPredO::*Build)(IRBuilder<> &Builder, Value *X, bool Negate); // Condition, true unless 'Negate'
+    };
+
     struct IPredO : public ModulePass {
         static char ID;
 
-        IPredO() : ModulePass(ID) {
-            srand(time(NULL));
+        std::unique_ptr<RandomNumberGenerator> RNG; // Seeded by -rng-seed, the module and the pass
+
+        DenseMap<Function *, AllocaInst *> RNGState; // xorshift32 state of each function (-ipred-rng=xorshift)
+
+        DenseMap<Function *, Constant *> PredState; // Predicate state of each function (-ipred-storage=function)
+
+        unsigned ModuleGrowth; // Instructions added to the module so far (-ipred-max-insts)
+
+        int ModuleProbRate; // -ipred-prob, or its default if out of range (the option is shared by all threads)
+        int ModuleTimes;    // -ipred-times, or its default if out of range
+
+        DenseMap<Function *, std::vector<BasicBlock *> > DecoyPool; // Decoys and their exit (-ipred-decoy-pool)
+
+        std::vector<BasicBlock *> Clones; // 'modified' BasicBlocks of the current function (-ipred-cold-decoys)
+
+        SmallPtrSet<BasicBlock *, 16> NeverExecuted; // Clones of the current function and BasicBlocks split off them
+
+        std::unique_ptr<ObfInstrumenter> Instr; // -ipred-instrument
+
+        FunctionAnalysisManager *FAM; // Cached analyses of the new pass manager, null under the legacy one
+
+        IPredO()
+            : ModulePass(ID), ModuleGrowth(0), ModuleProbRate(defaultObfRate), ModuleTimes(defaultObfTime),
+              FAM(nullptr) {
+        }
+
+        int nextRandom() {
+            return (*RNG)() & 0x7FFFFFFF;
         }
 
         bool obfuscateCFG(Function &F);
 
-        bool insertIPred(BasicBlock *BB);
+        bool insertIPred(BasicBlock *BB, const PredicateFamily &P1, const PredicateFamily &P2, ObfBudget *FBudget);
+
+        Value *insertIPredAndCondBefore(Instruction *I, const PredicateFamily &P, bool Negate);
+
+        const PredicateFamily &selectPredicate(bool Hot);
+
+        Value *buildQR19(IRBuilder<> &Builder, Value *X, bool Negate);
+
+        Value *buildQR11(IRBuilder<> &Builder, Value *X, bool Negate);
+
+        Value *buildQR31(IRBuilder<> &Builder, Value *X, bool Negate);
+
+        Value *buildParity(IRBuilder<> &Builder, Value *X, bool Negate);
+
+        Value *buildSquare(IRBuilder<> &Builder, Value *X, bool Negate);
+
+        Value *buildBitwise(IRBuilder<> &Builder, Value *X, bool Negate);
+
+        Value *buildTable(IRBuilder<> &Builder, Value *X, bool Negate);
+
+        GlobalVariable *getPredicateTable(Module &M);
 
-        Value *insertIPredAndCondBefore(Instruction *I, bool Negate);
+        bool updateGlobalVariable(BasicBlock *BB);
 
-        void updateGlobalVariable(BasicBlock *BB);
+        Value *createRandomValue(IRBuilder<> &Builder);
+
+        AllocaInst *getRNGState(Function &F);
+
+        Value *getPredicateState(Function &F);
 
         BasicBlock *createModifiedBasicBlock(BasicBlock *BB);
 
+        BasicBlock *getDecoy(Function &F);
+
+        bool isDecoy(BasicBlock *BB);
+
+        void outlineColdBlocks(Function &F, ArrayRef<BasicBlock *> Blocks);
+
         virtual bool runOnModule(Module &M) {
+            ObfTraceScope Scope("ipredO", M);
 
             bool modified = false;
 
-            if (ObfProbRate < 0 || ObfProbRate > 100) {
+            RNG = createObfRNG(M, this);
+
+            ModuleProbRate = ObfProbRate;
+            ModuleTimes = ObfTimes;
+
+            if (ModuleProbRate < 0 || ModuleProbRate > 100) {
                 M.getContext().emitError("-ipred-prob=p must be 0 <= p <= 100\n");
                 M.getContext().emitError("Setting -ipred-prob to default value\n");
-                ObfProbRate = defaultObfRate;
+                ModuleProbRate = defaultObfRate;
             }
 
-            if (ObfTimes <= 0) {
+            if (ModuleTimes <= 0) {
                 M.getContext().emitError("-ipred-times=n must be n > 0\n");
-                M.getContext().emitError("Setting -pred-times to default value\n");
-                ObfTimes = defaultObfTime;
+                M.getContext().emitError("Setting -ipred-times to default value\n");
+                ModuleTimes = defaultObfTime;
             }
 
-            std::vector<Type *> Args;
-            FunctionType *FType = FunctionType::get(Type::getInt32Ty(M.getContext()), Args, false);
-            M.getOrInsertFunction("rand", FType);
+            if (ObfRNG == LibcRNG) {
+                std::vector<Type *> Args;
+                FunctionType *FType = FunctionType::get(Type::getInt32Ty(M.getContext()), Args, false);
+                M.getOrInsertFunction("rand", FType);
+            }
+
+            RNGState.clear();
+            PredState.clear();
+            DecoyPool.clear();
+            ModuleGrowth = 0;
+
+            if (ObfStorage != FunctionStorage) {
+                M.getOrInsertGlobal("x", Type::getInt32Ty(M.getContext()));
+                GlobalVariable *GVar = M.getNamedGlobal("x");
 
-            M.getOrInsertGlobal("x", Type::getInt32Ty(M.getContext()));
-            GlobalVariable *GVar = M.getNamedGlobal("x");
+                if (!GVar) {
+                    M.getContext().emitError("Could not insert global variable into module\n");
+                    return false;
+                }
 
-            if (!GVar) {
-                M.getContext().emitError("Could not insert global variable into module\n");
-                return false;
+                GVar->setInitializer(ConstantInt::get(Type::getInt32Ty(M.getContext()), nextRandom() % 100));
+                GVar->setLinkage(GlobalValue::InternalLinkage);
+                GVar->setThreadLocal(ObfStorage == TLSStorage);
             }
 
-            GVar->setInitializer(ConstantInt::get(Type::getInt32Ty(M.getContext()), rand() % 100));
-            GVar->setLinkage(GlobalValue::InternalLinkage);
+            if (ObfInstrument) {
+                Instr.reset(new ObfInstrumenter(M, "ipredO"));
+            }
 
+            // -ipred-cold-decoys adds the outlined functions to 'M', which are not obfuscated again
+            std::vector<Function *> Functions;
             for (auto &F : M) {
-                modified |= obfuscateCFG(F);
+                Functions.push_back(&F);
+            }
+
+            for (Function *F : Functions) {
+                modified |= obfuscateCFG(*F);
+            }
+
+            if (Instr) {
+                modified |= Instr->finish();
+                Instr.reset();
             }
 
             return modified;
@@ -125,32 +324,138 @@ namespace {
     };
 }
 
+// Indexed by PredicateKind
+static const PredicateFamily Predicates[] = {
+        {PredicateCosts[QR19Predicate],    &IPredO::buildQR19},
+        {PredicateCosts[QR11Predicate],    &IPredO::buildQR11},
+        {PredicateCosts[QR31Predicate],    &IPredO::buildQR31},
+        {PredicateCosts[ParityPredicate],  &IPredO::buildParity},
+        {PredicateCosts[SquarePredicate],  &IPredO::buildSquare},
+        {PredicateCosts[BitwisePredicate], &IPredO::buildBitwise},
+        {PredicateCosts[TablePredicate],   &IPredO::buildTable},
+};
+
 bool IPredO::obfuscateCFG(Function &F) {
+    if (!getObfConfig().isEnabled("ipredO", F)) {
+        return false;
+    }
+
+    ObfTraceScope Scope("ipredO", F);
+
     bool modified = false;
 
+    // The configuration (llvm-obf -obf-config) may set the probability and the rounds of each function
+    int ProbRate = getObfConfig().get(F, "ipred-prob", ModuleProbRate);
+    int Times = getObfConfig().get(F, "ipred-times", ModuleTimes);
+
+    if (ProbRate < 0 || ProbRate > 100 || Times <= 0) {
+        F.getContext().emitError("ipred-prob=p and ipred-times=n of " + F.getName() +
+                                 " must be 0 <= p <= 100 and n > 0\n");
+        ProbRate = ModuleProbRate;
+        Times = ModuleTimes;
+    }
+
     DEBUG_WITH_TYPE("opt", errs() << "Obfuscating Function: " << F.getName() << "\n"); // -debug-only=opt,cfg
-    DEBUG_WITH_TYPE("opt", errs() << "Probability rate: " << ObfProbRate << "\n");
-    DEBUG_WITH_TYPE("opt", errs() << "Times: " << ObfTimes << "\n");
+    DEBUG_WITH_TYPE("opt", errs() << "Probability rate: " << ProbRate << "\n");
+    DEBUG_WITH_TYPE("opt", errs() << "Times: " << Times << "\n");
 
     int BBCount = std::distance(F.begin(), F.end());
     InitNumBasicBlocks += BBCount;
     FinalNumBasicBlocks += BBCount;
 
-    for (int i = 0; i < ObfTimes; ++i) {
+    if (ObfRNG == XorShiftRNG && !F.isDeclaration()) {
+        getRNGState(F);
+    }
+
+    // Counters are labeled with the BasicBlocks of the original CFG
+    if (Instr && !F.isDeclaration()) {
+        Instr->addFunction(F);
+    }
+
+    // -ipred-times reruns over the BasicBlocks added by the previous rounds, so without a growth budget the code
+    // size grows geometrically
+    bool GrowthLimited = ObfGrowthPercent > 0 || ObfMaxInsts > 0;
+    unsigned GrowthLimit = std::numeric_limits<unsigned>::max();
+    unsigned Growth = 0;
+    bool Stopped = false;
+
+    if (ObfGrowthPercent > 0) {
+        unsigned FuncInsts = 0;
+        for (auto &BB : F) {
+            FuncInsts += BB.size();
+        }
+        GrowthLimit = FuncInsts * ObfGrowthPercent / 100;
+    }
+
+    // The budget also provides the frequencies for -ipred-select=cost and the growth budget
+    std::unique_ptr<ObfBudget> FBudget;
+    if ((ObfBudgetPercent > 0 || ObfSelect == CostSelect || GrowthLimited) && !F.isDeclaration()) {
+        FBudget.reset(new ObfBudget(F, ObfBudgetPercent, FAM));
+    }
+
+    for (int i = 0; i < Times; ++i) {
         // Must copy original basic blocks, since iterator becomes invalidated.
-        std::list<BasicBlock *> BasicBlocks;
+        std::vector<BasicBlock *> BasicBlocks;
         for (auto &BB : F) {
             BasicBlocks.push_back(&BB);
         }
 
+        if (GrowthLimited) {
+            // Small BasicBlocks first among equally cold ones, so that the growth budget covers as many as possible
+            std::stable_sort(BasicBlocks.begin(), BasicBlocks.end(), [](BasicBlock *A, BasicBlock *B) {
+                return A->size() < B->size();
+            });
+        }
+
+        if (FBudget && (ObfBudgetPercent > 0 || GrowthLimited)) {
+            FBudget->sortColdestFirst(BasicBlocks);
+
+            // The clones of the previous rounds have no frequency and would take the growth budget before any
+            // executed BasicBlock
+            std::stable_partition(BasicBlocks.begin(), BasicBlocks.end(), [this](BasicBlock *BB) {
+                return !NeverExecuted.count(BB);
+            });
+        }
+
         for (auto &BB : BasicBlocks) {
-            int p = rand() % 100 + 1;
-            if (ObfProbRate >= p) {
-                DEBUG_WITH_TYPE("opt", errs() << "Obfuscating BasicBlock: " << BB->getName() << "\n");
-                if (insertIPred(BB)) {
+            if (isDecoy(BB)) {
+                continue;
+            }
+
+            int p = nextRandom() % 100 + 1;
+            if (ProbRate >= p) {
+                bool Hot = FBudget && FBudget->getFrequency(BB) > 1;
+                const PredicateFamily &P1 = selectPredicate(Hot);
+                const PredicateFamily &P2 = selectPredicate(Hot);
+
+                // The 'modified' clone of 'BB' and its update of 'x' (or the decoy pool, once), two updates of 'x'
+                // and two predicates
+                unsigned Insts = UpdateCost + P1.Cost.Insts + P2.Cost.Insts;
+                if (ObfDecoyPool == 0) {
+                    Insts += BB->size() + 3;
+                } else if (!DecoyPool.count(&F)) {
+                    Insts += ObfDecoyPool * DecoyInsts + 3;
+                }
+
+                if (Growth + Insts > GrowthLimit || (ObfMaxInsts > 0 && ModuleGrowth + Insts > ObfMaxInsts)) {
+                    DEBUG_WITH_TYPE("opt", errs() << "Over growth budget: " << BB->getName() << "\n");
+                    Stopped = true;
+                    continue;
+                }
+
+                if (ObfBudgetPercent > 0 && !FBudget->spend(BB, UpdateCost + P1.Cost.Insts + P2.Cost.Insts)) {
+                    DEBUG_WITH_TYPE("opt", errs() << "Over budget: " << BB->getName() << "\n");
+                    continue;
+                }
+                DEBUG_WITH_TYPE("opt", errs() << "Obfuscating BasicBlock: " << BB->getName() << " (" << P1.Cost.Name
+                                              << ", " << P2.Cost.Name << ")\n");
+                if (insertIPred(BB, P1, P2, FBudget.get())) {
+                    PredicateCycles += P1.Cost.Latency + P2.Cost.Latency;
+                    Growth += Insts;
+                    ModuleGrowth += Insts;
                     ModifedNumBasicBlocks += 1;
-                    AddedNumBasicBlocks += 3;
-                    FinalNumBasicBlocks += 3;
+                    AddedNumBasicBlocks += ObfDecoyPool ? 2 : 3;
+                    FinalNumBasicBlocks += ObfDecoyPool ? 2 : 3;
                     modified = true;
                 }
             } else {
@@ -158,20 +463,71 @@ bool IPredO::obfuscateCFG(Function &F) {
             }
         }
     }
+    if (modified && ObfColdDecoys) {
+        if (ObfDecoyPool) {
+            // The exit of the pool returns from 'F' and stays
+            std::vector<BasicBlock *> &Pool = DecoyPool[&F];
+            outlineColdBlocks(F, ArrayRef<BasicBlock *>(Pool).drop_back());
+        } else {
+            outlineColdBlocks(F, Clones);
+        }
+    }
+    Clones.clear();
+    NeverExecuted.clear();
+
+    if (Stopped) {
+        GrowthBudgetStops += 1;
+        DEBUG_WITH_TYPE("opt", errs() << "Growth budget exhausted: " << Growth << " instructions added to "
+                                      << F.getName() << ", " << ModuleGrowth << " to the module\n");
+    }
+
     if (modified) {
         DEBUG_WITH_TYPE("cfg", errs() << "Function " << F.getName() << " has been modified\n");
         DEBUG_WITH_TYPE("cfg", F.viewCFG());
     } else {
         DEBUG_WITH_TYPE("cfg", errs() << "Function " << F.getName() << " has not been modified\n");
     }
+
+    if (ObfBudgetPercent > 0 && FBudget) { // None for declarations
+        FBudget->report("ipredO", F, errs());
+    }
+
     return modified;
 }
 
-bool IPredO::insertIPred(BasicBlock *BB) {
+/// Branch at the end of 'InsertAtEnd' to 'Taken' if 'Cond' is true (false if 'Negate') and to 'Never' otherwise.
+/// The branch weights tell block placement and the branch predictor that 'Never' is not taken, so the obfuscated
+/// code is laid out like the original and the decoys are moved out of the way
+static BranchInst *createOpaqueBranch(BasicBlock *Taken, BasicBlock *Never, Value *Cond, bool Negate,
+                                      BasicBlock *InsertAtEnd) {
+    MDBuilder MDB(InsertAtEnd->getContext());
+    BranchInst *Br;
+
+    if (!Negate) {
+        Br = BranchInst::Create(Taken, Never, Cond, InsertAtEnd);
+        Br->setMetadata(LLVMContext::MD_prof, MDB.createBranchWeights(TakenWeight, NeverTakenWeight));
+    } else {
+        Br = BranchInst::Create(Never, Taken, Cond, InsertAtEnd);
+        Br->setMetadata(LLVMContext::MD_prof, MDB.createBranchWeights(NeverTakenWeight, TakenWeight));
+    }
+
+    return Br;
+}
+
+/// Insert invariant predicates of the families 'P1' and 'P2' into 'BB'. The BasicBlocks split off 'BB' execute
+/// as often as 'BB', which 'FBudget' (if any) is told about
+bool IPredO::insertIPred(BasicBlock *BB, const PredicateFamily &P1, const PredicateFamily &P2,
+                         ObfBudget *FBudget) {
     Value* CmpRes;
     bool Negate;
     Instruction *SplitPoint = BB->getFirstNonPHIOrDbgOrLifetime();
 
+    // The xorshift state and its seeding stay in the 'entry' BasicBlock, which dominates all their uses
+    AllocaInst *State = RNGState.lookup(BB->getParent());
+    if (State && SplitPoint == State) {
+        SplitPoint = State->getNextNode()->getNextNode();
+    }
+
     if (SplitPoint == BB->getTerminator()) {
         return false;
     }
@@ -179,42 +535,59 @@ bool IPredO::insertIPred(BasicBlock *BB) {
     // The 'original' BasicBlock contains every instruction, except phi nodes and metadata
     BasicBlock *orgBBStart = BB->splitBasicBlock(SplitPoint, "orgBBStart");
 
-    // Create a 'modified' BasicBlock based on the 'original' BasicBlock (control will never reach this block)
-    BasicBlock *modifiedBB = createModifiedBasicBlock(orgBBStart);
+    // Create a 'modified' BasicBlock based on the 'original' BasicBlock, or take one of the shared decoys (control
+    // will never reach this block)
+    BasicBlock *modifiedBB = ObfDecoyPool ? getDecoy(*BB->getParent()) : createModifiedBasicBlock(orgBBStart);
 
     // Modify global variable 'x' to obfuscate control flow
-    updateGlobalVariable(BB);
-    updateGlobalVariable(orgBBStart);
+    unsigned Updates = updateGlobalVariable(BB);
+    Updates += updateGlobalVariable(orgBBStart);
+
+    // Both predicates and updates run on every execution of 'BB', so they are counted together in 'BB'
+    if (Instr) {
+        Instr->count("predicate", BB, &BB->back(), 2);
+        if (Updates) {
+            Instr->count("update", BB, &BB->back(), Updates);
+        }
+    }
 
     // Create invariant predicate with associated condition
-    Negate = rand() & 0x01;
-    CmpRes = insertIPredAndCondBefore(&BB->back(), Negate);
+    Negate = nextRandom() & 0x01;
+    CmpRes = insertIPredAndCondBefore(&BB->back(), P1, Negate);
 
-    // Erase old terminators to insert new ones
+    // Erase old terminator to insert a new one
     BB->getTerminator()->eraseFromParent();
-    modifiedBB->getTerminator()->eraseFromParent();
 
     // Branch to 'original' BasicBlock
-    if (!Negate) {
-        BranchInst::Create(orgBBStart, modifiedBB, CmpRes, BB);
-    } else {
-        BranchInst::Create(modifiedBB, orgBBStart, CmpRes, BB);
+    createOpaqueBranch(orgBBStart, modifiedBB, CmpRes, Negate, BB);
+
+    // The 'modified' BasicBlock branch to 'original' BasicBlock. Decoys keep their branches, they are reached from
+    // many BasicBlocks, so 'orgBBStart' would no longer be dominated by 'BB'
+    if (!ObfDecoyPool) {
+        modifiedBB->getTerminator()->eraseFromParent();
+        BranchInst::Create(orgBBStart, modifiedBB);
+        Clones.push_back(modifiedBB);
+        NeverExecuted.insert(modifiedBB);
     }
 
-    // The 'modified' BasicBlock branch to 'original' BasicBlock
-    BranchInst::Create(orgBBStart, modifiedBB);
-
     // The 'original' BasicBlock may branch to 'modified' BasicBlock (control will never flow on this edge)
     BasicBlock *orgBBEnd = orgBBStart->splitBasicBlock(--orgBBStart->end(), "orgBBEnd");
-    Negate = rand() & 0x01;
-    CmpRes = insertIPredAndCondBefore(&orgBBStart->back(), Negate);
+    Negate = nextRandom() & 0x01;
+    CmpRes = insertIPredAndCondBefore(&orgBBStart->back(), P2, Negate);
     orgBBStart->getTerminator()->eraseFromParent();
 
-    if (!Negate) {
-        BranchInst::Create(orgBBEnd, modifiedBB, CmpRes, orgBBStart);
-    } else {
-        BranchInst::Create(modifiedBB, orgBBEnd, CmpRes, orgBBStart);
+    createOpaqueBranch(orgBBEnd, modifiedBB, CmpRes, Negate, orgBBStart);
+
+    if (FBudget) {
+        FBudget->setFrequency(orgBBStart, FBudget->getFrequency(BB));
+        FBudget->setFrequency(orgBBEnd, FBudget->getFrequency(BB));
+    }
+
+    if (NeverExecuted.count(BB)) {
+        NeverExecuted.insert(orgBBStart);
+        NeverExecuted.insert(orgBBEnd);
     }
+
     return true;
 }
 
@@ -243,14 +616,10 @@ BasicBlock *IPredO::createModifiedBasicBlock(BasicBlock *BB) {
     }
 
     BasicBlock::iterator It = modifiedBB->begin();
-    int InsertPos = rand() % std::distance(It, modifiedBB->end());
+    int InsertPos = nextRandom() % std::distance(It, modifiedBB->end());
     std::advance(It, InsertPos);
 
-    GlobalVariable *GVar = modifiedBB->getModule()->getNamedGlobal("x");
-
-    if (!GVar) {
-        BB->getContext().emitError("Could not find global variable in module\n");
-    }
+    Value *GVar = getPredicateState(*BB->getParent());
 
     IRBuilder<> Builder(&*It);
     // Increment global variable 'x' to look like a loop
@@ -262,122 +631,370 @@ BasicBlock *IPredO::createModifiedBasicBlock(BasicBlock *BB) {
 
 
 
-Value *IPredO::insertIPredAndCondBefore(Instruction *I, bool Negate) {
-    Value *V, *LHS, *RHS, *Res;
-    GlobalVariable *GVar = I->getModule()->getNamedGlobal("x"); // Wrapper around getGlobalVariable("x", true)
+/// A random decoy of 'F' (-ipred-decoy-pool), the pool is created on first use. A decoy is reached from many
+/// BasicBlocks, so it only uses values available everywhere in 'F': arguments, constants and 'x'. The decoys form
+/// a ring, each one updates 'x' and branches to the next decoy or to an exit that returns
+BasicBlock *IPredO::getDecoy(Function &F) {
+    std::vector<BasicBlock *> &Pool = DecoyPool[&F];
 
-    if (!GVar) {
-        I->getContext().emitError("Could not find global variable in module\n");
-        exit(1);
-    }
+    if (Pool.empty()) {
+        LLVMContext &Ctx = F.getContext();
+        Type *Int32Ty = Type::getInt32Ty(Ctx);
+        Value *GVar = getPredicateState(F);
 
-    IRBuilder<> Builder(I);
+        std::vector<Argument *> Args;
+        for (Argument &Arg : F.args()) {
+            if (Arg.getType()->isIntegerTy()) {
+                Args.push_back(&Arg);
+            }
+        }
 
-    switch (rand() % 3) {
-        case 0:
-            V = Builder.CreateURem(Builder.CreateLoad(Type::getInt32Ty(I->getContext()), GVar),
-                                   ConstantInt::get(Type::getInt32Ty(I->getContext()),
-                                                    19)); // GVar has type i32*
+        for (unsigned I = 0; I < ObfDecoyPool; ++I) {
+            Pool.push_back(BasicBlock::Create(Ctx, "decoy", &F));
+        }
+        BasicBlock *Exit = BasicBlock::Create(Ctx, "decoy.exit", &F);
 
-            LHS = Builder.CreateURem(Builder.CreateAdd(
-                    Builder.CreateMul(ConstantInt::get(Type::getInt32Ty(I->getContext()), 4), Builder.CreateMul(V, V)),
-                    ConstantInt::get(Type::getInt32Ty(I->getContext()), 4)),
-                                     ConstantInt::get(Type::getInt32Ty(I->getContext()), 19));
+        for (unsigned I = 0; I < ObfDecoyPool; ++I) {
+            IRBuilder<> Builder(Pool[I]);
+            Value *Operand = Builder.getInt32(nextRandom() % 100 + 1);
 
-            RHS = ConstantInt::get(Type::getInt32Ty(I->getContext()), 0);
-            break;
-        case 1:
-            V = Builder.CreateURem(Builder.CreateLoad(Type::getInt32Ty(I->getContext()), GVar),
-                                   ConstantInt::get(Type::getInt32Ty(I->getContext()),
-                                                    11)); // GVar has type i32*
+            if (!Args.empty() && (nextRandom() & 0x01)) {
+                Operand = Builder.CreateZExtOrTrunc(Args[nextRandom() % Args.size()], Int32Ty);
+            }
 
-            LHS = Builder.CreateURem(Builder.CreateAdd(Builder.CreateAdd(
-                    Builder.CreateMul(V, V),
-                    Builder.CreateMul(ConstantInt::get(Type::getInt32Ty(I->getContext()), 4),V)), ConstantInt::get(Type::getInt32Ty(I->getContext()), 5)),
-                                     ConstantInt::get(Type::getInt32Ty(I->getContext()), 11));
+            Value *V = Builder.CreateLoad(Int32Ty, GVar);
+
+            switch (nextRandom() % 4) {
+                case 0:
+                    V = Builder.CreateAdd(V, Operand);
+                    break;
+                case 1:
+                    V = Builder.CreateSub(V, Operand);
+                    break;
+                case 2:
+                    V = Builder.CreateXor(V, Operand);
+                    break;
+                default:
+                    V = Builder.CreateMul(V, Operand);
+                    break;
+            }
 
-            RHS = ConstantInt::get(Type::getInt32Ty(I->getContext()), 0);
-            break;
-        case 2:
-            V = Builder.CreateURem(Builder.CreateLoad(Type::getInt32Ty(I->getContext()), GVar),
-                                   ConstantInt::get(Type::getInt32Ty(I->getContext()),
-                                                    31)); // GVar has type i32*
+            Builder.CreateStore(V, GVar);
+            Builder.CreateCondBr(Builder.CreateICmpULT(V, Builder.getInt32(nextRandom() % 100)),
+                                 Pool[(I + 1) % ObfDecoyPool], Exit);
+        }
 
-            LHS = Builder.CreateURem(Builder.CreateAdd(Builder.CreateAdd(
-                    Builder.CreateMul(ConstantInt::get(Type::getInt32Ty(I->getContext()), 5), Builder.CreateMul(V, V)),
-                    Builder.CreateMul(ConstantInt::get(Type::getInt32Ty(I->getContext()), 6),V)), ConstantInt::get(Type::getInt32Ty(I->getContext()), 2)),
-                                     ConstantInt::get(Type::getInt32Ty(I->getContext()), 31));
+        IRBuilder<> Builder(Exit);
+        Type *RetTy = F.getReturnType();
 
-            RHS = ConstantInt::get(Type::getInt32Ty(I->getContext()), 0);
-            break;
-        default:
-            break;
+        if (RetTy->isVoidTy()) {
+            Builder.CreateRetVoid();
+        } else if (RetTy->isIntegerTy()) {
+            Builder.CreateRet(Builder.CreateZExtOrTrunc(Builder.CreateLoad(Int32Ty, GVar), RetTy));
+        } else {
+            Builder.CreateRet(Constant::getNullValue(RetTy));
+        }
+
+        Pool.push_back(Exit);
+
+        AddedNumBasicBlocks += Pool.size();
+        FinalNumBasicBlocks += Pool.size();
     }
 
-    if (!Negate) {
-        Res = Builder.CreateICmp(CmpInst::ICMP_NE, LHS, RHS);
-    } else {
-        Res = Builder.CreateICmp(CmpInst::ICMP_EQ, LHS, RHS);
+    return Pool[nextRandom() % ObfDecoyPool];
+}
+
+/// Whether 'BB' belongs to the decoy pool of its function, which is not obfuscated itself
+bool IPredO::isDecoy(BasicBlock *BB) {
+    auto It = DecoyPool.find(BB->getParent());
+
+    return It != DecoyPool.end() && std::find(It->second.begin(), It->second.end(), BB) != It->second.end();
+}
+
+/// Move each of 'Blocks' of 'F' into a function of its own, which is cold, never inlined and placed in
+/// .text.unlikely. Only a call remains in 'F'. BasicBlocks the CodeExtractor cannot move (e.g. with allocas) stay
+void IPredO::outlineColdBlocks(Function &F, ArrayRef<BasicBlock *> Blocks) {
+    for (BasicBlock *Block : Blocks) {
+        CodeExtractor CE(Block);
+
+        if (!CE.isEligible()) {
+            continue;
+        }
+
+#if LLVM_VERSION_MAJOR >= 10
+        CodeExtractorAnalysisCache CEAC(F);
+        Function *Cold = CE.extractCodeRegion(CEAC);
+#else
+        Function *Cold = CE.extractCodeRegion();
+#endif
+
+        if (!Cold) {
+            continue;
+        }
+
+        Cold->addFnAttr(Attribute::Cold);
+        Cold->addFnAttr(Attribute::NoInline);
+        Cold->addFnAttr(Attribute::OptimizeForSize);
+        Cold->setSectionPrefix(".unlikely");
+        OutlinedNumBasicBlocks += 1;
     }
+}
 
-    return Res;
+Value *IPredO::insertIPredAndCondBefore(Instruction *I, const PredicateFamily &P, bool Negate) {
+    Value *GVar = getPredicateState(*I->getFunction());
+
+    IRBuilder<> Builder(I);
+    Value *X = Builder.CreateLoad(Type::getInt32Ty(I->getContext()), GVar); // GVar has type i32*
+
+    return (this->*P.Build)(Builder, X, Negate);
 }
 
-void IPredO::updateGlobalVariable(BasicBlock *BB) {
-    Function *F = BB->getModule()->getFunction("rand");
+/// Choose the family of the next invariant predicate among -ipred-predicates
+const PredicateFamily &IPredO::selectPredicate(bool Hot) {
+    std::vector<PredicateKind> Kinds =
+            getPredicateKinds(std::vector<PredicateKind>(ObfPredicates.begin(), ObfPredicates.end()));
+    std::vector<unsigned> Weights;
+    unsigned Total = 0;
+
+    for (PredicateKind K : Kinds) {
+        Weights.push_back(getPredicateWeight(K, ObfSelect, Hot));
+        Total += Weights.back();
+    }
+
+    unsigned R = nextRandom() % Total;
+    unsigned Idx = 0;
 
-    if (!F) {
-        BB->getContext().emitError("Could not find function in module.");
-        exit(1);
+    while (R >= Weights[Idx]) {
+        R -= Weights[Idx++];
     }
 
-    GlobalVariable *GVar = BB->getModule()->getNamedGlobal("x");
+    return Predicates[Kinds[Idx]];
+}
+
+/// Compare with 'Pred', or with the inverse of 'Pred' if 'Negate'
+static Value *createCond(IRBuilder<> &Builder, CmpInst::Predicate Pred, Value *LHS, Value *RHS, bool Negate) {
+    return Builder.CreateICmp(Negate ? CmpInst::getInversePredicate(Pred) : Pred, LHS, RHS);
+}
+
+/// -1 is no quadratic residue modulo 19, so 4*v*v + 4 = 4*(v*v + 1) is never divisible by 19
+Value *IPredO::buildQR19(IRBuilder<> &Builder, Value *X, bool Negate) {
+    Value *V = Builder.CreateURem(X, Builder.getInt32(19));
+    Value *LHS = Builder.CreateURem(Builder.CreateAdd(Builder.CreateMul(Builder.getInt32(4), Builder.CreateMul(V, V)),
+                                                      Builder.getInt32(4)),
+                                    Builder.getInt32(19));
+
+    return createCond(Builder, CmpInst::ICMP_NE, LHS, Builder.getInt32(0), Negate);
+}
+
+/// v*v + 4*v + 5 = (v + 2)^2 + 1 and -1 is no quadratic residue modulo 11
+Value *IPredO::buildQR11(IRBuilder<> &Builder, Value *X, bool Negate) {
+    Value *V = Builder.CreateURem(X, Builder.getInt32(11));
+    Value *LHS = Builder.CreateURem(
+            Builder.CreateAdd(Builder.CreateAdd(Builder.CreateMul(V, V), Builder.CreateMul(Builder.getInt32(4), V)),
+                              Builder.getInt32(5)),
+            Builder.getInt32(11));
+
+    return createCond(Builder, CmpInst::ICMP_NE, LHS, Builder.getInt32(0), Negate);
+}
+
+/// The discriminant 6*6 - 4*5*2 = -4 is no quadratic residue modulo 31, so 5*v*v + 6*v + 2 has no root
+Value *IPredO::buildQR31(IRBuilder<> &Builder, Value *X, bool Negate) {
+    Value *V = Builder.CreateURem(X, Builder.getInt32(31));
+    Value *LHS = Builder.CreateURem(
+            Builder.CreateAdd(Builder.CreateAdd(Builder.CreateMul(Builder.getInt32(5), Builder.CreateMul(V, V)),
+                                                Builder.CreateMul(Builder.getInt32(6), V)),
+                              Builder.getInt32(2)),
+            Builder.getInt32(31));
+
+    return createCond(Builder, CmpInst::ICMP_NE, LHS, Builder.getInt32(0), Negate);
+}
+
+/// One of two consecutive integers is even, also modulo 2^32
+Value *IPredO::buildParity(IRBuilder<> &Builder, Value *X, bool Negate) {
+    Value *Product = Builder.CreateMul(X, Builder.CreateAdd(X, Builder.getInt32(1)));
+
+    return createCond(Builder, CmpInst::ICMP_EQ, Builder.CreateAnd(Product, Builder.getInt32(1)),
+                      Builder.getInt32(0), Negate);
+}
+
+/// Squares are 0 or 1 modulo 4, also modulo 2^32
+Value *IPredO::buildSquare(IRBuilder<> &Builder, Value *X, bool Negate) {
+    Value *Square = Builder.CreateMul(X, X);
+
+    return createCond(Builder, CmpInst::ICMP_ULT, Builder.CreateAnd(Square, Builder.getInt32(3)),
+                      Builder.getInt32(2), Negate);
+}
+
+/// Every bit set in x&y is set in x|y
+Value *IPredO::buildBitwise(IRBuilder<> &Builder, Value *X, bool Negate) {
+    Value *Y = Builder.CreateAdd(X, Builder.getInt32(nextRandom()));
+
+    return createCond(Builder, CmpInst::ICMP_UGE, Builder.CreateOr(X, Y), Builder.CreateAnd(X, Y), Negate);
+}
+
+/// Every element of the predicate table is even
+Value *IPredO::buildTable(IRBuilder<> &Builder, Value *X, bool Negate) {
+    GlobalVariable *Table = getPredicateTable(*Builder.GetInsertBlock()->getModule());
+    Value *Idx = Builder.CreateAnd(X, Builder.getInt32(15));
+    Value *Element = Builder.CreateLoad(Builder.getInt32Ty(),
+                                        Builder.CreateInBoundsGEP(Table->getValueType(), Table,
+                                                                  {Builder.getInt32(0), Idx}));
+
+    return createCond(Builder, CmpInst::ICMP_EQ, Builder.CreateAnd(Element, Builder.getInt32(1)),
+                      Builder.getInt32(0), Negate);
+}
+
+/// The [16 x i32] table of even numbers read by the 'table' predicates. It is weak, so the optimizer cannot
+/// assume its initializer, since another definition may replace it at link time. Modules obfuscated separately
+/// each define it, the linker keeps one and all of them only contain even numbers
+GlobalVariable *IPredO::getPredicateTable(Module &M) {
+    GlobalVariable *Table = M.getNamedGlobal("x.table");
 
-    if (!GVar) {
-        BB->getContext().emitError("Could not find global variable in module.");
-        exit(1);
+    if (!Table) {
+        Type *Int32Ty = Type::getInt32Ty(M.getContext());
+        ArrayType *TableTy = ArrayType::get(Int32Ty, 16);
+        std::vector<Constant *> Init;
+
+        for (unsigned I = 0; I < 16; ++I) {
+            Init.push_back(ConstantInt::get(Int32Ty, (nextRandom() % 1000) * 2));
+        }
+
+        Table = new GlobalVariable(M, TableTy, false, GlobalValue::WeakAnyLinkage, ConstantArray::get(TableTy, Init),
+                                   "x.table");
     }
 
+    return Table;
+}
+
+/// Insert a random update of 'x' at the end of 'BB'. False if the update chosen is to leave 'x' unchanged
+bool IPredO::updateGlobalVariable(BasicBlock *BB) {
+    Value *GVar = getPredicateState(*BB->getParent());
+
     IRBuilder<> Builder(&BB->back());
 
-    switch (rand() % 7) {
+    switch (nextRandom() % 7) {
         case 0:
-            Builder.CreateStore(Builder.CreateURem(Builder.CreateCall(F),
+            Builder.CreateStore(Builder.CreateURem(createRandomValue(Builder),
                                                    ConstantInt::get(Type::getInt32Ty(BB->getContext()), 10)), GVar);
             break;
         case 1:
             Builder.CreateStore(Builder.CreateAdd(Builder.CreateLoad(Type::getInt32Ty(BB->getContext()), GVar),
-                                                  ConstantInt::get(Type::getInt32Ty(BB->getContext()), rand() % 10)),
+                                                  ConstantInt::get(Type::getInt32Ty(BB->getContext()), nextRandom() % 10)),
                                 GVar);
             break;
         case 2:
             Builder.CreateStore(Builder.CreateSub(Builder.CreateLoad(Type::getInt32Ty(BB->getContext()), GVar),
-                                                  ConstantInt::get(Type::getInt32Ty(BB->getContext()), rand() % 10)),
+                                                  ConstantInt::get(Type::getInt32Ty(BB->getContext()), nextRandom() % 10)),
                                 GVar);
             break;
         case 3:
             Builder.CreateStore(Builder.CreateMul(Builder.CreateLoad(Type::getInt32Ty(BB->getContext()), GVar),
-                                                  ConstantInt::get(Type::getInt32Ty(BB->getContext()), rand() % 10)),
+                                                  ConstantInt::get(Type::getInt32Ty(BB->getContext()), nextRandom() % 10)),
                                 GVar);
             break;
         case 4:
             Builder.CreateStore(Builder.CreateShl(Builder.CreateLoad(Type::getInt32Ty(BB->getContext()), GVar),
                                                   ConstantInt::get(Type::getInt32Ty(BB->getContext()),
-                                                                   (rand() % 3) + 1)),
+                                                                   (nextRandom() % 3) + 1)),
                                 GVar);
             break;
         case 5:
             Builder.CreateStore(Builder.CreateXor(Builder.CreateLoad(Type::getInt32Ty(BB->getContext()), GVar),
-                                                  ConstantInt::get(Type::getInt32Ty(BB->getContext()), rand() % 10)),
+                                                  ConstantInt::get(Type::getInt32Ty(BB->getContext()), nextRandom() % 10)),
                                 GVar);
+            break;
         case 6:
             // Do nothing
-            break;
+            return false;
         default:
             break;
     }
+
+    return true;
+}
+
+/// Create a random i32 at the insertion point of 'Builder'
+Value *IPredO::createRandomValue(IRBuilder<> &Builder) {
+    Function *F = Builder.GetInsertBlock()->getParent();
+
+    if (ObfRNG == LibcRNG) {
+        Function *Rand = F->getParent()->getFunction("rand");
+
+        if (!Rand) {
+            F->getContext().emitError("Could not find function in module.");
+            exit(1);
+        }
+
+        return Builder.CreateCall(Rand);
+    }
+
+    // state ^= state << 13; state ^= state >> 17; state ^= state << 5
+    AllocaInst *State = getRNGState(*F);
+    Value *S = Builder.CreateLoad(Type::getInt32Ty(F->getContext()), State);
+    S = Builder.CreateXor(S, Builder.CreateShl(S, 13));
+    S = Builder.CreateXor(S, Builder.CreateLShr(S, 17));
+    S = Builder.CreateXor(S, Builder.CreateShl(S, 5));
+    Builder.CreateStore(S, State);
+
+    return S;
+}
+
+/// The xorshift32 state of 'F', a stack slot seeded with a non-zero constant at the start of the 'entry'
+/// BasicBlock. Promoting the slot to a register (mem2reg) keeps the state in registers
+AllocaInst *IPredO::getRNGState(Function &F) {
+    AllocaInst *&State = RNGState[&F];
+
+    if (!State) {
+        IRBuilder<> Builder(&*F.getEntryBlock().getFirstInsertionPt());
+        State = Builder.CreateAlloca(Type::getInt32Ty(F.getContext()), nullptr, "ipred.rng");
+        Builder.CreateStore(ConstantInt::get(Type::getInt32Ty(F.getContext()), nextRandom() | 1), State);
+    }
+
+    return State;
+}
+
+/// The i32 predicate state 'x' used by the obfuscated code of 'F'
+Value *IPredO::getPredicateState(Function &F) {
+    if (ObfStorage != FunctionStorage) {
+        GlobalVariable *GVar = F.getParent()->getNamedGlobal("x"); // Wrapper around getGlobalVariable("x", true)
+
+        if (!GVar) {
+            F.getContext().emitError("Could not find global variable in module\n");
+            exit(1);
+        }
+
+        return GVar;
+    }
+
+    Constant *&State = PredState[&F];
+
+    if (!State) {
+        // [16 x i32] aligned to 64 bytes, so that no other slot shares its cache line
+        Type *Int32Ty = Type::getInt32Ty(F.getContext());
+        ArrayType *SlotTy = ArrayType::get(Int32Ty, 16);
+        std::vector<Constant *> Init(16, ConstantInt::get(Int32Ty, 0));
+        Init[0] = ConstantInt::get(Int32Ty, nextRandom() % 100);
+
+        GlobalVariable *Slot = new GlobalVariable(*F.getParent(), SlotTy, false, GlobalValue::InternalLinkage,
+                                                  ConstantArray::get(SlotTy, Init), "x." + F.getName());
+        setObfAlignment(*Slot, 64);
+
+        Constant *Indices[] = {ConstantInt::get(Int32Ty, 0), ConstantInt::get(Int32Ty, 0)};
+        State = ConstantExpr::getInBoundsGetElementPtr(SlotTy, Slot, Indices);
+    }
+
+    return State;
 }
 
 static RegisterPass<IPredO> X("ipredO", "Obfuscates CFG by inserting invariant predicates.", false,
                               false);
 
+#if LLVM_VERSION_MAJOR >= 7
+PreservedAnalyses IPredOPass::run(Module &M, ModuleAnalysisManager &AM) {
+    IPredO Impl; // Same implementation as the legacy pass
+    Impl.FAM = &AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    // BasicBlocks are cloned and new edges are inserted
+    return Impl.runOnModule(M) ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
+#endif
@@ -0,0 +1,131 @@
+#!/bin/bash
+
+usage()
+{
+    echo "Usage ./test.sh"
+}
+
+error()
+{
+    exit -1
+}
+
+case  $1 in
+    -h | --help )
+	echo "Testing ipredO"
+	usage
+	exit 0
+	;;
+    *)
+esac
+
+obf=../cmake-build-debug/driver/llvm-obf # all passes are linked into the driver
+
+# The storage of 'x', the random numbers, the decoys of the never taken edges and the limits on the obfuscated
+# BasicBlocks, each on its own and combined. The default -ipred-rng=libc calls rand() of the C library.
+
+modes=(""
+       "-ipred-rng=xorshift"
+       "-ipred-storage=tls"
+       "-ipred-storage=function -ipred-rng=xorshift"
+       "-ipred-decoy-pool=1"
+       "-ipred-decoy-pool=4 -ipred-rng=xorshift"
+       "-ipred-cold-decoys"
+       "-ipred-cold-decoys -ipred-decoy-pool=2 -ipred-storage=tls"
+       "-ipred-growth=20"
+       "-ipred-growth=50 -ipred-budget=30 -ipred-rng=xorshift"
+       "-ipred-predicates=qr19,qr11,qr31,parity,square,bitwise,table -ipred-select=uniform"
+       "-ipred-times=2 -ipred-decoy-pool=2 -ipred-cold-decoys -ipred-storage=function -rng-seed=7")
+
+# ipred <program> <mode>
+ipred()
+{
+    program=$1
+    base=$(basename "$program" ".ll")
+    object=${base}\_p.o
+    binary=${base}\_p
+
+    ${obf} ${program} -passes=ipredO $2 -o ${object} 2> /dev/null
+    clang ${object} -o ${binary}
+}
+
+# check <expected> <command>
+check()
+{
+    res=$($2 > /dev/null; echo $?)
+
+    if [ $res != $1 ]; then
+        echo "Fail: $2 ($res)"
+        error
+    fi
+}
+
+for mode in "${modes[@]}"; do
+
+    printf "[Testing] ipredO ${mode}\n"
+
+    # fac
+
+    ipred "../programs/ll/fac.ll" "${mode}"
+
+    check 1 "./fac_p 1"
+    check 24 "./fac_p 4"
+    check 120 "./fac_p 5"
+
+    # fib
+
+    ipred "../programs/ll/fib.ll" "${mode}"
+
+    check 1 "./fib_p 1"
+    check 5 "./fib_p 5"
+    check 55 "./fib_p 10"
+
+    # pow
+
+    ipred "../programs/ll/pow.ll" "${mode}"
+
+    check 1 "./pow_p 1 5"
+    check 128 "./pow_p 2 7"
+    check 64 "./pow_p 4 3"
+
+    # phi
+
+    ipred "../programs/ll/phi.ll" "${mode}"
+
+    check 3 "./phi_p"
+
+    # sum100
+
+    ipred "../programs/ll/sum100.ll" "${mode}"
+
+    check 30 "./sum100_p"
+
+    # twofunc
+
+    ipred "../programs/ll/twofunc.ll" "${mode}"
+
+    check 33 "./twofunc_p"
+
+    # vector
+
+    ipred "../programs/ll/vector.ll" "${mode}"
+
+    check 0 "./vector_p"
+    check 0 "./vector_p 1 2 3"
+
+    # kernels (exit status 0 when the output matches its check)
+
+    for kernel in matmul quicksort hashtable interp crc parser; do
+        ipred "../programs/ll/${kernel}.ll" "${mode}"
+    done
+
+    check 0 "./matmul_p 24"
+    check 0 "./quicksort_p 5000"
+    check 0 "./hashtable_p 5000"
+    check 0 "./interp_p 5000"
+    check 0 "./crc_p 5000"
+    check 0 "./parser_p 5000"
+done
+
+echo "[Success] All tests passed..."
+exit 0
@@ -0,0 +1,924 @@
+// OverheadA: Static estimate of the runtime overhead of an obfuscation pipeline.
+//
+// The passes of -overhead-passes are not run. Instead, the constructs they would insert are counted: the dispatcher
+// transitions of flattenO (and its permute() calls or encodings of the switch index), the invariant predicates and
+// updates of 'x' of ipredO, the MBA expressions of addO, the checker loops of checkerT and the jumps over the
+// watermark pieces of splitWM. BlockFrequencyInfo gives the executions of each BasicBlock per call, and the table
+// of constructs below their cost in instructions and cycles. The costs of the invariant predicates and of the MBA
+// expressions are the expected ones over the families and identities the passes choose from (common/ObfFamilies.h).
+// The passes are estimated with the options they would run with (common/ObfOptions.h) and the settings of each
+// function (common/ObfConfig.h), so that
+//
+//   llvm-obf fac.ll -passes=flattenO,ipredO,addO -ipred-prob=60 -ipred-times=2 -estimate
+//
+// prints the estimate of exactly that configuration before running it. Calls of the functions are propagated from
+// 'main' (or from every externally visible function of a module without one) along the call sites of the module,
+// so the module totals are per run of 'main'. Calls within a recursive cycle are not propagated.
+//
+// Counts are expected values over the random choices of the passes. flattenO and ipredO see the constructs of each
+// other when both are in the pipeline; addO is estimated on the operations of the input only, and checkerT on the
+// input CFG. The growth limits (-ipred-growth, -addo-max-insts) are not modeled, and the decoys of ipredO
+// (-ipred-decoy-pool, -ipred-cold-decoys) are never executed, so they add no cost.
+
+#include "llvm/Pass.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "ObfCompat.h"
+#include "ObfConfig.h"
+#include "ObfCost.h"
+#include "ObfFamilies.h"
+#include "ObfOptions.h"
+#include "ObfPasses.h"
+#include "ObfTrace.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string> OverheadPasses("overhead-passes", cl::CommaSeparated,
+                                            cl::desc("Obfuscation pipeline to estimate, in the order it would run"),
+                                            cl::value_desc("pass,pass,..."));
+
+static cl::opt<unsigned> OverheadTop("overhead-top", cl::desc("Number of functions in the ranked table (0 = all)"),
+                                     cl::value_desc("functions"), cl::init(10), cl::Optional);
+
+static cl::opt<std::string> OverheadJSON("overhead-json",
+                                         cl::desc("Append the estimate of each module as one JSON line to <file>"),
+                                         cl::value_desc("filename"), cl::init(""), cl::Optional);
+
+// Serializes the appends to -overhead-json, modules may be estimated concurrently (llvm-obf)
+static std::mutex OverheadMutex;
+
+namespace {
+    /// Constructs inserted by the passes
+    enum Construct {
+        DispatchConstruct,
+        ThreadedDispatchConstruct,
+        RegionDispatchConstruct,
+        CrossDispatchConstruct,
+        PermuteConstruct,
+        AffineConstruct,
+        XorConstruct,
+        PredicateConstruct,
+        HotPredicateConstruct,
+        UpdateConstruct,
+        LibcRandomConstruct,
+        XorShiftRandomConstruct,
+        MBAAddConstruct,
+        MBASubConstruct,
+        MBAXorConstruct,
+        MBAOrConstruct,
+        MBAAndConstruct,
+        MBAMulConstruct,
+        MBACmpConstruct,
+        MBARelationalConstruct,
+        CheckerConstruct,
+        CheckedByteConstruct,
+        PieceConstruct,
+        NumConstructs
+    };
+
+    /// Cost of one execution of a construct
+    struct ConstructCost {
+        const char *Name; // Constructs are summed up by the part of the name before the first '.'
+        double Insts;     // Dynamic instructions
+        double Cycles;    // Estimated cycles (x86-64, L1 hits)
+    };
+}
+
+// Indexed by Construct. The instructions are counted as the passes count them for their budgets
+// (FlattenO::transitionCost, the PredicateCosts and UpdateCost of IPredO, the MBAIdentityCosts of AddO). A multiply
+// takes 3 cycles, a load 5, a remainder by a constant 8 and any other instruction 1. The predicates and MBA
+// expressions cost the expected values over the selected families and identities (getPredicateCost, getMBACost)
+static const ConstructCost Costs[] = {
+        // Name                Insts  Cycles
+        {"dispatch",           4,     10}, // Store, branch, load and switch; 1 in 3 indirect jumps mispredicted
+        {"dispatch.threaded",  5,     8},  // Store, load, table load and indirectbr, predicted per BasicBlock
+        {"dispatch.region",    1,     1},  // Mask of the region index (-flatten-region-size)
+        {"dispatch.cross",     3,     9},  // Shift, switch between the regions and second load of the switch index
+        {"permute",            12,    30}, // Call of permute() and the loads of the aliasing array
+        {"encode.affine",      4,     8},  // mul, add on the transition; sub, mul in the dispatcher
+        {"encode.xor",         2,     2},
+        {"predicate",          0,     0},  // getPredicateCost
+        {"predicate.hot",      0,     0},  // getPredicateCost in BasicBlocks run more than once per call
+        {"update",             3,     6},  // Load, add/sub/mul/shl/xor and store of 'x'
+        {"update.rand",        20,    40}, // x = rand() % 10 (-ipred-rng=libc), including the call
+        {"update.xorshift",    9,     12}, // x = xorshift32() % 10 (-ipred-rng=xorshift)
+        {"mba.add",            0,     0},  // getMBACost
+        {"mba.sub",            0,     0},
+        {"mba.xor",            0,     0},
+        {"mba.or",             0,     0},
+        {"mba.and",            0,     0},
+        {"mba.mul",            0,     0},
+        {"mba.cmp",            0,     0},  // Equality
+        {"mba.cmp.relational", 0,     0},
+        {"checker",            4,     4},  // Setup of the loop and the comparison of the XOR with 0
+        {"checker.byte",       5,     2},  // One iteration of the checker loop
+        {"piece",              1,     2},  // Taken jump over a watermark piece
+};
+
+static_assert(sizeof(Costs) / sizeof(Costs[0]) == NumConstructs, "One cost per construct");
+
+// Machine code bytes per IR instruction, for the bytes checked by checkerT
+static const unsigned BytesPerInst = 4;
+
+// Bytes of a corrector slot and of a checker, checked by the second checker
+static const unsigned SlotBytes = 4;
+static const unsigned CheckerBytes = 34;
+
+// Probability of an update of 'x' by ipredO (6 of the 7 cases) and of it being a random value (1 of the 7)
+static const double UpdateProb = 6.0 / 7;
+static const double RandomUpdateProb = 1.0 / 7;
+
+namespace {
+    /// Executions of the constructs and the instructions and cycles they add
+    struct ConstructCounts {
+        double Executions[NumConstructs];
+        double Insts[NumConstructs];
+        double Cycles[NumConstructs];
+
+        ConstructCounts() {
+            std::fill(Executions, Executions + NumConstructs, 0.0);
+            std::fill(Insts, Insts + NumConstructs, 0.0);
+            std::fill(Cycles, Cycles + NumConstructs, 0.0);
+        }
+
+        /// 'N' executions of 'C' at the cost of the table
+        void add(Construct C, double N) {
+            add(C, N, Costs[C].Insts, Costs[C].Cycles);
+        }
+
+        /// 'N' executions of 'C', each adding 'CInsts' instructions and 'CCycles' cycles
+        void add(Construct C, double N, double CInsts, double CCycles) {
+            Executions[C] += N;
+            Insts[C] += N * CInsts;
+            Cycles[C] += N * CCycles;
+        }
+
+        void add(const ConstructCounts &Other) {
+            for (unsigned C = 0; C < NumConstructs; ++C) {
+                Executions[C] += Other.Executions[C];
+                Insts[C] += Other.Insts[C];
+                Cycles[C] += Other.Cycles[C];
+            }
+        }
+
+        void scale(double Scale) {
+            for (unsigned C = 0; C < NumConstructs; ++C) {
+                Executions[C] *= Scale;
+                Insts[C] *= Scale;
+                Cycles[C] *= Scale;
+            }
+        }
+
+        double getInsts() const {
+            return std::accumulate(Insts, Insts + NumConstructs, 0.0);
+        }
+
+        double getCycles() const {
+            return std::accumulate(Cycles, Cycles + NumConstructs, 0.0);
+        }
+    };
+
+    /// Estimate of one function
+    struct FunctionEstimate {
+        Function *F;
+        double Calls;          // Estimated calls per run of the module
+        double Insts;          // Estimated dynamic instructions per call before the pipeline
+        double Cycles;         // Estimated cycles per call before the pipeline
+        ConstructCounts Added; // Constructs per call
+        std::vector<std::pair<Function *, double> > CallSites; // Callees defined in the module and their frequency
+
+        double getAddedInsts() const {
+            return Added.getInsts();
+        }
+
+        double getAddedCycles() const {
+            return Added.getCycles();
+        }
+    };
+
+    struct OverheadA : public ModulePass {
+        static char ID;
+
+        std::vector<std::string> Pipeline; // -overhead-passes unless given by llvm-obf
+
+        FunctionAnalysisManager *FAM; // Cached analyses of the new pass manager, null under the legacy one
+
+        OverheadA() : ModulePass(ID), FAM(nullptr) {}
+
+        OverheadA(const std::vector<std::string> &Pipeline) : ModulePass(ID), Pipeline(Pipeline), FAM(nullptr) {}
+
+        virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+            AU.setPreservesAll();
+        }
+
+        virtual bool runOnModule(Module &M);
+
+        void estimateFunction(Module &M, FunctionEstimate &FE);
+
+        void propagateCalls(Module &M, std::vector<FunctionEstimate> &Estimates);
+
+        void print(Module &M, const std::vector<FunctionEstimate> &Estimates);
+
+        void writeJSON(Module &M, const std::vector<FunctionEstimate> &Estimates);
+    };
+}
+
+char OverheadA::ID = 0;
+
+static RegisterPass<OverheadA> X("overheadA", "Estimates the runtime overhead of an obfuscation pipeline", false,
+                                 false);
+
+ModulePass *createOverheadAPass(const std::vector<std::string> &Pipeline) {
+    return new OverheadA(Pipeline);
+}
+
+/// Estimated cycles of 'I': a multiply 3, a division 20, a load 5, a call 5 and any other instruction 1
+static double getCycles(const Instruction &I) {
+    switch (I.getOpcode()) {
+        case Instruction::Mul:
+            return 3;
+        case Instruction::UDiv:
+        case Instruction::SDiv:
+        case Instruction::URem:
+        case Instruction::SRem:
+            return 20;
+        case Instruction::Load:
+        case Instruction::Call:
+        case Instruction::Invoke:
+            return 5;
+        default:
+            return 1;
+    }
+}
+
+/// The encoding flattenO uses for 'M', as FlattenO::getModuleEncoding
+static SwitchIndexEncoding getModuleEncoding(Module &M) {
+    SwitchIndexEncoding Encoding = getObfOption(FlattenEncodingOption, ArrayEncoding);
+
+    if (MDString *Flag = dyn_cast_or_null<MDString>(M.getModuleFlag("flatten-encoding"))) {
+        if (Flag->getString() == "array") {
+            return ArrayEncoding;
+        }
+        if (Flag->getString() == "affine") {
+            return AffineEncoding;
+        }
+        if (Flag->getString() == "xor") {
+            return XorEncoding;
+        }
+    }
+
+    return Encoding;
+}
+
+/// Regions of the BasicBlocks of 'F' under -flatten-region-size 'Size', as FlattenO::partitionIntoRegions forms
+/// them: strongly connected components in reverse topological order, filled into regions of at most 'Size'
+static void partitionIntoRegions(Function &F, unsigned Size, DenseMap<const BasicBlock *, unsigned> &Regions) {
+    unsigned MaxSize = std::max(2U, Size);
+    unsigned Region = 0;
+    unsigned Used = 0;
+    bool First = true;
+
+    for (scc_iterator<Function *> SI = scc_begin(&F); !SI.isAtEnd(); ++SI) {
+        const std::vector<BasicBlock *> &SCC = *SI;
+
+        if (!First && Used + SCC.size() > MaxSize) {
+            Region += 1;
+            Used = 0;
+        }
+        First = false;
+
+        for (BasicBlock *BB : SCC) {
+            if (BB == &F.getEntryBlock()) {
+                continue;
+            }
+            if (Used == MaxSize) {
+                Region += 1; // SCC larger than a region
+                Used = 0;
+            }
+            Regions[BB] = Region;
+            Used += 1;
+        }
+    }
+}
+
+/// Expected instructions and cycles of an invariant predicate, chosen among 'Kinds' as IPredO::selectPredicate does
+/// in a BasicBlock run more than once per call ('Hot') or not
+static void getPredicateCost(const std::vector<PredicateKind> &Kinds, SelectKind Select, bool Hot, double &Insts,
+                             double &Cycles) {
+    double Total = 0;
+
+    Insts = Cycles = 0;
+
+    for (PredicateKind K : Kinds) {
+        double Weight = getPredicateWeight(K, Select, Hot);
+
+        Insts += Weight * PredicateCosts[K].Insts;
+        Cycles += Weight * PredicateCosts[K].Latency;
+        Total += Weight;
+    }
+
+    Insts /= Total;
+    Cycles /= Total;
+}
+
+/// The MBA construct addO rewrites 'I' into, NumConstructs if -addo-ops 'Ops' does not enable it
+static Construct getMBAConstruct(const Instruction &I, const std::vector<OpKind> &Ops, OpKind &Kind) {
+    if (!I.getType()->isIntOrIntVectorTy() || I.getNumOperands() < 2 ||
+        !I.getOperand(0)->getType()->isIntOrIntVectorTy()) {
+        return NumConstructs;
+    }
+
+    switch (I.getOpcode()) {
+        case Instruction::Add:
+            Kind = AddOp;
+            break;
+        case Instruction::Sub:
+            Kind = SubOp;
+            break;
+        case Instruction::Xor:
+            Kind = XorOp;
+            break;
+        case Instruction::Or:
+            Kind = OrOp;
+            break;
+        case Instruction::And:
+            Kind = AndOp;
+            break;
+        case Instruction::Mul:
+            Kind = MulOp;
+            break;
+        case Instruction::ICmp:
+            Kind = CmpOp;
+            break;
+        default:
+            return NumConstructs;
+    }
+
+    // The constructs of the operators are in the order of OpKind, relational comparisons last
+    Construct C = Construct(MBAAddConstruct + Kind);
+    if (Kind == CmpOp && !cast<ICmpInst>(I).isEquality()) {
+        C = MBARelationalConstruct;
+    }
+
+    bool Enabled = Ops.empty() ? Kind == AddOp : std::find(Ops.begin(), Ops.end(), Kind) != Ops.end();
+
+    return Enabled ? C : NumConstructs;
+}
+
+/// Expected instructions and cycles the identity of 'I' (an operation 'Kind') adds, chosen among the ones within
+/// -addo-max-overhead 'MaxOverhead' as AddO::selectIdentity does. False if no identity is within the bound
+static bool getMBACost(const Instruction &I, OpKind Kind, bool BMI, unsigned MaxOverhead, double &Insts,
+                       double &Cycles) {
+    bool Relational = Kind == CmpOp && !cast<ICmpInst>(I).isEquality();
+    bool Vector = I.getOperand(0)->getType()->isVectorTy();
+    double Total = 0;
+
+    Insts = Cycles = 0;
+
+    for (const MBAIdentityCost &Id : MBAIdentityCosts) {
+        if (!isMBAApplicable(Id, Kind, Relational) || getMBAOverhead(Id, Vector, BMI) > MaxOverhead) {
+            continue;
+        }
+
+        // The identity replaces the operation
+        double Weight = getMBAWeight(Id, Vector, BMI);
+        Insts += Weight * (getMBAInsts(Id, Vector, BMI) - 1);
+        Cycles += Weight * getMBAOverhead(Id, Vector, BMI);
+        Total += Weight;
+    }
+
+    if (Total == 0) {
+        return false;
+    }
+
+    Insts /= Total;
+    Cycles /= Total;
+    return true;
+}
+
+/// Scale the executions of 'Added' so that their instructions fit 'Percent' of 'Base' (0 = unlimited), as the
+/// budgets of ipredO and addO, which drop the hottest BasicBlocks first
+static void applyBudget(ConstructCounts &Added, double Base, unsigned Percent) {
+    double Insts = Added.getInsts();
+
+    if (Percent == 0 || Insts <= Base * Percent / 100) {
+        return;
+    }
+
+    Added.scale(Base * Percent / 100 / Insts);
+}
+
+/// Estimate the constructs the pipeline inserts into 'FE.F' and its cost before the pipeline
+void OverheadA::estimateFunction(Module &M, FunctionEstimate &FE) {
+    Function &F = *FE.F;
+    ObfTraceScope Scope("overheadA", F);
+    ObfFunctionInfo Info(F, FAM);
+    BlockFrequencyInfo &BFI = Info.getBFI();
+    const BranchProbabilityInfo &BPI = *BFI.getBPI();
+    double EntryFreq = BFI.getEntryFreq();
+    DenseMap<const BasicBlock *, double> Freq;
+    DenseMap<Function *, double> Callees;
+
+    FE.Insts = FE.Cycles = 0;
+    FE.Added = ConstructCounts();
+
+    for (BasicBlock &BB : F) {
+        double BBFreq = BFI.getBlockFreq(&BB).getFrequency() / EntryFreq;
+        Freq[&BB] = BBFreq;
+        FE.Insts += BBFreq * BB.size();
+
+        for (Instruction &I : BB) {
+            FE.Cycles += BBFreq * getCycles(I);
+
+            Function *Callee = nullptr;
+            if (CallInst *CI = dyn_cast<CallInst>(&I)) {
+                Callee = CI->getCalledFunction();
+            } else if (InvokeInst *II = dyn_cast<InvokeInst>(&I)) {
+                Callee = II->getCalledFunction();
+            }
+
+            if (Callee && !Callee->isDeclaration()) {
+                Callees[Callee] += BBFreq;
+            }
+        }
+    }
+
+    FE.CallSites.assign(Callees.begin(), Callees.end());
+
+    // State of the pipeline so far: BasicBlocks retargeted to the dispatcher, the executions per call of the
+    // BasicBlocks flattenO adds that ipredO may obfuscate, and the obfuscations of ipredO per call
+    DenseMap<const BasicBlock *, bool> Retargeted;
+    std::vector<double> FlattenBlocks;
+    double Obfuscations = 0;
+
+    for (const std::string &Name : Pipeline) {
+        ConstructCounts Added;
+
+        // Functions the configuration (llvm-obf -obf-config) leaves alone
+        if ((Name == "flattenO" || Name == "ipredO" || Name == "addO") && !getObfConfig().isEnabled(Name, F)) {
+            continue;
+        }
+
+        if (Name == "flattenO") {
+            BranchInst *EntryBr = dyn_cast<BranchInst>(F.getEntryBlock().getTerminator());
+
+            if (F.size() == 1 || !EntryBr) {
+                continue;
+            }
+
+            SwitchIndexEncoding Encoding = getModuleEncoding(M);
+            DispatchKind Dispatch = getObfOption(FlattenDispatchOption, SwitchDispatch);
+            unsigned RegionSize = getObfOption(FlattenRegionSizeOption, 0u);
+            unsigned Budget = getObfOption(FlattenBudgetOption, 0u);
+            Construct Encode = Encoding == ArrayEncoding ? PermuteConstruct
+                               : Encoding == AffineEncoding ? AffineConstruct : XorConstruct;
+            std::vector<BasicBlock *> Candidates;
+
+            for (BasicBlock &BB : F) {
+                if (&BB != &F.getEntryBlock() && isa<BranchInst>(BB.getTerminator())) {
+                    Candidates.push_back(&BB);
+                }
+            }
+
+            // -flatten-budget is replayed as FlattenO::skipHotBasicBlocks spends it
+            if (Budget > 0) {
+                ObfBudget FBudget(F, Budget, FAM);
+                unsigned TransitionCost = unsigned(Costs[DispatchConstruct].Insts + Costs[Encode].Insts);
+                std::vector<BasicBlock *> Kept;
+
+                FBudget.charge(&F.getEntryBlock(), TransitionCost);
+                FBudget.sortColdestFirst(Candidates);
+
+                for (BasicBlock *BB : Candidates) {
+                    if (FBudget.spend(BB, TransitionCost)) {
+                        Kept.push_back(BB);
+                    }
+                }
+
+                Candidates.swap(Kept);
+            }
+
+            // One transition from 'entry' and one per execution of a retargeted BasicBlock. With ipredO before,
+            // the two conditional branches of each obfuscation are transitions as well
+            double Transitions = 1 + 2 * Obfuscations;
+            FlattenBlocks.clear();
+
+            for (BasicBlock *BB : Candidates) {
+                Transitions += Freq.lookup(BB);
+                Retargeted[BB] = true;
+
+                // The 'if.true' BasicBlock split off a conditional branch
+                if (cast<BranchInst>(BB->getTerminator())->isConditional()) {
+                    BranchProbability Prob = BPI.getEdgeProbability(BB, 0u);
+                    FlattenBlocks.push_back(Freq.lookup(BB) * Prob.getNumerator() / Prob.getDenominator());
+                }
+            }
+            FlattenBlocks.push_back(Transitions); // The dispatcher
+
+            Added.add(Dispatch == ThreadedDispatch ? ThreadedDispatchConstruct : DispatchConstruct, Transitions);
+            Added.add(Encode, Transitions);
+
+            // With -flatten-region-size a transition within a region only goes through the dispatcher of the
+            // region, one to another region (and the one from 'entry') through 'switch' first, which decodes the
+            // switch index once more. The transitions of ipredO stay within a region
+            if (RegionSize > 0 && Dispatch == SwitchDispatch) {
+                DenseMap<const BasicBlock *, unsigned> Regions;
+                double Cross = 1;
+
+                partitionIntoRegions(F, RegionSize, Regions);
+
+                for (BasicBlock *BB : Candidates) {
+                    for (unsigned S = 0, E = BB->getTerminator()->getNumSuccessors(); S < E; ++S) {
+                        BasicBlock *Succ = BB->getTerminator()->getSuccessor(S);
+
+                        if (Regions.lookup(BB) != Regions.lookup(Succ)) {
+                            BranchProbability Prob = BPI.getEdgeProbability(BB, S);
+                            Cross += Freq.lookup(BB) * Prob.getNumerator() / Prob.getDenominator();
+                        }
+                    }
+                }
+
+                // Half of an encoding is the decoding
+                double DecodeInsts = Encoding == ArrayEncoding ? 0 : Costs[Encode].Insts / 2;
+                double DecodeCycles = Encoding == ArrayEncoding ? 0 : Costs[Encode].Cycles / 2;
+
+                Added.add(RegionDispatchConstruct, Transitions);
+                Added.add(CrossDispatchConstruct, Cross, Costs[CrossDispatchConstruct].Insts + DecodeInsts,
+                          Costs[CrossDispatchConstruct].Cycles + DecodeCycles);
+            }
+        } else if (Name == "ipredO") {
+            int Prob = getObfConfig().get(F, "ipred-prob", getObfOption(IPredProbOption, 100));
+            int Times = getObfConfig().get(F, "ipred-times", getObfOption(IPredTimesOption, 1));
+            SelectKind Select = getObfOption(IPredSelectOption, CostSelect);
+            RNGKind RNG = getObfOption(IPredRNGOption, LibcRNG);
+            std::vector<PredicateKind> Kinds = getPredicateKinds(getObfListOption(IPredPredicatesOption));
+            double PredicateInsts[2], PredicateCycles[2]; // Not hot, hot
+
+            getPredicateCost(Kinds, Select, false, PredicateInsts[0], PredicateCycles[0]);
+            getPredicateCost(Kinds, Select, true, PredicateInsts[1], PredicateCycles[1]);
+
+            // Out of range values are reset to the defaults by the pass
+            double P = (Prob < 0 || Prob > 100 ? 100 : Prob) / 100.0;
+            Times = Times <= 0 ? 1 : Times;
+
+            // Each obfuscation of a BasicBlock leaves two obfuscatable BasicBlocks that run as often (and one with
+            // only the branch), so over the rounds each BasicBlock is obfuscated (1 + p)^times - 1 times per run
+            double PerBlock = std::pow(1 + P, Times) - 1;
+            std::vector<double> Blocks(FlattenBlocks);
+
+            for (BasicBlock &BB : F) {
+                // A BasicBlock with only phi nodes and its terminator is not split, unless flattenO stored the
+                // switch index into it
+                if (BB.getFirstNonPHIOrDbgOrLifetime() != BB.getTerminator() || Retargeted.lookup(&BB)) {
+                    Blocks.push_back(Freq.lookup(&BB));
+                }
+            }
+
+            for (double BBFreq : Blocks) {
+                double N = BBFreq * PerBlock;
+                bool Hot = BBFreq > 1;
+
+                Added.add(Hot ? HotPredicateConstruct : PredicateConstruct, 2 * N, PredicateInsts[Hot],
+                          PredicateCycles[Hot]);
+                Added.add(UpdateConstruct, 2 * N * (UpdateProb - RandomUpdateProb));
+                Added.add(RNG == LibcRNG ? LibcRandomConstruct : XorShiftRandomConstruct, 2 * N * RandomUpdateProb);
+            }
+
+            applyBudget(Added, FE.Insts, getObfOption(IPredBudgetOption, 0u));
+            Obfuscations += (Added.Executions[PredicateConstruct] + Added.Executions[HotPredicateConstruct]) / 2;
+        } else if (Name == "addO") {
+            std::vector<OpKind> Ops = getObfListOption(AddOOpsOption);
+            unsigned MaxOverhead = getObfOption(AddOMaxOverheadOption, 8u);
+            unsigned Rounds = getObfOption(AddORoundsOption, 1u);
+            bool BMI = F.getFnAttribute("target-features").getValueAsString().find("+bmi") != StringRef::npos;
+
+            // Each round is assumed to rewrite as many operations as the one before
+            for (BasicBlock &BB : F) {
+                for (Instruction &I : BB) {
+                    OpKind Kind;
+                    Construct C = getMBAConstruct(I, Ops, Kind);
+                    double Insts, Cycles;
+
+                    if (C != NumConstructs && getMBACost(I, Kind, BMI, MaxOverhead, Insts, Cycles)) {
+                        Added.add(C, Freq.lookup(&BB) * Rounds, Insts, Cycles);
+                    }
+                }
+            }
+
+            applyBudget(Added, FE.Insts, getObfOption(AddOBudgetOption, 0u));
+        } else if (Name == "checkerT") {
+            std::string CheckFn = getObfOption(CheckFnOption, std::string());
+            std::string CheckBB = getObfOption(CheckBBOption, std::string());
+            BasicBlock *Checked = nullptr;
+
+            if (CheckBB.empty() || (!CheckFn.empty() && CheckFn != F.getName())) {
+                continue;
+            }
+
+            // The pass checks the first BasicBlock called -checkbb in the first function that has one
+            for (Function &G : M) {
+                if (!CheckFn.empty() && CheckFn != G.getName()) {
+                    continue;
+                }
+
+                for (BasicBlock &BB : G) {
+                    if (BB.getName() == CheckBB) {
+                        Checked = &BB;
+                        break;
+                    }
+                }
+
+                if (Checked) {
+                    break;
+                }
+            }
+
+            if (!Checked || Checked->getParent() != &F || Checked == &F.getEntryBlock() || pred_empty(Checked)) {
+                continue;
+            }
+
+            // The checker of -checkbb runs before it and checks its bytes
+            double CheckedFreq = Freq.lookup(Checked);
+            Added.add(CheckerConstruct, CheckedFreq);
+            Added.add(CheckedByteConstruct, CheckedFreq * (BytesPerInst * Checked->size() + SlotBytes));
+
+            // The position of the second checker is replayed as the pass draws it. After the first checker F has a
+            // checker and a failure BasicBlock more, the failure BasicBlock last and never drawn; position 0 is
+            // moved to 1
+            std::minstd_rand RNG;
+            RNG.seed(getObfOption(CheckerSeedOption, 0));
+            unsigned Pos = RNG() % (F.size() + 1);
+            Pos = Pos == 0 ? 1 : Pos;
+
+            unsigned CheckedPos = 0;
+            for (BasicBlock &BB : F) {
+                if (&BB == Checked) {
+                    break;
+                }
+                ++CheckedPos;
+            }
+
+            // Positions up to 'CheckedPos' + 1 run as often as before, later ones are shifted by the checker
+            double InsertFreq = CheckedFreq;
+            if (Pos < CheckedPos || Pos > CheckedPos + 1) {
+                Function::iterator It = F.begin();
+                std::advance(It, Pos < CheckedPos ? Pos : Pos - 1);
+                InsertFreq = Freq.lookup(&*It);
+            }
+
+            Added.add(CheckerConstruct, InsertFreq);
+            Added.add(CheckedByteConstruct, InsertFreq * (CheckerBytes + SlotBytes));
+        } else if (Name == "splitWM") {
+            std::vector<unsigned> Splits = getObfListOption(SplitsOption);
+            unsigned Defined = 0;
+            double Sum = 0;
+
+            for (Function &G : M) {
+                Defined += !G.isDeclaration();
+            }
+            for (BasicBlock &BB : F) {
+                Sum += Freq.lookup(&BB);
+            }
+
+            // Each piece goes into a random BasicBlock of a random function with a body
+            Added.add(PieceConstruct, Splits.size() * Sum / F.size() / Defined);
+        }
+
+        FE.Added.add(Added);
+    }
+}
+
+/// Propagate the calls of the functions top-down along their call sites. 'main' is called once, or every externally
+/// visible function if the module has no 'main'
+void OverheadA::propagateCalls(Module &M, std::vector<FunctionEstimate> &Estimates) {
+    DenseMap<const Function *, FunctionEstimate *> Index;
+    Function *Main = M.getFunction("main");
+    bool HasMain = Main && !Main->isDeclaration();
+
+    for (FunctionEstimate &FE : Estimates) {
+        Index[FE.F] = &FE;
+        FE.Calls = HasMain ? (FE.F == Main ? 1 : 0) : (FE.F->hasLocalLinkage() ? 0 : 1);
+    }
+
+    // SCCs are visited bottom-up, callers after their callees
+    CallGraph CG(M);
+    std::vector<std::vector<CallGraphNode *> > SCCs;
+
+    for (scc_iterator<CallGraph *> I = scc_begin(&CG); !I.isAtEnd(); ++I) {
+        SCCs.push_back(*I);
+    }
+
+    for (auto SCC = SCCs.rbegin(); SCC != SCCs.rend(); ++SCC) {
+        for (CallGraphNode *Node : *SCC) {
+            FunctionEstimate *FE = Node->getFunction() ? Index.lookup(Node->getFunction()) : nullptr;
+
+            if (!FE) {
+                continue;
+            }
+
+            for (const std::pair<Function *, double> &Site : FE->CallSites) {
+                FunctionEstimate *Callee = Index.lookup(Site.first);
+                bool Recursive = false;
+
+                for (CallGraphNode *Other : *SCC) {
+                    Recursive |= Other->getFunction() == Site.first;
+                }
+
+                if (Callee && !Recursive) {
+                    Callee->Calls += FE->Calls * Site.second;
+                }
+            }
+        }
+    }
+}
+
+bool OverheadA::runOnModule(Module &M) {
+    ObfTraceScope Scope("overheadA", M);
+
+    if (Pipeline.empty()) {
+        Pipeline.assign(OverheadPasses.begin(), OverheadPasses.end());
+    }
+
+    std::vector<FunctionEstimate> Estimates;
+
+    for (Function &F : M) {
+        if (!F.isDeclaration()) {
+            Estimates.push_back(FunctionEstimate());
+            Estimates.back().F = &F;
+            estimateFunction(M, Estimates.back());
+        }
+    }
+
+    propagateCalls(M, Estimates);
+
+    // Most added cycles per run first
+    std::stable_sort(Estimates.begin(), Estimates.end(), [](const FunctionEstimate &A, const FunctionEstimate &B) {
+        return A.Calls * A.getAddedCycles() > B.Calls * B.getAddedCycles();
+    });
+
+    print(M, Estimates);
+
+    if (!OverheadJSON.empty()) {
+        writeJSON(M, Estimates);
+    }
+
+    return false;
+}
+
+/// Print the module totals, the cycles by construct and the functions adding the most cycles
+void OverheadA::print(Module &M, const std::vector<FunctionEstimate> &Estimates) {
+    double Insts = 0, Cycles = 0, AddedInsts = 0, AddedCycles = 0;
+    std::vector<std::pair<std::string, double> > Groups;
+
+    for (const FunctionEstimate &FE : Estimates) {
+        Insts += FE.Calls * FE.Insts;
+        Cycles += FE.Calls * FE.Cycles;
+        AddedInsts += FE.Calls * FE.getAddedInsts();
+        AddedCycles += FE.Calls * FE.getAddedCycles();
+    }
+
+    for (unsigned C = 0; C < NumConstructs; ++C) {
+        std::string Group = StringRef(Costs[C].Name).split('.').first.str();
+        double Sum = 0;
+
+        for (const FunctionEstimate &FE : Estimates) {
+            Sum += FE.Calls * FE.Added.Cycles[C];
+        }
+
+        if (Groups.empty() || Groups.back().first != Group) {
+            Groups.push_back(std::make_pair(Group, 0.0));
+        }
+        Groups.back().second += Sum;
+    }
+
+    std::string Passes;
+    for (const std::string &Name : Pipeline) {
+        Passes += (Passes.empty() ? "" : ",") + Name;
+    }
+
+    errs() << "overheadA: " << M.getModuleIdentifier() << ": " << (Passes.empty() ? "no passes" : Passes)
+           << ": estimated +" << format("%.1f", AddedInsts) << " dynamic instructions ("
+           << format("%.1f", Insts ? 100 * AddedInsts / Insts : 0.0) << "% of " << format("%.1f", Insts)
+           << "), +" << format("%.1f", AddedCycles) << " cycles ("
+           << format("%.1f", Cycles ? 100 * AddedCycles / Cycles : 0.0) << "% of " << format("%.1f", Cycles)
+           << ") per run\n";
+
+    errs() << "  cycles by construct:";
+    for (const std::pair<std::string, double> &Group : Groups) {
+        if (Group.second > 0) {
+            errs() << " " << Group.first << " +" << format("%.1f", Group.second);
+        }
+    }
+    errs() << "\n";
+
+    errs() << "  rank function                              calls   insts/call  +insts/call  +insts% +cycles/call"
+              "      +cycles   share\n";
+
+    for (unsigned I = 0; I < Estimates.size() && (OverheadTop == 0 || I < OverheadTop); ++I) {
+        const FunctionEstimate &FE = Estimates[I];
+        double Added = FE.Calls * FE.getAddedCycles();
+
+        errs() << format("  %4u %-32s %10.1f %12.1f %12.1f %7.1f%% %12.1f %12.1f %6.1f%%\n", I + 1,
+                         FE.F->getName().str().substr(0, 32).c_str(), FE.Calls, FE.Insts, FE.getAddedInsts(),
+                         FE.Insts ? 100 * FE.getAddedInsts() / FE.Insts : 0.0, FE.getAddedCycles(), Added,
+                         AddedCycles ? 100 * Added / AddedCycles : 0.0);
+    }
+}
+
+/// Print 'S' as a JSON string
+static void printJSONString(raw_ostream &OS, StringRef S) {
+    OS << '"';
+    for (unsigned char C : S) {
+        if (C == '"' || C == '\\') {
+            OS << '\\' << C;
+        } else if (C < 0x20) {
+            OS << format("\\u%04x", C);
+        } else {
+            OS << C;
+        }
+    }
+    OS << '"';
+}
+
+/// Append the estimate of 'M' as one line to -overhead-json
+void OverheadA::writeJSON(Module &M, const std::vector<FunctionEstimate> &Estimates) {
+    std::string Line;
+    raw_string_ostream OS(Line);
+
+    OS << "{\"module\":";
+    printJSONString(OS, M.getModuleIdentifier());
+    OS << ",\"passes\":[";
+    for (unsigned I = 0; I < Pipeline.size(); ++I) {
+        OS << (I ? "," : "");
+        printJSONString(OS, Pipeline[I]);
+    }
+    OS << "],\"functions\":[";
+
+    for (unsigned I = 0; I < Estimates.size(); ++I) {
+        const FunctionEstimate &FE = Estimates[I];
+
+        OS << (I ? "," : "") << "{\"name\":";
+        printJSONString(OS, FE.F->getName());
+        OS << ",\"calls\":" << format("%.3f", FE.Calls) << ",\"instructions\":" << format("%.3f", FE.Insts)
+           << ",\"cycles\":" << format("%.3f", FE.Cycles) << ",\"added_instructions\":"
+           << format("%.3f", FE.getAddedInsts()) << ",\"added_cycles\":" << format("%.3f", FE.getAddedCycles())
+           << ",\"constructs\":{";
+
+        bool First = true;
+        for (unsigned C = 0; C < NumConstructs; ++C) {
+            if (FE.Added.Executions[C] > 0) {
+                OS << (First ? "" : ",") << "\"" << Costs[C].Name << "\":" << format("%.3f", FE.Added.Executions[C]);
+                First = false;
+            }
+        }
+
+        OS << "}}";
+    }
+
+    OS << "]}\n";
+    OS.flush();
+
+    std::lock_guard<std::mutex> Lock(OverheadMutex);
+    std::error_code EC;
+    raw_fd_ostream Out(OverheadJSON, EC, ObfOpenAppend);
+
+    if (EC) {
+        errs() << OverheadJSON << ": " << EC.message() << "\n";
+        return;
+    }
+
+    Out << Line;
+}
+
+#if LLVM_VERSION_MAJOR >= 7
+PreservedAnalyses OverheadAPass::run(Module &M, ModuleAnalysisManager &AM) {
+    OverheadA Impl; // Same implementation as the legacy pass
+    Impl.FAM = &AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    Impl.runOnModule(M);
+
+    return PreservedAnalyses::all();
+}
+#endif
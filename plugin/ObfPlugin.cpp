@@ -0,0 +1,78 @@
+// ObfPlugin: The passes of this project for the new pass manager, as one loadable pass plugin.
+//
+// The passes can be named in a pipeline,
+//
+//   opt -load-pass-plugin=libObfPlugin.so -passes=flattenO,ipredO,addO fac.ll
+//
+// or be appended to the optimization pipeline of clang with -obf-passes,
+//
+//   clang -O2 -fpass-plugin=libObfPlugin.so -mllvm -obf-passes=flattenO,addO fac.c
+//
+// opt only accepts the options of the passes (e.g. -flatten-encoding) if the plugin is also given with -load.
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/PassPlugin.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "ObfPasses.h"
+
+#include <string>
+
+using namespace llvm;
+
+// LLVM 14 moved OptimizationLevel out of PassBuilder
+#if LLVM_VERSION_MAJOR >= 14
+typedef OptimizationLevel ObfOptimizationLevel;
+#else
+typedef PassBuilder::OptimizationLevel ObfOptimizationLevel;
+#endif
+
+static cl::list<std::string> ObfPasses("obf-passes", cl::CommaSeparated,
+                                       cl::desc("Obfuscation passes appended to the optimization pipeline"),
+                                       cl::value_desc("pass,pass,..."));
+
+/// Add the pass called 'Name' to 'MPM'
+static bool addModulePass(StringRef Name, ModulePassManager &MPM) {
+    if (Name == "flattenO") {
+        MPM.addPass(FlattenOPass());
+    } else if (Name == "ipredO") {
+        MPM.addPass(IPredOPass());
+    } else if (Name == "checkerT") {
+        MPM.addPass(CheckerTPass());
+    } else if (Name == "splitWM") {
+        MPM.addPass(ChineseWMPass());
+    } else if (Name == "cyclomaticA") {
+        MPM.addPass(CyclomaticAPass());
+    } else if (Name == "overheadA") {
+        MPM.addPass(OverheadAPass());
+    } else if (Name == "addO") {
+        MPM.addPass(AddOPass());
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+static void registerObfPasses(PassBuilder &PB) {
+    PB.registerPipelineParsingCallback(
+            [](StringRef Name, ModulePassManager &MPM, ArrayRef<PassBuilder::PipelineElement>) {
+                return addModulePass(Name, MPM);
+            });
+
+    // Obfuscate after optimization, so that the optimizer does not undo it
+    PB.registerOptimizerLastEPCallback([](ModulePassManager &MPM, ObfOptimizationLevel) {
+        for (const std::string &Name : ObfPasses) {
+            if (!addModulePass(Name, MPM)) {
+                errs() << "ObfPlugin: unknown pass '" << Name << "'\n";
+            }
+        }
+    });
+}
+
+extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo() {
+    return {LLVM_PLUGIN_API_VERSION, "ObfPlugin", LLVM_VERSION_STRING, registerObfPasses};
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// CRC-32 (table driven and bitwise) and a SHA-style add-rotate-xor mix of n pseudo-random bytes. The CRCs
+// must agree with each other and with the check value of "123456789"
+
+unsigned table[256];
+
+void make_table(void)
+{
+  for (unsigned n = 0; n < 256; ++n) {
+    unsigned c = n;
+    for (int k = 0; k < 8; ++k) {
+      c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+    }
+    table[n] = c;
+  }
+}
+
+unsigned crc32_table(unsigned char* buf, int len)
+{
+  unsigned c = 0xFFFFFFFF;
+
+  for (int i = 0; i < len; ++i) {
+    c = table[(c ^ buf[i]) & 0xFF] ^ (c >> 8);
+  }
+
+  return c ^ 0xFFFFFFFF;
+}
+
+unsigned crc32_bitwise(unsigned char* buf, int len)
+{
+  unsigned c = 0xFFFFFFFF;
+
+  for (int i = 0; i < len; ++i) {
+    c ^= buf[i];
+    for (int k = 0; k < 8; ++k) {
+      c = (c >> 1) ^ (0xEDB88320 & (0 - (c & 1)));
+    }
+  }
+
+  return c ^ 0xFFFFFFFF;
+}
+
+unsigned mix(unsigned char* buf, int len)
+{
+  unsigned h0 = 0x6a09e667;
+  unsigned h1 = 0xbb67ae85;
+
+  for (int i = 0; i + 4 <= len; i += 4) {
+    unsigned w = buf[i] | buf[i + 1] << 8 | buf[i + 2] << 16 | (unsigned) buf[i + 3] << 24;
+    h0 ^= w;
+    h0 = ((h0 >> 7) | (h0 << 25)) + h1;
+    h1 = ((h1 >> 11) | (h1 << 21)) ^ (h0 + 0x9e3779b9);
+  }
+
+  return h0 ^ h1;
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? strtol(argv[1], NULL, 0) : 1 << 20;
+
+  if (n <= 0) {
+    printf("Usage: crc [n]\n");
+    return -1;
+  }
+
+  unsigned char* buf = malloc(n);
+  unsigned seed = 1;
+
+  for (int i = 0; i < n; ++i) {
+    seed = seed * 1103515245 + 12345;
+    buf[i] = seed >> 16;
+  }
+
+  make_table();
+
+  unsigned check = crc32_table((unsigned char*) "123456789", 9);
+  unsigned crc = crc32_table(buf, n);
+  unsigned crc2 = crc32_bitwise(buf, n);
+  unsigned h = mix(buf, n);
+
+  printf("crc: %08x %08x\n", crc, h);
+
+  free(buf);
+
+  return check != 0xCBF43926 || crc != crc2;
+}
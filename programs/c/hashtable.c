@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Open addressing hash table with linear probing: n inserts, n successful and n failing lookups
+
+unsigned hash(unsigned key)
+{
+  key ^= key >> 16;
+  key *= 0x45d9f3b;
+  key ^= key >> 16;
+  return key;
+}
+
+void insert(unsigned* keys, int* values, unsigned mask, unsigned key, int value)
+{
+  unsigned i = hash(key) & mask;
+
+  while (keys[i] != 0 && keys[i] != key) {
+    i = (i + 1) & mask;
+  }
+
+  keys[i] = key;
+  values[i] = value;
+}
+
+int lookup(unsigned* keys, int* values, unsigned mask, unsigned key)
+{
+  unsigned i = hash(key) & mask;
+
+  while (keys[i] != 0) {
+    if (keys[i] == key) {
+      return values[i];
+    }
+    i = (i + 1) & mask;
+  }
+
+  return -1;
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? strtol(argv[1], NULL, 0) : 500000;
+
+  if (n <= 0) {
+    printf("Usage: hashtable [n]\n");
+    return -1;
+  }
+
+  unsigned capacity = 1;
+  while (capacity < 2 * n) {
+    capacity <<= 1;
+  }
+
+  unsigned* keys = calloc(capacity, sizeof(unsigned));
+  int* values = malloc(capacity * sizeof(int));
+
+  // Odd keys are inserted, even keys are missing (the multiplier is odd), 0 marks a free slot
+  for (int i = 0; i < n; ++i) {
+    insert(keys, values, capacity - 1, (2 * i + 1) * 2654435761u, i);
+  }
+
+  int found = 0;
+  int missing = 0;
+
+  for (int i = 0; i < n; ++i) {
+    if (lookup(keys, values, capacity - 1, (2 * i + 1) * 2654435761u) == i) {
+      ++found;
+    }
+    if (lookup(keys, values, capacity - 1, (2 * i + 2) * 2654435761u) == -1) {
+      ++missing;
+    }
+  }
+
+  printf("hashtable: %d %d\n", found, missing);
+
+  free(keys);
+  free(values);
+
+  return found != n || missing != n;
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Stack machine interpreting a byte-code loop, checked against the same loop compiled natively:
+//
+//   sum = 0; i = n; while (0 < i) { sum = (sum + i * i) % 1000003; i = i - 1; }
+
+enum { PUSH, LOAD, STORE, ADD, SUB, MUL, MOD, LT, JZ, JMP, HALT };
+
+int code[] = {
+  PUSH, 0, STORE, 0,                             // 0: sum = 0
+  LOAD, 2, STORE, 1,                             // 4: i = n
+  PUSH, 0, LOAD, 1, LT, JZ, 37,                  // 8: while (0 < i)
+  LOAD, 0, LOAD, 1, LOAD, 1, MUL, ADD,           // 15: sum + i * i
+  PUSH, 1000003, MOD, STORE, 0,                  // 23: sum = ... % 1000003
+  LOAD, 1, PUSH, 1, SUB, STORE, 1,               // 28: i = i - 1
+  JMP, 8,                                        // 35
+  HALT                                           // 37
+};
+
+unsigned run(int* code, unsigned* vars)
+{
+  unsigned stack[16];
+  int sp = 0;
+  int pc = 0;
+
+  for (;;) {
+    switch (code[pc++]) {
+    case PUSH:
+      stack[sp++] = code[pc++];
+      break;
+    case LOAD:
+      stack[sp++] = vars[code[pc++]];
+      break;
+    case STORE:
+      vars[code[pc++]] = stack[--sp];
+      break;
+    case ADD:
+      --sp;
+      stack[sp - 1] += stack[sp];
+      break;
+    case SUB:
+      --sp;
+      stack[sp - 1] -= stack[sp];
+      break;
+    case MUL:
+      --sp;
+      stack[sp - 1] *= stack[sp];
+      break;
+    case MOD:
+      --sp;
+      stack[sp - 1] %= stack[sp];
+      break;
+    case LT:
+      --sp;
+      stack[sp - 1] = stack[sp - 1] < stack[sp];
+      break;
+    case JZ:
+      if (stack[--sp] == 0) {
+        pc = code[pc];
+      } else {
+        ++pc;
+      }
+      break;
+    case JMP:
+      pc = code[pc];
+      break;
+    default:
+      return vars[0];
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? strtol(argv[1], NULL, 0) : 2000000;
+
+  if (n <= 0) {
+    printf("Usage: interp [n]\n");
+    return -1;
+  }
+
+  unsigned vars[3] = { 0, 0, n };
+  unsigned sum = run(code, vars);
+
+  unsigned check = 0;
+  for (unsigned i = n; 0 < i; --i) {
+    check = (check + i * i) % 1000003;
+  }
+
+  printf("interp: %u\n", sum);
+
+  return sum != check;
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// C = A * B for n x n integer matrices, checked against sum(C) = sum_k colsum_A(k) * rowsum_B(k)
+
+void init(int* m, int n, unsigned seed)
+{
+  for (int i = 0; i < n * n; ++i) {
+    seed = seed * 1103515245 + 12345;
+    m[i] = (seed >> 16) % 100;
+  }
+}
+
+void matmul(int* a, int* b, int* c, int n)
+{
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      int sum = 0;
+      for (int k = 0; k < n; ++k) {
+        sum += a[i * n + k] * b[k * n + j];
+      }
+      c[i * n + j] = sum;
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? strtol(argv[1], NULL, 0) : 128;
+
+  if (n <= 0) {
+    printf("Usage: matmul [n]\n");
+    return -1;
+  }
+
+  int* a = malloc(n * n * sizeof(int));
+  int* b = malloc(n * n * sizeof(int));
+  int* c = malloc(n * n * sizeof(int));
+
+  init(a, n, 1);
+  init(b, n, 2);
+  matmul(a, b, c, n);
+
+  unsigned sum = 0;
+  for (int i = 0; i < n * n; ++i) {
+    sum += c[i];
+  }
+
+  unsigned check = 0;
+  for (int k = 0; k < n; ++k) {
+    unsigned col = 0;
+    unsigned row = 0;
+    for (int i = 0; i < n; ++i) {
+      col += a[i * n + k];
+      row += b[k * n + i];
+    }
+    check += col * row;
+  }
+
+  printf("matmul: %u\n", sum);
+
+  free(a);
+  free(b);
+  free(c);
+
+  return sum != check;
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Recursive-descent evaluation of a generated arithmetic expression of about n characters, checked against the
+// value the generator computed. Arithmetic wraps around (unsigned)
+
+char* out;
+int pos;
+int limit;
+unsigned seed = 1;
+char* p;
+
+unsigned next(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return seed >> 16;
+}
+
+unsigned gen_expr(int depth);
+
+unsigned gen_factor(int depth)
+{
+  if (depth == 0 || pos > limit || next() % 3 == 0) {
+    unsigned v = next() % 100;
+    if (v >= 10) {
+      out[pos++] = '0' + v / 10;
+    }
+    out[pos++] = '0' + v % 10;
+    return v;
+  }
+
+  out[pos++] = '(';
+  unsigned v = gen_expr(depth - 1);
+  out[pos++] = ')';
+  return v;
+}
+
+unsigned gen_term(int depth)
+{
+  unsigned v = gen_factor(depth);
+
+  while (pos < limit && next() % 4 == 0) {
+    out[pos++] = '*';
+    v *= gen_factor(depth);
+  }
+
+  return v;
+}
+
+unsigned gen_expr(int depth)
+{
+  unsigned v = gen_term(depth);
+
+  while (pos < limit && next() % 2 == 0) {
+    if (next() % 2) {
+      out[pos++] = '+';
+      v += gen_term(depth);
+    } else {
+      out[pos++] = '-';
+      v -= gen_term(depth);
+    }
+  }
+
+  return v;
+}
+
+unsigned parse_expr(void);
+
+unsigned parse_number(void)
+{
+  unsigned v = 0;
+
+  while (*p >= '0' && *p <= '9') {
+    v = v * 10 + (*p++ - '0');
+  }
+
+  return v;
+}
+
+unsigned parse_factor(void)
+{
+  if (*p == '(') {
+    ++p;
+    unsigned v = parse_expr();
+    ++p; // ')'
+    return v;
+  }
+
+  return parse_number();
+}
+
+unsigned parse_term(void)
+{
+  unsigned v = parse_factor();
+
+  while (*p == '*') {
+    ++p;
+    v *= parse_factor();
+  }
+
+  return v;
+}
+
+unsigned parse_expr(void)
+{
+  unsigned v = parse_term();
+
+  while (*p == '+' || *p == '-') {
+    char op = *p++;
+    unsigned t = parse_term();
+    v = op == '+' ? v + t : v - t;
+  }
+
+  return v;
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? strtol(argv[1], NULL, 0) : 1 << 20;
+
+  if (n <= 0) {
+    printf("Usage: parser [n]\n");
+    return -1;
+  }
+
+  // Past 'limit' no parenthesis is opened, so at most a few characters per nesting level follow
+  limit = n;
+  out = malloc(n + 4096);
+  pos = 0;
+
+  unsigned value = gen_term(8);
+  while (pos < limit) {
+    out[pos++] = '+';
+    value += gen_term(8);
+  }
+  out[pos] = 0;
+
+  p = out;
+  unsigned result = parse_expr();
+  int rest = *p;
+
+  printf("parser: %u (%d characters)\n", result, pos);
+
+  free(out);
+
+  return result != value || rest != 0;
+}
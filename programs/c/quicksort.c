@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Recursive quicksort of n pseudo-random integers, checked for order and for the sum of the elements
+
+void swap(int* a, int i, int j)
+{
+  int t = a[i];
+  a[i] = a[j];
+  a[j] = t;
+}
+
+void quicksort(int* a, int lo, int hi)
+{
+  if (lo >= hi) {
+    return;
+  }
+
+  swap(a, (lo + hi) / 2, hi);
+  int pivot = a[hi];
+  int i = lo;
+
+  for (int j = lo; j < hi; ++j) {
+    if (a[j] < pivot) {
+      swap(a, i, j);
+      ++i;
+    }
+  }
+
+  swap(a, i, hi);
+  quicksort(a, lo, i - 1);
+  quicksort(a, i + 1, hi);
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? strtol(argv[1], NULL, 0) : 200000;
+
+  if (n <= 0) {
+    printf("Usage: quicksort [n]\n");
+    return -1;
+  }
+
+  int* a = malloc(n * sizeof(int));
+  unsigned seed = 1;
+  unsigned before = 0;
+
+  for (int i = 0; i < n; ++i) {
+    seed = seed * 1103515245 + 12345;
+    a[i] = (seed >> 8) % 1000000;
+    before += a[i];
+  }
+
+  quicksort(a, 0, n - 1);
+
+  unsigned after = a[0];
+  int sorted = 1;
+
+  for (int i = 1; i < n; ++i) {
+    if (a[i - 1] > a[i]) {
+      sorted = 0;
+    }
+    after += a[i];
+  }
+
+  printf("quicksort: %u\n", after);
+
+  free(a);
+
+  return !sorted || before != after;
+}
@@ -0,0 +1,432 @@
+; ModuleID = 'programs/c/crc.c'
+source_filename = "programs/c/crc.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@table = common global [256 x i32] zeroinitializer, align 16
+@.str = private unnamed_addr constant [16 x i8] c"Usage: crc [n]\0A\00", align 1
+@.str.1 = private unnamed_addr constant [10 x i8] c"123456789\00", align 1
+@.str.2 = private unnamed_addr constant [16 x i8] c"crc: %08x %08x\0A\00", align 1
+
+; Function Attrs: nounwind uwtable
+define void @make_table() #0 {
+entry:
+  %n = alloca i32, align 4
+  %c = alloca i32, align 4
+  %k = alloca i32, align 4
+  store i32 0, i32* %n, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc8, %entry
+  %0 = load i32, i32* %n, align 4
+  %cmp = icmp ult i32 %0, 256
+  br i1 %cmp, label %for.body, label %for.end10
+
+for.body:                                         ; preds = %for.cond
+  %1 = load i32, i32* %n, align 4
+  store i32 %1, i32* %c, align 4
+  store i32 0, i32* %k, align 4
+  br label %for.cond1
+
+for.cond1:                                        ; preds = %for.inc, %for.body
+  %2 = load i32, i32* %k, align 4
+  %cmp2 = icmp slt i32 %2, 8
+  br i1 %cmp2, label %for.body3, label %for.end
+
+for.body3:                                        ; preds = %for.cond1
+  %3 = load i32, i32* %c, align 4
+  %and = and i32 %3, 1
+  %tobool = icmp ne i32 %and, 0
+  br i1 %tobool, label %cond.true, label %cond.false
+
+cond.true:                                        ; preds = %for.body3
+  %4 = load i32, i32* %c, align 4
+  %shr = lshr i32 %4, 1
+  %xor = xor i32 -306674912, %shr
+  br label %cond.end
+
+cond.false:                                       ; preds = %for.body3
+  %5 = load i32, i32* %c, align 4
+  %shr4 = lshr i32 %5, 1
+  br label %cond.end
+
+cond.end:                                         ; preds = %cond.false, %cond.true
+  %cond = phi i32 [ %xor, %cond.true ], [ %shr4, %cond.false ]
+  store i32 %cond, i32* %c, align 4
+  br label %for.inc
+
+for.inc:                                          ; preds = %cond.end
+  %6 = load i32, i32* %k, align 4
+  %inc = add nsw i32 %6, 1
+  store i32 %inc, i32* %k, align 4
+  br label %for.cond1
+
+for.end:                                          ; preds = %for.cond1
+  %7 = load i32, i32* %c, align 4
+  %8 = load i32, i32* %n, align 4
+  %idxprom = zext i32 %8 to i64
+  %arrayidx = getelementptr inbounds [256 x i32], [256 x i32]* @table, i64 0, i64 %idxprom
+  store i32 %7, i32* %arrayidx, align 4
+  br label %for.inc8
+
+for.inc8:                                         ; preds = %for.end
+  %9 = load i32, i32* %n, align 4
+  %inc9 = add i32 %9, 1
+  store i32 %inc9, i32* %n, align 4
+  br label %for.cond
+
+for.end10:                                        ; preds = %for.cond
+  ret void
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @crc32_table(i8* %buf, i32 %len) #0 {
+entry:
+  %buf.addr = alloca i8*, align 8
+  %len.addr = alloca i32, align 4
+  %c = alloca i32, align 4
+  %i = alloca i32, align 4
+  store i8* %buf, i8** %buf.addr, align 8
+  store i32 %len, i32* %len.addr, align 4
+  store i32 -1, i32* %c, align 4
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc, %entry
+  %0 = load i32, i32* %i, align 4
+  %1 = load i32, i32* %len.addr, align 4
+  %cmp = icmp slt i32 %0, %1
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:                                         ; preds = %for.cond
+  %2 = load i32, i32* %c, align 4
+  %3 = load i8*, i8** %buf.addr, align 8
+  %4 = load i32, i32* %i, align 4
+  %idxprom = sext i32 %4 to i64
+  %arrayidx = getelementptr inbounds i8, i8* %3, i64 %idxprom
+  %5 = load i8, i8* %arrayidx, align 1
+  %conv = zext i8 %5 to i32
+  %xor = xor i32 %2, %conv
+  %and = and i32 %xor, 255
+  %idxprom1 = zext i32 %and to i64
+  %arrayidx2 = getelementptr inbounds [256 x i32], [256 x i32]* @table, i64 0, i64 %idxprom1
+  %6 = load i32, i32* %arrayidx2, align 4
+  %7 = load i32, i32* %c, align 4
+  %shr = lshr i32 %7, 8
+  %xor3 = xor i32 %6, %shr
+  store i32 %xor3, i32* %c, align 4
+  br label %for.inc
+
+for.inc:                                          ; preds = %for.body
+  %8 = load i32, i32* %i, align 4
+  %inc = add nsw i32 %8, 1
+  store i32 %inc, i32* %i, align 4
+  br label %for.cond
+
+for.end:                                          ; preds = %for.cond
+  %9 = load i32, i32* %c, align 4
+  %xor4 = xor i32 %9, -1
+  ret i32 %xor4
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @crc32_bitwise(i8* %buf, i32 %len) #0 {
+entry:
+  %buf.addr = alloca i8*, align 8
+  %len.addr = alloca i32, align 4
+  %c = alloca i32, align 4
+  %i = alloca i32, align 4
+  %k = alloca i32, align 4
+  store i8* %buf, i8** %buf.addr, align 8
+  store i32 %len, i32* %len.addr, align 4
+  store i32 -1, i32* %c, align 4
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc7, %entry
+  %0 = load i32, i32* %i, align 4
+  %1 = load i32, i32* %len.addr, align 4
+  %cmp = icmp slt i32 %0, %1
+  br i1 %cmp, label %for.body, label %for.end9
+
+for.body:                                         ; preds = %for.cond
+  %2 = load i8*, i8** %buf.addr, align 8
+  %3 = load i32, i32* %i, align 4
+  %idxprom = sext i32 %3 to i64
+  %arrayidx = getelementptr inbounds i8, i8* %2, i64 %idxprom
+  %4 = load i8, i8* %arrayidx, align 1
+  %conv = zext i8 %4 to i32
+  %5 = load i32, i32* %c, align 4
+  %xor = xor i32 %5, %conv
+  store i32 %xor, i32* %c, align 4
+  store i32 0, i32* %k, align 4
+  br label %for.cond1
+
+for.cond1:                                        ; preds = %for.inc, %for.body
+  %6 = load i32, i32* %k, align 4
+  %cmp2 = icmp slt i32 %6, 8
+  br i1 %cmp2, label %for.body4, label %for.end
+
+for.body4:                                        ; preds = %for.cond1
+  %7 = load i32, i32* %c, align 4
+  %shr = lshr i32 %7, 1
+  %8 = load i32, i32* %c, align 4
+  %and = and i32 %8, 1
+  %sub = sub i32 0, %and
+  %and5 = and i32 -306674912, %sub
+  %xor6 = xor i32 %shr, %and5
+  store i32 %xor6, i32* %c, align 4
+  br label %for.inc
+
+for.inc:                                          ; preds = %for.body4
+  %9 = load i32, i32* %k, align 4
+  %inc = add nsw i32 %9, 1
+  store i32 %inc, i32* %k, align 4
+  br label %for.cond1
+
+for.end:                                          ; preds = %for.cond1
+  br label %for.inc7
+
+for.inc7:                                         ; preds = %for.end
+  %10 = load i32, i32* %i, align 4
+  %inc8 = add nsw i32 %10, 1
+  store i32 %inc8, i32* %i, align 4
+  br label %for.cond
+
+for.end9:                                         ; preds = %for.cond
+  %11 = load i32, i32* %c, align 4
+  %xor10 = xor i32 %11, -1
+  ret i32 %xor10
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @mix(i8* %buf, i32 %len) #0 {
+entry:
+  %buf.addr = alloca i8*, align 8
+  %len.addr = alloca i32, align 4
+  %h0 = alloca i32, align 4
+  %h1 = alloca i32, align 4
+  %i = alloca i32, align 4
+  %w = alloca i32, align 4
+  store i8* %buf, i8** %buf.addr, align 8
+  store i32 %len, i32* %len.addr, align 4
+  store i32 1779033703, i32* %h0, align 4
+  store i32 -1150833019, i32* %h1, align 4
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc, %entry
+  %0 = load i32, i32* %i, align 4
+  %add = add nsw i32 %0, 4
+  %1 = load i32, i32* %len.addr, align 4
+  %cmp = icmp sle i32 %add, %1
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:                                         ; preds = %for.cond
+  %2 = load i8*, i8** %buf.addr, align 8
+  %3 = load i32, i32* %i, align 4
+  %idxprom = sext i32 %3 to i64
+  %arrayidx = getelementptr inbounds i8, i8* %2, i64 %idxprom
+  %4 = load i8, i8* %arrayidx, align 1
+  %conv = zext i8 %4 to i32
+  %5 = load i8*, i8** %buf.addr, align 8
+  %6 = load i32, i32* %i, align 4
+  %add1 = add nsw i32 %6, 1
+  %idxprom2 = sext i32 %add1 to i64
+  %arrayidx3 = getelementptr inbounds i8, i8* %5, i64 %idxprom2
+  %7 = load i8, i8* %arrayidx3, align 1
+  %conv4 = zext i8 %7 to i32
+  %shl = shl i32 %conv4, 8
+  %or = or i32 %conv, %shl
+  %8 = load i8*, i8** %buf.addr, align 8
+  %9 = load i32, i32* %i, align 4
+  %add5 = add nsw i32 %9, 2
+  %idxprom6 = sext i32 %add5 to i64
+  %arrayidx7 = getelementptr inbounds i8, i8* %8, i64 %idxprom6
+  %10 = load i8, i8* %arrayidx7, align 1
+  %conv8 = zext i8 %10 to i32
+  %shl9 = shl i32 %conv8, 16
+  %or10 = or i32 %or, %shl9
+  %11 = load i8*, i8** %buf.addr, align 8
+  %12 = load i32, i32* %i, align 4
+  %add11 = add nsw i32 %12, 3
+  %idxprom12 = sext i32 %add11 to i64
+  %arrayidx13 = getelementptr inbounds i8, i8* %11, i64 %idxprom12
+  %13 = load i8, i8* %arrayidx13, align 1
+  %conv14 = zext i8 %13 to i32
+  %shl15 = shl i32 %conv14, 24
+  %or16 = or i32 %or10, %shl15
+  store i32 %or16, i32* %w, align 4
+  %14 = load i32, i32* %w, align 4
+  %15 = load i32, i32* %h0, align 4
+  %xor = xor i32 %15, %14
+  store i32 %xor, i32* %h0, align 4
+  %16 = load i32, i32* %h0, align 4
+  %shr = lshr i32 %16, 7
+  %17 = load i32, i32* %h0, align 4
+  %shl17 = shl i32 %17, 25
+  %or18 = or i32 %shr, %shl17
+  %18 = load i32, i32* %h1, align 4
+  %add19 = add i32 %or18, %18
+  store i32 %add19, i32* %h0, align 4
+  %19 = load i32, i32* %h1, align 4
+  %shr20 = lshr i32 %19, 11
+  %20 = load i32, i32* %h1, align 4
+  %shl21 = shl i32 %20, 21
+  %or22 = or i32 %shr20, %shl21
+  %21 = load i32, i32* %h0, align 4
+  %add23 = add i32 %21, -1640531527
+  %xor24 = xor i32 %or22, %add23
+  store i32 %xor24, i32* %h1, align 4
+  br label %for.inc
+
+for.inc:                                          ; preds = %for.body
+  %22 = load i32, i32* %i, align 4
+  %add25 = add nsw i32 %22, 4
+  store i32 %add25, i32* %i, align 4
+  br label %for.cond
+
+for.end:                                          ; preds = %for.cond
+  %23 = load i32, i32* %h0, align 4
+  %24 = load i32, i32* %h1, align 4
+  %xor26 = xor i32 %23, %24
+  ret i32 %xor26
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @main(i32 %argc, i8** %argv) #0 {
+entry:
+  %retval = alloca i32, align 4
+  %argc.addr = alloca i32, align 4
+  %argv.addr = alloca i8**, align 8
+  %n = alloca i32, align 4
+  %buf = alloca i8*, align 8
+  %seed = alloca i32, align 4
+  %i = alloca i32, align 4
+  %check = alloca i32, align 4
+  %crc = alloca i32, align 4
+  %crc2 = alloca i32, align 4
+  %h = alloca i32, align 4
+  store i32 0, i32* %retval, align 4
+  store i32 %argc, i32* %argc.addr, align 4
+  store i8** %argv, i8*** %argv.addr, align 8
+  %0 = load i32, i32* %argc.addr, align 4
+  %cmp = icmp sgt i32 %0, 1
+  br i1 %cmp, label %cond.true, label %cond.false
+
+cond.true:                                        ; preds = %entry
+  %1 = load i8**, i8*** %argv.addr, align 8
+  %arrayidx = getelementptr inbounds i8*, i8** %1, i64 1
+  %2 = load i8*, i8** %arrayidx, align 8
+  %call = call i64 @strtol(i8* %2, i8** null, i32 0) #3
+  br label %cond.end
+
+cond.false:                                       ; preds = %entry
+  br label %cond.end
+
+cond.end:                                         ; preds = %cond.false, %cond.true
+  %cond = phi i64 [ %call, %cond.true ], [ 1048576, %cond.false ]
+  %conv = trunc i64 %cond to i32
+  store i32 %conv, i32* %n, align 4
+  %3 = load i32, i32* %n, align 4
+  %cmp1 = icmp sle i32 %3, 0
+  br i1 %cmp1, label %if.then, label %if.end
+
+if.then:                                          ; preds = %cond.end
+  %call2 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([16 x i8], [16 x i8]* @.str, i32 0, i32 0))
+  store i32 -1, i32* %retval, align 4
+  br label %return
+
+if.end:                                           ; preds = %cond.end
+  %4 = load i32, i32* %n, align 4
+  %conv3 = sext i32 %4 to i64
+  %call4 = call noalias i8* @malloc(i64 %conv3) #3
+  store i8* %call4, i8** %buf, align 8
+  store i32 1, i32* %seed, align 4
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc, %if.end
+  %5 = load i32, i32* %i, align 4
+  %6 = load i32, i32* %n, align 4
+  %cmp5 = icmp slt i32 %5, %6
+  br i1 %cmp5, label %for.body, label %for.end
+
+for.body:                                         ; preds = %for.cond
+  %7 = load i32, i32* %seed, align 4
+  %mul = mul i32 %7, 1103515245
+  %add = add i32 %mul, 12345
+  store i32 %add, i32* %seed, align 4
+  %8 = load i32, i32* %seed, align 4
+  %shr = lshr i32 %8, 16
+  %conv7 = trunc i32 %shr to i8
+  %9 = load i8*, i8** %buf, align 8
+  %10 = load i32, i32* %i, align 4
+  %idxprom = sext i32 %10 to i64
+  %arrayidx8 = getelementptr inbounds i8, i8* %9, i64 %idxprom
+  store i8 %conv7, i8* %arrayidx8, align 1
+  br label %for.inc
+
+for.inc:                                          ; preds = %for.body
+  %11 = load i32, i32* %i, align 4
+  %inc = add nsw i32 %11, 1
+  store i32 %inc, i32* %i, align 4
+  br label %for.cond
+
+for.end:                                          ; preds = %for.cond
+  call void @make_table()
+  %call9 = call i32 @crc32_table(i8* getelementptr inbounds ([10 x i8], [10 x i8]* @.str.1, i32 0, i32 0), i32 9)
+  store i32 %call9, i32* %check, align 4
+  %12 = load i8*, i8** %buf, align 8
+  %13 = load i32, i32* %n, align 4
+  %call10 = call i32 @crc32_table(i8* %12, i32 %13)
+  store i32 %call10, i32* %crc, align 4
+  %14 = load i8*, i8** %buf, align 8
+  %15 = load i32, i32* %n, align 4
+  %call11 = call i32 @crc32_bitwise(i8* %14, i32 %15)
+  store i32 %call11, i32* %crc2, align 4
+  %16 = load i8*, i8** %buf, align 8
+  %17 = load i32, i32* %n, align 4
+  %call12 = call i32 @mix(i8* %16, i32 %17)
+  store i32 %call12, i32* %h, align 4
+  %18 = load i32, i32* %crc, align 4
+  %19 = load i32, i32* %h, align 4
+  %call13 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([16 x i8], [16 x i8]* @.str.2, i32 0, i32 0), i32 %18, i32 %19)
+  %20 = load i8*, i8** %buf, align 8
+  call void @free(i8* %20) #3
+  %21 = load i32, i32* %check, align 4
+  %cmp14 = icmp ne i32 %21, -873187034
+  br i1 %cmp14, label %lor.end, label %lor.rhs
+
+lor.rhs:                                          ; preds = %for.end
+  %22 = load i32, i32* %crc, align 4
+  %23 = load i32, i32* %crc2, align 4
+  %cmp16 = icmp ne i32 %22, %23
+  br label %lor.end
+
+lor.end:                                          ; preds = %lor.rhs, %for.end
+  %24 = phi i1 [ true, %for.end ], [ %cmp16, %lor.rhs ]
+  %lor.ext = zext i1 %24 to i32
+  store i32 %lor.ext, i32* %retval, align 4
+  br label %return
+
+return:                                           ; preds = %lor.end, %if.then
+  %25 = load i32, i32* %retval, align 4
+  ret i32 %25
+}
+
+; Function Attrs: nounwind
+declare i64 @strtol(i8*, i8**, i32) #2
+
+declare i32 @printf(i8*, ...) #1
+
+; Function Attrs: nounwind
+declare noalias i8* @malloc(i64) #2
+
+; Function Attrs: nounwind
+declare void @free(i8*) #2
+
+attributes #0 = { nounwind uwtable "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #1 = { "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #2 = { nounwind "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #3 = { nounwind }
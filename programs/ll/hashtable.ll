@@ -0,0 +1,374 @@
+; ModuleID = 'programs/c/hashtable.c'
+source_filename = "programs/c/hashtable.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@.str = private unnamed_addr constant [22 x i8] c"Usage: hashtable [n]\0A\00", align 1
+@.str.1 = private unnamed_addr constant [18 x i8] c"hashtable: %d %d\0A\00", align 1
+
+; Function Attrs: nounwind uwtable
+define i32 @hash(i32 %key) #0 {
+entry:
+  %key.addr = alloca i32, align 4
+  store i32 %key, i32* %key.addr, align 4
+  %0 = load i32, i32* %key.addr, align 4
+  %shr = lshr i32 %0, 16
+  %1 = load i32, i32* %key.addr, align 4
+  %xor = xor i32 %1, %shr
+  store i32 %xor, i32* %key.addr, align 4
+  %2 = load i32, i32* %key.addr, align 4
+  %mul = mul i32 %2, 73244475
+  store i32 %mul, i32* %key.addr, align 4
+  %3 = load i32, i32* %key.addr, align 4
+  %shr1 = lshr i32 %3, 16
+  %4 = load i32, i32* %key.addr, align 4
+  %xor2 = xor i32 %4, %shr1
+  store i32 %xor2, i32* %key.addr, align 4
+  %5 = load i32, i32* %key.addr, align 4
+  ret i32 %5
+}
+
+; Function Attrs: nounwind uwtable
+define void @insert(i32* %keys, i32* %values, i32 %mask, i32 %key, i32 %value) #0 {
+entry:
+  %keys.addr = alloca i32*, align 8
+  %values.addr = alloca i32*, align 8
+  %mask.addr = alloca i32, align 4
+  %key.addr = alloca i32, align 4
+  %value.addr = alloca i32, align 4
+  %i = alloca i32, align 4
+  store i32* %keys, i32** %keys.addr, align 8
+  store i32* %values, i32** %values.addr, align 8
+  store i32 %mask, i32* %mask.addr, align 4
+  store i32 %key, i32* %key.addr, align 4
+  store i32 %value, i32* %value.addr, align 4
+  %0 = load i32, i32* %key.addr, align 4
+  %call = call i32 @hash(i32 %0)
+  %1 = load i32, i32* %mask.addr, align 4
+  %and = and i32 %call, %1
+  store i32 %and, i32* %i, align 4
+  br label %while.cond
+
+while.cond:                                       ; preds = %while.body, %entry
+  %2 = load i32*, i32** %keys.addr, align 8
+  %3 = load i32, i32* %i, align 4
+  %idxprom = zext i32 %3 to i64
+  %arrayidx = getelementptr inbounds i32, i32* %2, i64 %idxprom
+  %4 = load i32, i32* %arrayidx, align 4
+  %cmp = icmp ne i32 %4, 0
+  br i1 %cmp, label %land.rhs, label %land.end
+
+land.rhs:                                         ; preds = %while.cond
+  %5 = load i32*, i32** %keys.addr, align 8
+  %6 = load i32, i32* %i, align 4
+  %idxprom1 = zext i32 %6 to i64
+  %arrayidx2 = getelementptr inbounds i32, i32* %5, i64 %idxprom1
+  %7 = load i32, i32* %arrayidx2, align 4
+  %8 = load i32, i32* %key.addr, align 4
+  %cmp3 = icmp ne i32 %7, %8
+  br label %land.end
+
+land.end:                                         ; preds = %land.rhs, %while.cond
+  %9 = phi i1 [ false, %while.cond ], [ %cmp3, %land.rhs ]
+  br i1 %9, label %while.body, label %while.end
+
+while.body:                                       ; preds = %land.end
+  %10 = load i32, i32* %i, align 4
+  %add = add i32 %10, 1
+  %11 = load i32, i32* %mask.addr, align 4
+  %and4 = and i32 %add, %11
+  store i32 %and4, i32* %i, align 4
+  br label %while.cond
+
+while.end:                                        ; preds = %land.end
+  %12 = load i32, i32* %key.addr, align 4
+  %13 = load i32*, i32** %keys.addr, align 8
+  %14 = load i32, i32* %i, align 4
+  %idxprom5 = zext i32 %14 to i64
+  %arrayidx6 = getelementptr inbounds i32, i32* %13, i64 %idxprom5
+  store i32 %12, i32* %arrayidx6, align 4
+  %15 = load i32, i32* %value.addr, align 4
+  %16 = load i32*, i32** %values.addr, align 8
+  %17 = load i32, i32* %i, align 4
+  %idxprom7 = zext i32 %17 to i64
+  %arrayidx8 = getelementptr inbounds i32, i32* %16, i64 %idxprom7
+  store i32 %15, i32* %arrayidx8, align 4
+  ret void
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @lookup(i32* %keys, i32* %values, i32 %mask, i32 %key) #0 {
+entry:
+  %retval = alloca i32, align 4
+  %keys.addr = alloca i32*, align 8
+  %values.addr = alloca i32*, align 8
+  %mask.addr = alloca i32, align 4
+  %key.addr = alloca i32, align 4
+  %i = alloca i32, align 4
+  store i32* %keys, i32** %keys.addr, align 8
+  store i32* %values, i32** %values.addr, align 8
+  store i32 %mask, i32* %mask.addr, align 4
+  store i32 %key, i32* %key.addr, align 4
+  %0 = load i32, i32* %key.addr, align 4
+  %call = call i32 @hash(i32 %0)
+  %1 = load i32, i32* %mask.addr, align 4
+  %and = and i32 %call, %1
+  store i32 %and, i32* %i, align 4
+  br label %while.cond
+
+while.cond:                                       ; preds = %if.end, %entry
+  %2 = load i32*, i32** %keys.addr, align 8
+  %3 = load i32, i32* %i, align 4
+  %idxprom = zext i32 %3 to i64
+  %arrayidx = getelementptr inbounds i32, i32* %2, i64 %idxprom
+  %4 = load i32, i32* %arrayidx, align 4
+  %cmp = icmp ne i32 %4, 0
+  br i1 %cmp, label %while.body, label %while.end
+
+while.body:                                       ; preds = %while.cond
+  %5 = load i32*, i32** %keys.addr, align 8
+  %6 = load i32, i32* %i, align 4
+  %idxprom1 = zext i32 %6 to i64
+  %arrayidx2 = getelementptr inbounds i32, i32* %5, i64 %idxprom1
+  %7 = load i32, i32* %arrayidx2, align 4
+  %8 = load i32, i32* %key.addr, align 4
+  %cmp3 = icmp eq i32 %7, %8
+  br i1 %cmp3, label %if.then, label %if.end
+
+if.then:                                          ; preds = %while.body
+  %9 = load i32*, i32** %values.addr, align 8
+  %10 = load i32, i32* %i, align 4
+  %idxprom4 = zext i32 %10 to i64
+  %arrayidx5 = getelementptr inbounds i32, i32* %9, i64 %idxprom4
+  %11 = load i32, i32* %arrayidx5, align 4
+  store i32 %11, i32* %retval, align 4
+  br label %return
+
+if.end:                                           ; preds = %while.body
+  %12 = load i32, i32* %i, align 4
+  %add = add i32 %12, 1
+  %13 = load i32, i32* %mask.addr, align 4
+  %and6 = and i32 %add, %13
+  store i32 %and6, i32* %i, align 4
+  br label %while.cond
+
+while.end:                                        ; preds = %while.cond
+  store i32 -1, i32* %retval, align 4
+  br label %return
+
+return:                                           ; preds = %while.end, %if.then
+  %14 = load i32, i32* %retval, align 4
+  ret i32 %14
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @main(i32 %argc, i8** %argv) #0 {
+entry:
+  %retval = alloca i32, align 4
+  %argc.addr = alloca i32, align 4
+  %argv.addr = alloca i8**, align 8
+  %n = alloca i32, align 4
+  %capacity = alloca i32, align 4
+  %keys = alloca i32*, align 8
+  %values = alloca i32*, align 8
+  %i = alloca i32, align 4
+  %found = alloca i32, align 4
+  %missing = alloca i32, align 4
+  %i20 = alloca i32, align 4
+  store i32 0, i32* %retval, align 4
+  store i32 %argc, i32* %argc.addr, align 4
+  store i8** %argv, i8*** %argv.addr, align 8
+  %0 = load i32, i32* %argc.addr, align 4
+  %cmp = icmp sgt i32 %0, 1
+  br i1 %cmp, label %cond.true, label %cond.false
+
+cond.true:                                        ; preds = %entry
+  %1 = load i8**, i8*** %argv.addr, align 8
+  %arrayidx = getelementptr inbounds i8*, i8** %1, i64 1
+  %2 = load i8*, i8** %arrayidx, align 8
+  %call = call i64 @strtol(i8* %2, i8** null, i32 0) #3
+  br label %cond.end
+
+cond.false:                                       ; preds = %entry
+  br label %cond.end
+
+cond.end:                                         ; preds = %cond.false, %cond.true
+  %cond = phi i64 [ %call, %cond.true ], [ 500000, %cond.false ]
+  %conv = trunc i64 %cond to i32
+  store i32 %conv, i32* %n, align 4
+  %3 = load i32, i32* %n, align 4
+  %cmp1 = icmp sle i32 %3, 0
+  br i1 %cmp1, label %if.then, label %if.end
+
+if.then:                                          ; preds = %cond.end
+  %call2 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([22 x i8], [22 x i8]* @.str, i32 0, i32 0))
+  store i32 -1, i32* %retval, align 4
+  br label %return
+
+if.end:                                           ; preds = %cond.end
+  store i32 1, i32* %capacity, align 4
+  br label %while.cond
+
+while.cond:                                       ; preds = %while.body, %if.end
+  %4 = load i32, i32* %capacity, align 4
+  %5 = load i32, i32* %n, align 4
+  %mul = mul nsw i32 2, %5
+  %cmp3 = icmp ult i32 %4, %mul
+  br i1 %cmp3, label %while.body, label %while.end
+
+while.body:                                       ; preds = %while.cond
+  %6 = load i32, i32* %capacity, align 4
+  %shl = shl i32 %6, 1
+  store i32 %shl, i32* %capacity, align 4
+  br label %while.cond
+
+while.end:                                        ; preds = %while.cond
+  %7 = load i32, i32* %capacity, align 4
+  %conv5 = zext i32 %7 to i64
+  %call6 = call noalias i8* @calloc(i64 %conv5, i64 4) #3
+  %8 = bitcast i8* %call6 to i32*
+  store i32* %8, i32** %keys, align 8
+  %9 = load i32, i32* %capacity, align 4
+  %conv7 = zext i32 %9 to i64
+  %mul8 = mul i64 %conv7, 4
+  %call9 = call noalias i8* @malloc(i64 %mul8) #3
+  %10 = bitcast i8* %call9 to i32*
+  store i32* %10, i32** %values, align 8
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc, %while.end
+  %11 = load i32, i32* %i, align 4
+  %12 = load i32, i32* %n, align 4
+  %cmp10 = icmp slt i32 %11, %12
+  br i1 %cmp10, label %for.body, label %for.end
+
+for.body:                                         ; preds = %for.cond
+  %13 = load i32*, i32** %keys, align 8
+  %14 = load i32*, i32** %values, align 8
+  %15 = load i32, i32* %capacity, align 4
+  %sub = sub i32 %15, 1
+  %16 = load i32, i32* %i, align 4
+  %mul12 = mul nsw i32 2, %16
+  %add = add nsw i32 %mul12, 1
+  %mul13 = mul i32 %add, -1640531535
+  %17 = load i32, i32* %i, align 4
+  call void @insert(i32* %13, i32* %14, i32 %sub, i32 %mul13, i32 %17)
+  br label %for.inc
+
+for.inc:                                          ; preds = %for.body
+  %18 = load i32, i32* %i, align 4
+  %inc = add nsw i32 %18, 1
+  store i32 %inc, i32* %i, align 4
+  br label %for.cond
+
+for.end:                                          ; preds = %for.cond
+  store i32 0, i32* %found, align 4
+  store i32 0, i32* %missing, align 4
+  store i32 0, i32* %i20, align 4
+  br label %for.cond14
+
+for.cond14:                                       ; preds = %for.inc39, %for.end
+  %19 = load i32, i32* %i20, align 4
+  %20 = load i32, i32* %n, align 4
+  %cmp15 = icmp slt i32 %19, %20
+  br i1 %cmp15, label %for.body17, label %for.end38
+
+for.body17:                                       ; preds = %for.cond14
+  %21 = load i32*, i32** %keys, align 8
+  %22 = load i32*, i32** %values, align 8
+  %23 = load i32, i32* %capacity, align 4
+  %sub18 = sub i32 %23, 1
+  %24 = load i32, i32* %i20, align 4
+  %mul19 = mul nsw i32 2, %24
+  %add21 = add nsw i32 %mul19, 1
+  %mul22 = mul i32 %add21, -1640531535
+  %call23 = call i32 @lookup(i32* %21, i32* %22, i32 %sub18, i32 %mul22)
+  %25 = load i32, i32* %i20, align 4
+  %cmp24 = icmp eq i32 %call23, %25
+  br i1 %cmp24, label %if.then26, label %if.end27
+
+if.then26:                                        ; preds = %for.body17
+  %26 = load i32, i32* %found, align 4
+  %inc27 = add nsw i32 %26, 1
+  store i32 %inc27, i32* %found, align 4
+  br label %if.end27
+
+if.end27:                                         ; preds = %if.then26, %for.body17
+  %27 = load i32*, i32** %keys, align 8
+  %28 = load i32*, i32** %values, align 8
+  %29 = load i32, i32* %capacity, align 4
+  %sub28 = sub i32 %29, 1
+  %30 = load i32, i32* %i20, align 4
+  %mul29 = mul nsw i32 2, %30
+  %add30 = add nsw i32 %mul29, 2
+  %mul31 = mul i32 %add30, -1640531535
+  %call32 = call i32 @lookup(i32* %27, i32* %28, i32 %sub28, i32 %mul31)
+  %cmp33 = icmp eq i32 %call32, -1
+  br i1 %cmp33, label %if.then35, label %if.end37
+
+if.then35:                                        ; preds = %if.end27
+  %31 = load i32, i32* %missing, align 4
+  %inc36 = add nsw i32 %31, 1
+  store i32 %inc36, i32* %missing, align 4
+  br label %if.end37
+
+if.end37:                                         ; preds = %if.then35, %if.end27
+  br label %for.inc39
+
+for.inc39:                                        ; preds = %if.end37
+  %32 = load i32, i32* %i20, align 4
+  %inc40 = add nsw i32 %32, 1
+  store i32 %inc40, i32* %i20, align 4
+  br label %for.cond14
+
+for.end38:                                        ; preds = %for.cond14
+  %33 = load i32, i32* %found, align 4
+  %34 = load i32, i32* %missing, align 4
+  %call41 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([18 x i8], [18 x i8]* @.str.1, i32 0, i32 0), i32 %33, i32 %34)
+  %35 = load i32*, i32** %keys, align 8
+  %36 = bitcast i32* %35 to i8*
+  call void @free(i8* %36) #3
+  %37 = load i32*, i32** %values, align 8
+  %38 = bitcast i32* %37 to i8*
+  call void @free(i8* %38) #3
+  %39 = load i32, i32* %found, align 4
+  %40 = load i32, i32* %n, align 4
+  %cmp42 = icmp ne i32 %39, %40
+  br i1 %cmp42, label %lor.end, label %lor.rhs
+
+lor.rhs:                                          ; preds = %for.end38
+  %41 = load i32, i32* %missing, align 4
+  %42 = load i32, i32* %n, align 4
+  %cmp44 = icmp ne i32 %41, %42
+  br label %lor.end
+
+lor.end:                                          ; preds = %lor.rhs, %for.end38
+  %43 = phi i1 [ true, %for.end38 ], [ %cmp44, %lor.rhs ]
+  %lor.ext = zext i1 %43 to i32
+  store i32 %lor.ext, i32* %retval, align 4
+  br label %return
+
+return:                                           ; preds = %lor.end, %if.then
+  %44 = load i32, i32* %retval, align 4
+  ret i32 %44
+}
+
+; Function Attrs: nounwind
+declare i64 @strtol(i8*, i8**, i32) #2
+
+declare i32 @printf(i8*, ...) #1
+
+; Function Attrs: nounwind
+declare noalias i8* @calloc(i64, i64) #2
+
+; Function Attrs: nounwind
+declare noalias i8* @malloc(i64) #2
+
+; Function Attrs: nounwind
+declare void @free(i8*) #2
+
+attributes #0 = { nounwind uwtable "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #1 = { "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #2 = { nounwind "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #3 = { nounwind }
@@ -0,0 +1,339 @@
+; ModuleID = 'programs/c/interp.c'
+source_filename = "programs/c/interp.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@code = global [38 x i32] [i32 0, i32 0, i32 2, i32 0, i32 1, i32 2, i32 2, i32 1, i32 0, i32 0, i32 1, i32 1, i32 7, i32 8, i32 37, i32 1, i32 0, i32 1, i32 1, i32 1, i32 1, i32 5, i32 3, i32 0, i32 1000003, i32 6, i32 2, i32 0, i32 1, i32 1, i32 0, i32 1, i32 4, i32 2, i32 1, i32 9, i32 8, i32 10], align 16
+@.str = private unnamed_addr constant [19 x i8] c"Usage: interp [n]\0A\00", align 1
+@.str.1 = private unnamed_addr constant [12 x i8] c"interp: %u\0A\00", align 1
+
+; Function Attrs: nounwind uwtable
+define i32 @run(i32* %code, i32* %vars) #0 {
+entry:
+  %code.addr = alloca i32*, align 8
+  %vars.addr = alloca i32*, align 8
+  %stack = alloca [16 x i32], align 16
+  %sp = alloca i32, align 4
+  %pc = alloca i32, align 4
+  store i32* %code, i32** %code.addr, align 8
+  store i32* %vars, i32** %vars.addr, align 8
+  store i32 0, i32* %sp, align 4
+  store i32 0, i32* %pc, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %sw.epilog, %entry
+  %0 = load i32*, i32** %code.addr, align 8
+  %1 = load i32, i32* %pc, align 4
+  %inc = add nsw i32 %1, 1
+  store i32 %inc, i32* %pc, align 4
+  %idxprom = sext i32 %1 to i64
+  %arrayidx = getelementptr inbounds i32, i32* %0, i64 %idxprom
+  %2 = load i32, i32* %arrayidx, align 4
+  switch i32 %2, label %sw.default [
+    i32 0, label %sw.bb
+    i32 1, label %sw.bb5
+    i32 2, label %sw.bb14
+    i32 3, label %sw.bb22
+    i32 4, label %sw.bb29
+    i32 5, label %sw.bb37
+    i32 6, label %sw.bb45
+    i32 7, label %sw.bb53
+    i32 8, label %sw.bb63
+    i32 9, label %sw.bb75
+  ]
+
+sw.bb:                                            ; preds = %for.cond
+  %3 = load i32*, i32** %code.addr, align 8
+  %4 = load i32, i32* %pc, align 4
+  %inc1 = add nsw i32 %4, 1
+  store i32 %inc1, i32* %pc, align 4
+  %idxprom2 = sext i32 %4 to i64
+  %arrayidx3 = getelementptr inbounds i32, i32* %3, i64 %idxprom2
+  %5 = load i32, i32* %arrayidx3, align 4
+  %6 = load i32, i32* %sp, align 4
+  %inc4 = add nsw i32 %6, 1
+  store i32 %inc4, i32* %sp, align 4
+  %idxprom5 = sext i32 %6 to i64
+  %arrayidx6 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom5
+  store i32 %5, i32* %arrayidx6, align 4
+  br label %sw.epilog
+
+sw.bb5:                                           ; preds = %for.cond
+  %7 = load i32*, i32** %vars.addr, align 8
+  %8 = load i32*, i32** %code.addr, align 8
+  %9 = load i32, i32* %pc, align 4
+  %inc7 = add nsw i32 %9, 1
+  store i32 %inc7, i32* %pc, align 4
+  %idxprom8 = sext i32 %9 to i64
+  %arrayidx9 = getelementptr inbounds i32, i32* %8, i64 %idxprom8
+  %10 = load i32, i32* %arrayidx9, align 4
+  %idxprom10 = sext i32 %10 to i64
+  %arrayidx11 = getelementptr inbounds i32, i32* %7, i64 %idxprom10
+  %11 = load i32, i32* %arrayidx11, align 4
+  %12 = load i32, i32* %sp, align 4
+  %inc12 = add nsw i32 %12, 1
+  store i32 %inc12, i32* %sp, align 4
+  %idxprom13 = sext i32 %12 to i64
+  %arrayidx14 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom13
+  store i32 %11, i32* %arrayidx14, align 4
+  br label %sw.epilog
+
+sw.bb14:                                          ; preds = %for.cond
+  %13 = load i32, i32* %sp, align 4
+  %dec = add nsw i32 %13, -1
+  store i32 %dec, i32* %sp, align 4
+  %idxprom15 = sext i32 %dec to i64
+  %arrayidx16 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom15
+  %14 = load i32, i32* %arrayidx16, align 4
+  %15 = load i32*, i32** %vars.addr, align 8
+  %16 = load i32*, i32** %code.addr, align 8
+  %17 = load i32, i32* %pc, align 4
+  %inc17 = add nsw i32 %17, 1
+  store i32 %inc17, i32* %pc, align 4
+  %idxprom18 = sext i32 %17 to i64
+  %arrayidx19 = getelementptr inbounds i32, i32* %16, i64 %idxprom18
+  %18 = load i32, i32* %arrayidx19, align 4
+  %idxprom20 = sext i32 %18 to i64
+  %arrayidx21 = getelementptr inbounds i32, i32* %15, i64 %idxprom20
+  store i32 %14, i32* %arrayidx21, align 4
+  br label %sw.epilog
+
+sw.bb22:                                          ; preds = %for.cond
+  %19 = load i32, i32* %sp, align 4
+  %dec23 = add nsw i32 %19, -1
+  store i32 %dec23, i32* %sp, align 4
+  %20 = load i32, i32* %sp, align 4
+  %idxprom24 = sext i32 %20 to i64
+  %arrayidx25 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom24
+  %21 = load i32, i32* %arrayidx25, align 4
+  %22 = load i32, i32* %sp, align 4
+  %sub = sub nsw i32 %22, 1
+  %idxprom26 = sext i32 %sub to i64
+  %arrayidx27 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom26
+  %23 = load i32, i32* %arrayidx27, align 4
+  %add = add i32 %23, %21
+  store i32 %add, i32* %arrayidx27, align 4
+  br label %sw.epilog
+
+sw.bb29:                                          ; preds = %for.cond
+  %24 = load i32, i32* %sp, align 4
+  %dec30 = add nsw i32 %24, -1
+  store i32 %dec30, i32* %sp, align 4
+  %25 = load i32, i32* %sp, align 4
+  %idxprom31 = sext i32 %25 to i64
+  %arrayidx32 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom31
+  %26 = load i32, i32* %arrayidx32, align 4
+  %27 = load i32, i32* %sp, align 4
+  %sub33 = sub nsw i32 %27, 1
+  %idxprom34 = sext i32 %sub33 to i64
+  %arrayidx35 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom34
+  %28 = load i32, i32* %arrayidx35, align 4
+  %sub36 = sub i32 %28, %26
+  store i32 %sub36, i32* %arrayidx35, align 4
+  br label %sw.epilog
+
+sw.bb37:                                          ; preds = %for.cond
+  %29 = load i32, i32* %sp, align 4
+  %dec38 = add nsw i32 %29, -1
+  store i32 %dec38, i32* %sp, align 4
+  %30 = load i32, i32* %sp, align 4
+  %idxprom39 = sext i32 %30 to i64
+  %arrayidx40 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom39
+  %31 = load i32, i32* %arrayidx40, align 4
+  %32 = load i32, i32* %sp, align 4
+  %sub41 = sub nsw i32 %32, 1
+  %idxprom42 = sext i32 %sub41 to i64
+  %arrayidx43 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom42
+  %33 = load i32, i32* %arrayidx43, align 4
+  %mul = mul i32 %33, %31
+  store i32 %mul, i32* %arrayidx43, align 4
+  br label %sw.epilog
+
+sw.bb45:                                          ; preds = %for.cond
+  %34 = load i32, i32* %sp, align 4
+  %dec46 = add nsw i32 %34, -1
+  store i32 %dec46, i32* %sp, align 4
+  %35 = load i32, i32* %sp, align 4
+  %idxprom47 = sext i32 %35 to i64
+  %arrayidx48 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom47
+  %36 = load i32, i32* %arrayidx48, align 4
+  %37 = load i32, i32* %sp, align 4
+  %sub49 = sub nsw i32 %37, 1
+  %idxprom50 = sext i32 %sub49 to i64
+  %arrayidx51 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom50
+  %38 = load i32, i32* %arrayidx51, align 4
+  %rem = urem i32 %38, %36
+  store i32 %rem, i32* %arrayidx51, align 4
+  br label %sw.epilog
+
+sw.bb53:                                          ; preds = %for.cond
+  %39 = load i32, i32* %sp, align 4
+  %dec54 = add nsw i32 %39, -1
+  store i32 %dec54, i32* %sp, align 4
+  %40 = load i32, i32* %sp, align 4
+  %sub55 = sub nsw i32 %40, 1
+  %idxprom56 = sext i32 %sub55 to i64
+  %arrayidx57 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom56
+  %41 = load i32, i32* %arrayidx57, align 4
+  %42 = load i32, i32* %sp, align 4
+  %idxprom58 = sext i32 %42 to i64
+  %arrayidx59 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom58
+  %43 = load i32, i32* %arrayidx59, align 4
+  %cmp = icmp ult i32 %41, %43
+  %conv = zext i1 %cmp to i32
+  %44 = load i32, i32* %sp, align 4
+  %sub60 = sub nsw i32 %44, 1
+  %idxprom61 = sext i32 %sub60 to i64
+  %arrayidx62 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom61
+  store i32 %conv, i32* %arrayidx62, align 4
+  br label %sw.epilog
+
+sw.bb63:                                          ; preds = %for.cond
+  %45 = load i32, i32* %sp, align 4
+  %dec64 = add nsw i32 %45, -1
+  store i32 %dec64, i32* %sp, align 4
+  %idxprom65 = sext i32 %dec64 to i64
+  %arrayidx66 = getelementptr inbounds [16 x i32], [16 x i32]* %stack, i64 0, i64 %idxprom65
+  %46 = load i32, i32* %arrayidx66, align 4
+  %cmp67 = icmp eq i32 %46, 0
+  br i1 %cmp67, label %if.then, label %if.else
+
+if.then:                                          ; preds = %sw.bb63
+  %47 = load i32*, i32** %code.addr, align 8
+  %48 = load i32, i32* %pc, align 4
+  %idxprom69 = sext i32 %48 to i64
+  %arrayidx70 = getelementptr inbounds i32, i32* %47, i64 %idxprom69
+  %49 = load i32, i32* %arrayidx70, align 4
+  store i32 %49, i32* %pc, align 4
+  br label %if.end
+
+if.else:                                          ; preds = %sw.bb63
+  %50 = load i32, i32* %pc, align 4
+  %inc71 = add nsw i32 %50, 1
+  store i32 %inc71, i32* %pc, align 4
+  br label %if.end
+
+if.end:                                           ; preds = %if.else, %if.then
+  br label %sw.epilog
+
+sw.bb75:                                          ; preds = %for.cond
+  %51 = load i32*, i32** %code.addr, align 8
+  %52 = load i32, i32* %pc, align 4
+  %idxprom76 = sext i32 %52 to i64
+  %arrayidx77 = getelementptr inbounds i32, i32* %51, i64 %idxprom76
+  %53 = load i32, i32* %arrayidx77, align 4
+  store i32 %53, i32* %pc, align 4
+  br label %sw.epilog
+
+sw.default:                                       ; preds = %for.cond
+  %54 = load i32*, i32** %vars.addr, align 8
+  %arrayidx78 = getelementptr inbounds i32, i32* %54, i64 0
+  %55 = load i32, i32* %arrayidx78, align 4
+  ret i32 %55
+
+sw.epilog:                                        ; preds = %sw.bb75, %if.end, %sw.bb53, %sw.bb45, %sw.bb37, %sw.bb29, %sw.bb22, %sw.bb14, %sw.bb5, %sw.bb
+  br label %for.cond
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @main(i32 %argc, i8** %argv) #0 {
+entry:
+  %retval = alloca i32, align 4
+  %argc.addr = alloca i32, align 4
+  %argv.addr = alloca i8**, align 8
+  %n = alloca i32, align 4
+  %vars = alloca [3 x i32], align 4
+  %sum = alloca i32, align 4
+  %check = alloca i32, align 4
+  %i = alloca i32, align 4
+  store i32 0, i32* %retval, align 4
+  store i32 %argc, i32* %argc.addr, align 4
+  store i8** %argv, i8*** %argv.addr, align 8
+  %0 = load i32, i32* %argc.addr, align 4
+  %cmp = icmp sgt i32 %0, 1
+  br i1 %cmp, label %cond.true, label %cond.false
+
+cond.true:                                        ; preds = %entry
+  %1 = load i8**, i8*** %argv.addr, align 8
+  %arrayidx = getelementptr inbounds i8*, i8** %1, i64 1
+  %2 = load i8*, i8** %arrayidx, align 8
+  %call = call i64 @strtol(i8* %2, i8** null, i32 0) #3
+  br label %cond.end
+
+cond.false:                                       ; preds = %entry
+  br label %cond.end
+
+cond.end:                                         ; preds = %cond.false, %cond.true
+  %cond = phi i64 [ %call, %cond.true ], [ 2000000, %cond.false ]
+  %conv = trunc i64 %cond to i32
+  store i32 %conv, i32* %n, align 4
+  %3 = load i32, i32* %n, align 4
+  %cmp1 = icmp sle i32 %3, 0
+  br i1 %cmp1, label %if.then, label %if.end
+
+if.then:                                          ; preds = %cond.end
+  %call2 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([19 x i8], [19 x i8]* @.str, i32 0, i32 0))
+  store i32 -1, i32* %retval, align 4
+  br label %return
+
+if.end:                                           ; preds = %cond.end
+  %arrayinit.begin = getelementptr inbounds [3 x i32], [3 x i32]* %vars, i64 0, i64 0
+  store i32 0, i32* %arrayinit.begin, align 4
+  %arrayinit.element = getelementptr inbounds i32, i32* %arrayinit.begin, i64 1
+  store i32 0, i32* %arrayinit.element, align 4
+  %arrayinit.element3 = getelementptr inbounds i32, i32* %arrayinit.element, i64 1
+  %4 = load i32, i32* %n, align 4
+  store i32 %4, i32* %arrayinit.element3, align 4
+  %arraydecay = getelementptr inbounds [3 x i32], [3 x i32]* %vars, i32 0, i32 0
+  %call4 = call i32 @run(i32* getelementptr inbounds ([38 x i32], [38 x i32]* @code, i32 0, i32 0), i32* %arraydecay)
+  store i32 %call4, i32* %sum, align 4
+  store i32 0, i32* %check, align 4
+  %5 = load i32, i32* %n, align 4
+  store i32 %5, i32* %i, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc, %if.end
+  %6 = load i32, i32* %i, align 4
+  %cmp5 = icmp ult i32 0, %6
+  br i1 %cmp5, label %for.body, label %for.end
+
+for.body:                                         ; preds = %for.cond
+  %7 = load i32, i32* %check, align 4
+  %8 = load i32, i32* %i, align 4
+  %9 = load i32, i32* %i, align 4
+  %mul = mul i32 %8, %9
+  %add = add i32 %7, %mul
+  %rem = urem i32 %add, 1000003
+  store i32 %rem, i32* %check, align 4
+  br label %for.inc
+
+for.inc:                                          ; preds = %for.body
+  %10 = load i32, i32* %i, align 4
+  %dec = add i32 %10, -1
+  store i32 %dec, i32* %i, align 4
+  br label %for.cond
+
+for.end:                                          ; preds = %for.cond
+  %11 = load i32, i32* %sum, align 4
+  %call7 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([12 x i8], [12 x i8]* @.str.1, i32 0, i32 0), i32 %11)
+  %12 = load i32, i32* %sum, align 4
+  %13 = load i32, i32* %check, align 4
+  %cmp8 = icmp ne i32 %12, %13
+  %conv9 = zext i1 %cmp8 to i32
+  store i32 %conv9, i32* %retval, align 4
+  br label %return
+
+return:                                           ; preds = %for.end, %if.then
+  %14 = load i32, i32* %retval, align 4
+  ret i32 %14
+}
+
+; Function Attrs: nounwind
+declare i64 @strtol(i8*, i8**, i32) #2
+
+declare i32 @printf(i8*, ...) #1
+
+attributes #0 = { nounwind uwtable "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #1 = { "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #2 = { nounwind "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #3 = { nounwind }
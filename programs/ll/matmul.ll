@@ -0,0 +1,384 @@
+; ModuleID = 'programs/c/matmul.c'
+source_filename = "programs/c/matmul.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@.str = private unnamed_addr constant [19 x i8] c"Usage: matmul [n]\0A\00", align 1
+@.str.1 = private unnamed_addr constant [12 x i8] c"matmul: %u\0A\00", align 1
+
+; Function Attrs: nounwind uwtable
+define void @init(i32* %m, i32 %n, i32 %seed) #0 {
+entry:
+  %m.addr = alloca i32*, align 8
+  %n.addr = alloca i32, align 4
+  %seed.addr = alloca i32, align 4
+  %i = alloca i32, align 4
+  store i32* %m, i32** %m.addr, align 8
+  store i32 %n, i32* %n.addr, align 4
+  store i32 %seed, i32* %seed.addr, align 4
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc, %entry
+  %0 = load i32, i32* %i, align 4
+  %1 = load i32, i32* %n.addr, align 4
+  %2 = load i32, i32* %n.addr, align 4
+  %mul = mul nsw i32 %1, %2
+  %cmp = icmp slt i32 %0, %mul
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:                                         ; preds = %for.cond
+  %3 = load i32, i32* %seed.addr, align 4
+  %mul1 = mul i32 %3, 1103515245
+  %add = add i32 %mul1, 12345
+  store i32 %add, i32* %seed.addr, align 4
+  %4 = load i32, i32* %seed.addr, align 4
+  %shr = lshr i32 %4, 16
+  %rem = urem i32 %shr, 100
+  %5 = load i32*, i32** %m.addr, align 8
+  %6 = load i32, i32* %i, align 4
+  %idxprom = sext i32 %6 to i64
+  %arrayidx = getelementptr inbounds i32, i32* %5, i64 %idxprom
+  store i32 %rem, i32* %arrayidx, align 4
+  br label %for.inc
+
+for.inc:                                          ; preds = %for.body
+  %7 = load i32, i32* %i, align 4
+  %inc = add nsw i32 %7, 1
+  store i32 %inc, i32* %i, align 4
+  br label %for.cond
+
+for.end:                                          ; preds = %for.cond
+  ret void
+}
+
+; Function Attrs: nounwind uwtable
+define void @matmul(i32* %a, i32* %b, i32* %c, i32 %n) #0 {
+entry:
+  %a.addr = alloca i32*, align 8
+  %b.addr = alloca i32*, align 8
+  %c.addr = alloca i32*, align 8
+  %n.addr = alloca i32, align 4
+  %i = alloca i32, align 4
+  %j = alloca i32, align 4
+  %sum = alloca i32, align 4
+  %k = alloca i32, align 4
+  store i32* %a, i32** %a.addr, align 8
+  store i32* %b, i32** %b.addr, align 8
+  store i32* %c, i32** %c.addr, align 8
+  store i32 %n, i32* %n.addr, align 4
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc20, %entry
+  %0 = load i32, i32* %i, align 4
+  %1 = load i32, i32* %n.addr, align 4
+  %cmp = icmp slt i32 %0, %1
+  br i1 %cmp, label %for.body, label %for.end22
+
+for.body:                                         ; preds = %for.cond
+  store i32 0, i32* %j, align 4
+  br label %for.cond1
+
+for.cond1:                                        ; preds = %for.inc17, %for.body
+  %2 = load i32, i32* %j, align 4
+  %3 = load i32, i32* %n.addr, align 4
+  %cmp2 = icmp slt i32 %2, %3
+  br i1 %cmp2, label %for.body3, label %for.end19
+
+for.body3:                                        ; preds = %for.cond1
+  store i32 0, i32* %sum, align 4
+  store i32 0, i32* %k, align 4
+  br label %for.cond4
+
+for.cond4:                                        ; preds = %for.inc, %for.body3
+  %4 = load i32, i32* %k, align 4
+  %5 = load i32, i32* %n.addr, align 4
+  %cmp5 = icmp slt i32 %4, %5
+  br i1 %cmp5, label %for.body6, label %for.end
+
+for.body6:                                        ; preds = %for.cond4
+  %6 = load i32*, i32** %a.addr, align 8
+  %7 = load i32, i32* %i, align 4
+  %8 = load i32, i32* %n.addr, align 4
+  %mul = mul nsw i32 %7, %8
+  %9 = load i32, i32* %k, align 4
+  %add = add nsw i32 %mul, %9
+  %idxprom = sext i32 %add to i64
+  %arrayidx = getelementptr inbounds i32, i32* %6, i64 %idxprom
+  %10 = load i32, i32* %arrayidx, align 4
+  %11 = load i32*, i32** %b.addr, align 8
+  %12 = load i32, i32* %k, align 4
+  %13 = load i32, i32* %n.addr, align 4
+  %mul7 = mul nsw i32 %12, %13
+  %14 = load i32, i32* %j, align 4
+  %add8 = add nsw i32 %mul7, %14
+  %idxprom9 = sext i32 %add8 to i64
+  %arrayidx10 = getelementptr inbounds i32, i32* %11, i64 %idxprom9
+  %15 = load i32, i32* %arrayidx10, align 4
+  %mul11 = mul nsw i32 %10, %15
+  %16 = load i32, i32* %sum, align 4
+  %add12 = add nsw i32 %16, %mul11
+  store i32 %add12, i32* %sum, align 4
+  br label %for.inc
+
+for.inc:                                          ; preds = %for.body6
+  %17 = load i32, i32* %k, align 4
+  %inc = add nsw i32 %17, 1
+  store i32 %inc, i32* %k, align 4
+  br label %for.cond4
+
+for.end:                                          ; preds = %for.cond4
+  %18 = load i32, i32* %sum, align 4
+  %19 = load i32*, i32** %c.addr, align 8
+  %20 = load i32, i32* %i, align 4
+  %21 = load i32, i32* %n.addr, align 4
+  %mul13 = mul nsw i32 %20, %21
+  %22 = load i32, i32* %j, align 4
+  %add14 = add nsw i32 %mul13, %22
+  %idxprom15 = sext i32 %add14 to i64
+  %arrayidx16 = getelementptr inbounds i32, i32* %19, i64 %idxprom15
+  store i32 %18, i32* %arrayidx16, align 4
+  br label %for.inc17
+
+for.inc17:                                        ; preds = %for.end
+  %23 = load i32, i32* %j, align 4
+  %inc18 = add nsw i32 %23, 1
+  store i32 %inc18, i32* %j, align 4
+  br label %for.cond1
+
+for.end19:                                        ; preds = %for.cond1
+  br label %for.inc20
+
+for.inc20:                                        ; preds = %for.end19
+  %24 = load i32, i32* %i, align 4
+  %inc21 = add nsw i32 %24, 1
+  store i32 %inc21, i32* %i, align 4
+  br label %for.cond
+
+for.end22:                                        ; preds = %for.cond
+  ret void
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @main(i32 %argc, i8** %argv) #0 {
+entry:
+  %retval = alloca i32, align 4
+  %argc.addr = alloca i32, align 4
+  %argv.addr = alloca i8**, align 8
+  %n = alloca i32, align 4
+  %a = alloca i32*, align 8
+  %b = alloca i32*, align 8
+  %c = alloca i32*, align 8
+  %sum = alloca i32, align 4
+  %i = alloca i32, align 4
+  %check = alloca i32, align 4
+  %k = alloca i32, align 4
+  %col = alloca i32, align 4
+  %row = alloca i32, align 4
+  %i31 = alloca i32, align 4
+  store i32 0, i32* %retval, align 4
+  store i32 %argc, i32* %argc.addr, align 4
+  store i8** %argv, i8*** %argv.addr, align 8
+  %0 = load i32, i32* %argc.addr, align 4
+  %cmp = icmp sgt i32 %0, 1
+  br i1 %cmp, label %cond.true, label %cond.false
+
+cond.true:                                        ; preds = %entry
+  %1 = load i8**, i8*** %argv.addr, align 8
+  %arrayidx = getelementptr inbounds i8*, i8** %1, i64 1
+  %2 = load i8*, i8** %arrayidx, align 8
+  %call = call i64 @strtol(i8* %2, i8** null, i32 0) #3
+  br label %cond.end
+
+cond.false:                                       ; preds = %entry
+  br label %cond.end
+
+cond.end:                                         ; preds = %cond.false, %cond.true
+  %cond = phi i64 [ %call, %cond.true ], [ 128, %cond.false ]
+  %conv = trunc i64 %cond to i32
+  store i32 %conv, i32* %n, align 4
+  %3 = load i32, i32* %n, align 4
+  %cmp1 = icmp sle i32 %3, 0
+  br i1 %cmp1, label %if.then, label %if.end
+
+if.then:                                          ; preds = %cond.end
+  %call2 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([19 x i8], [19 x i8]* @.str, i32 0, i32 0))
+  store i32 -1, i32* %retval, align 4
+  br label %return
+
+if.end:                                           ; preds = %cond.end
+  %4 = load i32, i32* %n, align 4
+  %5 = load i32, i32* %n, align 4
+  %mul = mul nsw i32 %4, %5
+  %conv3 = sext i32 %mul to i64
+  %mul4 = mul i64 %conv3, 4
+  %call5 = call noalias i8* @malloc(i64 %mul4) #3
+  %6 = bitcast i8* %call5 to i32*
+  store i32* %6, i32** %a, align 8
+  %7 = load i32, i32* %n, align 4
+  %8 = load i32, i32* %n, align 4
+  %mul6 = mul nsw i32 %7, %8
+  %conv7 = sext i32 %mul6 to i64
+  %mul8 = mul i64 %conv7, 4
+  %call9 = call noalias i8* @malloc(i64 %mul8) #3
+  %9 = bitcast i8* %call9 to i32*
+  store i32* %9, i32** %b, align 8
+  %10 = load i32, i32* %n, align 4
+  %11 = load i32, i32* %n, align 4
+  %mul10 = mul nsw i32 %10, %11
+  %conv11 = sext i32 %mul10 to i64
+  %mul12 = mul i64 %conv11, 4
+  %call13 = call noalias i8* @malloc(i64 %mul12) #3
+  %12 = bitcast i8* %call13 to i32*
+  store i32* %12, i32** %c, align 8
+  %13 = load i32*, i32** %a, align 8
+  %14 = load i32, i32* %n, align 4
+  call void @init(i32* %13, i32 %14, i32 1)
+  %15 = load i32*, i32** %b, align 8
+  %16 = load i32, i32* %n, align 4
+  call void @init(i32* %15, i32 %16, i32 2)
+  %17 = load i32*, i32** %a, align 8
+  %18 = load i32*, i32** %b, align 8
+  %19 = load i32*, i32** %c, align 8
+  %20 = load i32, i32* %n, align 4
+  call void @matmul(i32* %17, i32* %18, i32* %19, i32 %20)
+  store i32 0, i32* %sum, align 4
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc, %if.end
+  %21 = load i32, i32* %i, align 4
+  %22 = load i32, i32* %n, align 4
+  %23 = load i32, i32* %n, align 4
+  %mul14 = mul nsw i32 %22, %23
+  %cmp15 = icmp slt i32 %21, %mul14
+  br i1 %cmp15, label %for.body, label %for.end
+
+for.body:                                         ; preds = %for.cond
+  %24 = load i32*, i32** %c, align 8
+  %25 = load i32, i32* %i, align 4
+  %idxprom = sext i32 %25 to i64
+  %arrayidx17 = getelementptr inbounds i32, i32* %24, i64 %idxprom
+  %26 = load i32, i32* %arrayidx17, align 4
+  %27 = load i32, i32* %sum, align 4
+  %add = add i32 %27, %26
+  store i32 %add, i32* %sum, align 4
+  br label %for.inc
+
+for.inc:                                          ; preds = %for.body
+  %28 = load i32, i32* %i, align 4
+  %inc = add nsw i32 %28, 1
+  store i32 %inc, i32* %i, align 4
+  br label %for.cond
+
+for.end:                                          ; preds = %for.cond
+  store i32 0, i32* %check, align 4
+  store i32 0, i32* %k, align 4
+  br label %for.cond18
+
+for.cond18:                                       ; preds = %for.inc44, %for.end
+  %29 = load i32, i32* %k, align 4
+  %30 = load i32, i32* %n, align 4
+  %cmp19 = icmp slt i32 %29, %30
+  br i1 %cmp19, label %for.body21, label %for.end47
+
+for.body21:                                       ; preds = %for.cond18
+  store i32 0, i32* %col, align 4
+  store i32 0, i32* %row, align 4
+  store i32 0, i32* %i31, align 4
+  br label %for.cond22
+
+for.cond22:                                       ; preds = %for.inc38, %for.body21
+  %31 = load i32, i32* %i31, align 4
+  %32 = load i32, i32* %n, align 4
+  %cmp23 = icmp slt i32 %31, %32
+  br i1 %cmp23, label %for.body25, label %for.end41
+
+for.body25:                                       ; preds = %for.cond22
+  %33 = load i32*, i32** %a, align 8
+  %34 = load i32, i32* %i31, align 4
+  %35 = load i32, i32* %n, align 4
+  %mul26 = mul nsw i32 %34, %35
+  %36 = load i32, i32* %k, align 4
+  %add27 = add nsw i32 %mul26, %36
+  %idxprom28 = sext i32 %add27 to i64
+  %arrayidx29 = getelementptr inbounds i32, i32* %33, i64 %idxprom28
+  %37 = load i32, i32* %arrayidx29, align 4
+  %38 = load i32, i32* %col, align 4
+  %add30 = add i32 %38, %37
+  store i32 %add30, i32* %col, align 4
+  %39 = load i32*, i32** %b, align 8
+  %40 = load i32, i32* %k, align 4
+  %41 = load i32, i32* %n, align 4
+  %mul32 = mul nsw i32 %40, %41
+  %42 = load i32, i32* %i31, align 4
+  %add33 = add nsw i32 %mul32, %42
+  %idxprom34 = sext i32 %add33 to i64
+  %arrayidx35 = getelementptr inbounds i32, i32* %39, i64 %idxprom34
+  %43 = load i32, i32* %arrayidx35, align 4
+  %44 = load i32, i32* %row, align 4
+  %add36 = add i32 %44, %43
+  store i32 %add36, i32* %row, align 4
+  br label %for.inc38
+
+for.inc38:                                        ; preds = %for.body25
+  %45 = load i32, i32* %i31, align 4
+  %inc39 = add nsw i32 %45, 1
+  store i32 %inc39, i32* %i31, align 4
+  br label %for.cond22
+
+for.end41:                                        ; preds = %for.cond22
+  %46 = load i32, i32* %col, align 4
+  %47 = load i32, i32* %row, align 4
+  %mul42 = mul i32 %46, %47
+  %48 = load i32, i32* %check, align 4
+  %add43 = add i32 %48, %mul42
+  store i32 %add43, i32* %check, align 4
+  br label %for.inc44
+
+for.inc44:                                        ; preds = %for.end41
+  %49 = load i32, i32* %k, align 4
+  %inc45 = add nsw i32 %49, 1
+  store i32 %inc45, i32* %k, align 4
+  br label %for.cond18
+
+for.end47:                                        ; preds = %for.cond18
+  %50 = load i32, i32* %sum, align 4
+  %call48 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([12 x i8], [12 x i8]* @.str.1, i32 0, i32 0), i32 %50)
+  %51 = load i32*, i32** %a, align 8
+  %52 = bitcast i32* %51 to i8*
+  call void @free(i8* %52) #3
+  %53 = load i32*, i32** %b, align 8
+  %54 = bitcast i32* %53 to i8*
+  call void @free(i8* %54) #3
+  %55 = load i32*, i32** %c, align 8
+  %56 = bitcast i32* %55 to i8*
+  call void @free(i8* %56) #3
+  %57 = load i32, i32* %sum, align 4
+  %58 = load i32, i32* %check, align 4
+  %cmp49 = icmp ne i32 %57, %58
+  %conv50 = zext i1 %cmp49 to i32
+  store i32 %conv50, i32* %retval, align 4
+  br label %return
+
+return:                                           ; preds = %for.end47, %if.then
+  %59 = load i32, i32* %retval, align 4
+  ret i32 %59
+}
+
+; Function Attrs: nounwind
+declare i64 @strtol(i8*, i8**, i32) #2
+
+declare i32 @printf(i8*, ...) #1
+
+; Function Attrs: nounwind
+declare noalias i8* @malloc(i64) #2
+
+; Function Attrs: nounwind
+declare void @free(i8*) #2
+
+attributes #0 = { nounwind uwtable "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #1 = { "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #2 = { nounwind "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #3 = { nounwind }
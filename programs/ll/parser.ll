@@ -0,0 +1,531 @@
+; ModuleID = 'programs/c/parser.c'
+source_filename = "programs/c/parser.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@seed = global i32 1, align 4
+@pos = common global i32 0, align 4
+@limit = common global i32 0, align 4
+@out = common global i8* null, align 8
+@p = common global i8* null, align 8
+@.str = private unnamed_addr constant [19 x i8] c"Usage: parser [n]\0A\00", align 1
+@.str.1 = private unnamed_addr constant [28 x i8] c"parser: %u (%d characters)\0A\00", align 1
+
+; Function Attrs: nounwind uwtable
+define i32 @next() #0 {
+entry:
+  %0 = load i32, i32* @seed, align 4
+  %mul = mul i32 %0, 1103515245
+  %add = add i32 %mul, 12345
+  store i32 %add, i32* @seed, align 4
+  %1 = load i32, i32* @seed, align 4
+  %shr = lshr i32 %1, 16
+  ret i32 %shr
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @gen_factor(i32 %depth) #0 {
+entry:
+  %retval = alloca i32, align 4
+  %depth.addr = alloca i32, align 4
+  %v = alloca i32, align 4
+  %v16 = alloca i32, align 4
+  store i32 %depth, i32* %depth.addr, align 4
+  %0 = load i32, i32* %depth.addr, align 4
+  %cmp = icmp eq i32 %0, 0
+  br i1 %cmp, label %if.then, label %lor.lhs.false
+
+lor.lhs.false:                                    ; preds = %entry
+  %1 = load i32, i32* @pos, align 4
+  %2 = load i32, i32* @limit, align 4
+  %cmp1 = icmp sgt i32 %1, %2
+  br i1 %cmp1, label %if.then, label %lor.lhs.false2
+
+lor.lhs.false2:                                   ; preds = %lor.lhs.false
+  %call = call i32 @next()
+  %rem = urem i32 %call, 3
+  %cmp3 = icmp eq i32 %rem, 0
+  br i1 %cmp3, label %if.then, label %if.end15
+
+if.then:                                          ; preds = %lor.lhs.false2, %lor.lhs.false, %entry
+  %call4 = call i32 @next()
+  %rem5 = urem i32 %call4, 100
+  store i32 %rem5, i32* %v, align 4
+  %3 = load i32, i32* %v, align 4
+  %cmp6 = icmp uge i32 %3, 10
+  br i1 %cmp6, label %if.then7, label %if.end
+
+if.then7:                                         ; preds = %if.then
+  %4 = load i32, i32* %v, align 4
+  %div = udiv i32 %4, 10
+  %add = add i32 48, %div
+  %conv = trunc i32 %add to i8
+  %5 = load i8*, i8** @out, align 8
+  %6 = load i32, i32* @pos, align 4
+  %inc = add nsw i32 %6, 1
+  store i32 %inc, i32* @pos, align 4
+  %idxprom = sext i32 %6 to i64
+  %arrayidx = getelementptr inbounds i8, i8* %5, i64 %idxprom
+  store i8 %conv, i8* %arrayidx, align 1
+  br label %if.end
+
+if.end:                                           ; preds = %if.then7, %if.then
+  %7 = load i32, i32* %v, align 4
+  %rem8 = urem i32 %7, 10
+  %add9 = add i32 48, %rem8
+  %conv10 = trunc i32 %add9 to i8
+  %8 = load i8*, i8** @out, align 8
+  %9 = load i32, i32* @pos, align 4
+  %inc11 = add nsw i32 %9, 1
+  store i32 %inc11, i32* @pos, align 4
+  %idxprom12 = sext i32 %9 to i64
+  %arrayidx13 = getelementptr inbounds i8, i8* %8, i64 %idxprom12
+  store i8 %conv10, i8* %arrayidx13, align 1
+  %10 = load i32, i32* %v, align 4
+  store i32 %10, i32* %retval, align 4
+  br label %return
+
+if.end15:                                         ; preds = %lor.lhs.false2
+  %11 = load i8*, i8** @out, align 8
+  %12 = load i32, i32* @pos, align 4
+  %inc16 = add nsw i32 %12, 1
+  store i32 %inc16, i32* @pos, align 4
+  %idxprom17 = sext i32 %12 to i64
+  %arrayidx18 = getelementptr inbounds i8, i8* %11, i64 %idxprom17
+  store i8 40, i8* %arrayidx18, align 1
+  %13 = load i32, i32* %depth.addr, align 4
+  %sub = sub nsw i32 %13, 1
+  %call19 = call i32 @gen_expr(i32 %sub)
+  store i32 %call19, i32* %v16, align 4
+  %14 = load i8*, i8** @out, align 8
+  %15 = load i32, i32* @pos, align 4
+  %inc20 = add nsw i32 %15, 1
+  store i32 %inc20, i32* @pos, align 4
+  %idxprom21 = sext i32 %15 to i64
+  %arrayidx22 = getelementptr inbounds i8, i8* %14, i64 %idxprom21
+  store i8 41, i8* %arrayidx22, align 1
+  %16 = load i32, i32* %v16, align 4
+  store i32 %16, i32* %retval, align 4
+  br label %return
+
+return:                                           ; preds = %if.end15, %if.end
+  %17 = load i32, i32* %retval, align 4
+  ret i32 %17
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @gen_term(i32 %depth) #0 {
+entry:
+  %depth.addr = alloca i32, align 4
+  %v = alloca i32, align 4
+  store i32 %depth, i32* %depth.addr, align 4
+  %0 = load i32, i32* %depth.addr, align 4
+  %call = call i32 @gen_factor(i32 %0)
+  store i32 %call, i32* %v, align 4
+  br label %while.cond
+
+while.cond:                                       ; preds = %while.body, %entry
+  %1 = load i32, i32* @pos, align 4
+  %2 = load i32, i32* @limit, align 4
+  %cmp = icmp slt i32 %1, %2
+  br i1 %cmp, label %land.rhs, label %land.end
+
+land.rhs:                                         ; preds = %while.cond
+  %call1 = call i32 @next()
+  %rem = urem i32 %call1, 4
+  %cmp2 = icmp eq i32 %rem, 0
+  br label %land.end
+
+land.end:                                         ; preds = %land.rhs, %while.cond
+  %3 = phi i1 [ false, %while.cond ], [ %cmp2, %land.rhs ]
+  br i1 %3, label %while.body, label %while.end
+
+while.body:                                       ; preds = %land.end
+  %4 = load i8*, i8** @out, align 8
+  %5 = load i32, i32* @pos, align 4
+  %inc = add nsw i32 %5, 1
+  store i32 %inc, i32* @pos, align 4
+  %idxprom = sext i32 %5 to i64
+  %arrayidx = getelementptr inbounds i8, i8* %4, i64 %idxprom
+  store i8 42, i8* %arrayidx, align 1
+  %6 = load i32, i32* %depth.addr, align 4
+  %call3 = call i32 @gen_factor(i32 %6)
+  %7 = load i32, i32* %v, align 4
+  %mul = mul i32 %7, %call3
+  store i32 %mul, i32* %v, align 4
+  br label %while.cond
+
+while.end:                                        ; preds = %land.end
+  %8 = load i32, i32* %v, align 4
+  ret i32 %8
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @gen_expr(i32 %depth) #0 {
+entry:
+  %depth.addr = alloca i32, align 4
+  %v = alloca i32, align 4
+  store i32 %depth, i32* %depth.addr, align 4
+  %0 = load i32, i32* %depth.addr, align 4
+  %call = call i32 @gen_term(i32 %0)
+  store i32 %call, i32* %v, align 4
+  br label %while.cond
+
+while.cond:                                       ; preds = %if.end, %entry
+  %1 = load i32, i32* @pos, align 4
+  %2 = load i32, i32* @limit, align 4
+  %cmp = icmp slt i32 %1, %2
+  br i1 %cmp, label %land.rhs, label %land.end
+
+land.rhs:                                         ; preds = %while.cond
+  %call1 = call i32 @next()
+  %rem = urem i32 %call1, 2
+  %cmp2 = icmp eq i32 %rem, 0
+  br label %land.end
+
+land.end:                                         ; preds = %land.rhs, %while.cond
+  %3 = phi i1 [ false, %while.cond ], [ %cmp2, %land.rhs ]
+  br i1 %3, label %while.body, label %while.end
+
+while.body:                                       ; preds = %land.end
+  %call3 = call i32 @next()
+  %rem4 = urem i32 %call3, 2
+  %tobool = icmp ne i32 %rem4, 0
+  br i1 %tobool, label %if.then, label %if.else
+
+if.then:                                          ; preds = %while.body
+  %4 = load i8*, i8** @out, align 8
+  %5 = load i32, i32* @pos, align 4
+  %inc = add nsw i32 %5, 1
+  store i32 %inc, i32* @pos, align 4
+  %idxprom = sext i32 %5 to i64
+  %arrayidx = getelementptr inbounds i8, i8* %4, i64 %idxprom
+  store i8 43, i8* %arrayidx, align 1
+  %6 = load i32, i32* %depth.addr, align 4
+  %call5 = call i32 @gen_term(i32 %6)
+  %7 = load i32, i32* %v, align 4
+  %add = add i32 %7, %call5
+  store i32 %add, i32* %v, align 4
+  br label %if.end
+
+if.else:                                          ; preds = %while.body
+  %8 = load i8*, i8** @out, align 8
+  %9 = load i32, i32* @pos, align 4
+  %inc6 = add nsw i32 %9, 1
+  store i32 %inc6, i32* @pos, align 4
+  %idxprom7 = sext i32 %9 to i64
+  %arrayidx8 = getelementptr inbounds i8, i8* %8, i64 %idxprom7
+  store i8 45, i8* %arrayidx8, align 1
+  %10 = load i32, i32* %depth.addr, align 4
+  %call9 = call i32 @gen_term(i32 %10)
+  %11 = load i32, i32* %v, align 4
+  %sub = sub i32 %11, %call9
+  store i32 %sub, i32* %v, align 4
+  br label %if.end
+
+if.end:                                           ; preds = %if.else, %if.then
+  br label %while.cond
+
+while.end:                                        ; preds = %land.end
+  %12 = load i32, i32* %v, align 4
+  ret i32 %12
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @parse_number() #0 {
+entry:
+  %v = alloca i32, align 4
+  store i32 0, i32* %v, align 4
+  br label %while.cond
+
+while.cond:                                       ; preds = %while.body, %entry
+  %0 = load i8*, i8** @p, align 8
+  %1 = load i8, i8* %0, align 1
+  %conv = sext i8 %1 to i32
+  %cmp = icmp sge i32 %conv, 48
+  br i1 %cmp, label %land.rhs, label %land.end
+
+land.rhs:                                         ; preds = %while.cond
+  %2 = load i8*, i8** @p, align 8
+  %3 = load i8, i8* %2, align 1
+  %conv2 = sext i8 %3 to i32
+  %cmp3 = icmp sle i32 %conv2, 57
+  br label %land.end
+
+land.end:                                         ; preds = %land.rhs, %while.cond
+  %4 = phi i1 [ false, %while.cond ], [ %cmp3, %land.rhs ]
+  br i1 %4, label %while.body, label %while.end
+
+while.body:                                       ; preds = %land.end
+  %5 = load i32, i32* %v, align 4
+  %mul = mul i32 %5, 10
+  %6 = load i8*, i8** @p, align 8
+  %incdec.ptr = getelementptr inbounds i8, i8* %6, i32 1
+  store i8* %incdec.ptr, i8** @p, align 8
+  %7 = load i8, i8* %6, align 1
+  %conv5 = sext i8 %7 to i32
+  %sub = sub nsw i32 %conv5, 48
+  %add = add i32 %mul, %sub
+  store i32 %add, i32* %v, align 4
+  br label %while.cond
+
+while.end:                                        ; preds = %land.end
+  %8 = load i32, i32* %v, align 4
+  ret i32 %8
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @parse_factor() #0 {
+entry:
+  %retval = alloca i32, align 4
+  %v = alloca i32, align 4
+  %0 = load i8*, i8** @p, align 8
+  %1 = load i8, i8* %0, align 1
+  %conv = sext i8 %1 to i32
+  %cmp = icmp eq i32 %conv, 40
+  br i1 %cmp, label %if.then, label %if.end
+
+if.then:                                          ; preds = %entry
+  %2 = load i8*, i8** @p, align 8
+  %incdec.ptr = getelementptr inbounds i8, i8* %2, i32 1
+  store i8* %incdec.ptr, i8** @p, align 8
+  %call = call i32 @parse_expr()
+  store i32 %call, i32* %v, align 4
+  %3 = load i8*, i8** @p, align 8
+  %incdec.ptr2 = getelementptr inbounds i8, i8* %3, i32 1
+  store i8* %incdec.ptr2, i8** @p, align 8
+  %4 = load i32, i32* %v, align 4
+  store i32 %4, i32* %retval, align 4
+  br label %return
+
+if.end:                                           ; preds = %entry
+  %call3 = call i32 @parse_number()
+  store i32 %call3, i32* %retval, align 4
+  br label %return
+
+return:                                           ; preds = %if.end, %if.then
+  %5 = load i32, i32* %retval, align 4
+  ret i32 %5
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @parse_term() #0 {
+entry:
+  %v = alloca i32, align 4
+  %call = call i32 @parse_factor()
+  store i32 %call, i32* %v, align 4
+  br label %while.cond
+
+while.cond:                                       ; preds = %while.body, %entry
+  %0 = load i8*, i8** @p, align 8
+  %1 = load i8, i8* %0, align 1
+  %conv = sext i8 %1 to i32
+  %cmp = icmp eq i32 %conv, 42
+  br i1 %cmp, label %while.body, label %while.end
+
+while.body:                                       ; preds = %while.cond
+  %2 = load i8*, i8** @p, align 8
+  %incdec.ptr = getelementptr inbounds i8, i8* %2, i32 1
+  store i8* %incdec.ptr, i8** @p, align 8
+  %call2 = call i32 @parse_factor()
+  %3 = load i32, i32* %v, align 4
+  %mul = mul i32 %3, %call2
+  store i32 %mul, i32* %v, align 4
+  br label %while.cond
+
+while.end:                                        ; preds = %while.cond
+  %4 = load i32, i32* %v, align 4
+  ret i32 %4
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @parse_expr() #0 {
+entry:
+  %v = alloca i32, align 4
+  %op = alloca i8, align 1
+  %t = alloca i32, align 4
+  %call = call i32 @parse_term()
+  store i32 %call, i32* %v, align 4
+  br label %while.cond
+
+while.cond:                                       ; preds = %cond.end, %entry
+  %0 = load i8*, i8** @p, align 8
+  %1 = load i8, i8* %0, align 1
+  %conv = sext i8 %1 to i32
+  %cmp = icmp eq i32 %conv, 43
+  br i1 %cmp, label %lor.end, label %lor.rhs
+
+lor.rhs:                                          ; preds = %while.cond
+  %2 = load i8*, i8** @p, align 8
+  %3 = load i8, i8* %2, align 1
+  %conv2 = sext i8 %3 to i32
+  %cmp3 = icmp eq i32 %conv2, 45
+  br label %lor.end
+
+lor.end:                                          ; preds = %lor.rhs, %while.cond
+  %4 = phi i1 [ true, %while.cond ], [ %cmp3, %lor.rhs ]
+  br i1 %4, label %while.body, label %while.end
+
+while.body:                                       ; preds = %lor.end
+  %5 = load i8*, i8** @p, align 8
+  %incdec.ptr = getelementptr inbounds i8, i8* %5, i32 1
+  store i8* %incdec.ptr, i8** @p, align 8
+  %6 = load i8, i8* %5, align 1
+  store i8 %6, i8* %op, align 1
+  %call5 = call i32 @parse_term()
+  store i32 %call5, i32* %t, align 4
+  %7 = load i8, i8* %op, align 1
+  %conv6 = sext i8 %7 to i32
+  %cmp7 = icmp eq i32 %conv6, 43
+  br i1 %cmp7, label %cond.true, label %cond.false
+
+cond.true:                                        ; preds = %while.body
+  %8 = load i32, i32* %v, align 4
+  %9 = load i32, i32* %t, align 4
+  %add = add i32 %8, %9
+  br label %cond.end
+
+cond.false:                                       ; preds = %while.body
+  %10 = load i32, i32* %v, align 4
+  %11 = load i32, i32* %t, align 4
+  %sub = sub i32 %10, %11
+  br label %cond.end
+
+cond.end:                                         ; preds = %cond.false, %cond.true
+  %cond = phi i32 [ %add, %cond.true ], [ %sub, %cond.false ]
+  store i32 %cond, i32* %v, align 4
+  br label %while.cond
+
+while.end:                                        ; preds = %lor.end
+  %12 = load i32, i32* %v, align 4
+  ret i32 %12
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @main(i32 %argc, i8** %argv) #0 {
+entry:
+  %retval = alloca i32, align 4
+  %argc.addr = alloca i32, align 4
+  %argv.addr = alloca i8**, align 8
+  %n = alloca i32, align 4
+  %value = alloca i32, align 4
+  %result = alloca i32, align 4
+  %rest = alloca i32, align 4
+  store i32 0, i32* %retval, align 4
+  store i32 %argc, i32* %argc.addr, align 4
+  store i8** %argv, i8*** %argv.addr, align 8
+  %0 = load i32, i32* %argc.addr, align 4
+  %cmp = icmp sgt i32 %0, 1
+  br i1 %cmp, label %cond.true, label %cond.false
+
+cond.true:                                        ; preds = %entry
+  %1 = load i8**, i8*** %argv.addr, align 8
+  %arrayidx = getelementptr inbounds i8*, i8** %1, i64 1
+  %2 = load i8*, i8** %arrayidx, align 8
+  %call = call i64 @strtol(i8* %2, i8** null, i32 0) #3
+  br label %cond.end
+
+cond.false:                                       ; preds = %entry
+  br label %cond.end
+
+cond.end:                                         ; preds = %cond.false, %cond.true
+  %cond = phi i64 [ %call, %cond.true ], [ 1048576, %cond.false ]
+  %conv = trunc i64 %cond to i32
+  store i32 %conv, i32* %n, align 4
+  %3 = load i32, i32* %n, align 4
+  %cmp1 = icmp sle i32 %3, 0
+  br i1 %cmp1, label %if.then, label %if.end
+
+if.then:                                          ; preds = %cond.end
+  %call2 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([19 x i8], [19 x i8]* @.str, i32 0, i32 0))
+  store i32 -1, i32* %retval, align 4
+  br label %return
+
+if.end:                                           ; preds = %cond.end
+  %4 = load i32, i32* %n, align 4
+  store i32 %4, i32* @limit, align 4
+  %5 = load i32, i32* %n, align 4
+  %add = add nsw i32 %5, 4096
+  %conv3 = sext i32 %add to i64
+  %call4 = call noalias i8* @malloc(i64 %conv3) #3
+  store i8* %call4, i8** @out, align 8
+  store i32 0, i32* @pos, align 4
+  %call5 = call i32 @gen_term(i32 8)
+  store i32 %call5, i32* %value, align 4
+  br label %while.cond
+
+while.cond:                                       ; preds = %while.body, %if.end
+  %6 = load i32, i32* @pos, align 4
+  %7 = load i32, i32* @limit, align 4
+  %cmp6 = icmp slt i32 %6, %7
+  br i1 %cmp6, label %while.body, label %while.end
+
+while.body:                                       ; preds = %while.cond
+  %8 = load i8*, i8** @out, align 8
+  %9 = load i32, i32* @pos, align 4
+  %inc = add nsw i32 %9, 1
+  store i32 %inc, i32* @pos, align 4
+  %idxprom = sext i32 %9 to i64
+  %arrayidx8 = getelementptr inbounds i8, i8* %8, i64 %idxprom
+  store i8 43, i8* %arrayidx8, align 1
+  %call9 = call i32 @gen_term(i32 8)
+  %10 = load i32, i32* %value, align 4
+  %add10 = add i32 %10, %call9
+  store i32 %add10, i32* %value, align 4
+  br label %while.cond
+
+while.end:                                        ; preds = %while.cond
+  %11 = load i8*, i8** @out, align 8
+  %12 = load i32, i32* @pos, align 4
+  %idxprom11 = sext i32 %12 to i64
+  %arrayidx12 = getelementptr inbounds i8, i8* %11, i64 %idxprom11
+  store i8 0, i8* %arrayidx12, align 1
+  %13 = load i8*, i8** @out, align 8
+  store i8* %13, i8** @p, align 8
+  %call13 = call i32 @parse_expr()
+  store i32 %call13, i32* %result, align 4
+  %14 = load i8*, i8** @p, align 8
+  %15 = load i8, i8* %14, align 1
+  %conv14 = sext i8 %15 to i32
+  store i32 %conv14, i32* %rest, align 4
+  %16 = load i32, i32* %result, align 4
+  %17 = load i32, i32* @pos, align 4
+  %call15 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([28 x i8], [28 x i8]* @.str.1, i32 0, i32 0), i32 %16, i32 %17)
+  %18 = load i8*, i8** @out, align 8
+  call void @free(i8* %18) #3
+  %19 = load i32, i32* %result, align 4
+  %20 = load i32, i32* %value, align 4
+  %cmp16 = icmp ne i32 %19, %20
+  br i1 %cmp16, label %lor.end, label %lor.rhs
+
+lor.rhs:                                          ; preds = %while.end
+  %21 = load i32, i32* %rest, align 4
+  %cmp18 = icmp ne i32 %21, 0
+  br label %lor.end
+
+lor.end:                                          ; preds = %lor.rhs, %while.end
+  %22 = phi i1 [ true, %while.end ], [ %cmp18, %lor.rhs ]
+  %lor.ext = zext i1 %22 to i32
+  store i32 %lor.ext, i32* %retval, align 4
+  br label %return
+
+return:                                           ; preds = %lor.end, %if.then
+  %23 = load i32, i32* %retval, align 4
+  ret i32 %23
+}
+
+; Function Attrs: nounwind
+declare i64 @strtol(i8*, i8**, i32) #2
+
+declare i32 @printf(i8*, ...) #1
+
+; Function Attrs: nounwind
+declare noalias i8* @malloc(i64) #2
+
+; Function Attrs: nounwind
+declare void @free(i8*) #2
+
+attributes #0 = { nounwind uwtable "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #1 = { "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #2 = { nounwind "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #3 = { nounwind }
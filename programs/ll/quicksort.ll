@@ -0,0 +1,327 @@
+; ModuleID = 'programs/c/quicksort.c'
+source_filename = "programs/c/quicksort.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@.str = private unnamed_addr constant [22 x i8] c"Usage: quicksort [n]\0A\00", align 1
+@.str.1 = private unnamed_addr constant [15 x i8] c"quicksort: %u\0A\00", align 1
+
+; Function Attrs: nounwind uwtable
+define void @swap(i32* %a, i32 %i, i32 %j) #0 {
+entry:
+  %a.addr = alloca i32*, align 8
+  %i.addr = alloca i32, align 4
+  %j.addr = alloca i32, align 4
+  %t = alloca i32, align 4
+  store i32* %a, i32** %a.addr, align 8
+  store i32 %i, i32* %i.addr, align 4
+  store i32 %j, i32* %j.addr, align 4
+  %0 = load i32*, i32** %a.addr, align 8
+  %1 = load i32, i32* %i.addr, align 4
+  %idxprom = sext i32 %1 to i64
+  %arrayidx = getelementptr inbounds i32, i32* %0, i64 %idxprom
+  %2 = load i32, i32* %arrayidx, align 4
+  store i32 %2, i32* %t, align 4
+  %3 = load i32*, i32** %a.addr, align 8
+  %4 = load i32, i32* %j.addr, align 4
+  %idxprom1 = sext i32 %4 to i64
+  %arrayidx2 = getelementptr inbounds i32, i32* %3, i64 %idxprom1
+  %5 = load i32, i32* %arrayidx2, align 4
+  %6 = load i32*, i32** %a.addr, align 8
+  %7 = load i32, i32* %i.addr, align 4
+  %idxprom3 = sext i32 %7 to i64
+  %arrayidx4 = getelementptr inbounds i32, i32* %6, i64 %idxprom3
+  store i32 %5, i32* %arrayidx4, align 4
+  %8 = load i32, i32* %t, align 4
+  %9 = load i32*, i32** %a.addr, align 8
+  %10 = load i32, i32* %j.addr, align 4
+  %idxprom5 = sext i32 %10 to i64
+  %arrayidx6 = getelementptr inbounds i32, i32* %9, i64 %idxprom5
+  store i32 %8, i32* %arrayidx6, align 4
+  ret void
+}
+
+; Function Attrs: nounwind uwtable
+define void @quicksort(i32* %a, i32 %lo, i32 %hi) #0 {
+entry:
+  %a.addr = alloca i32*, align 8
+  %lo.addr = alloca i32, align 4
+  %hi.addr = alloca i32, align 4
+  %pivot = alloca i32, align 4
+  %i = alloca i32, align 4
+  %j = alloca i32, align 4
+  store i32* %a, i32** %a.addr, align 8
+  store i32 %lo, i32* %lo.addr, align 4
+  store i32 %hi, i32* %hi.addr, align 4
+  %0 = load i32, i32* %lo.addr, align 4
+  %1 = load i32, i32* %hi.addr, align 4
+  %cmp = icmp sge i32 %0, %1
+  br i1 %cmp, label %if.then, label %if.end
+
+if.then:                                          ; preds = %entry
+  br label %return
+
+if.end:                                           ; preds = %entry
+  %2 = load i32*, i32** %a.addr, align 8
+  %3 = load i32, i32* %lo.addr, align 4
+  %4 = load i32, i32* %hi.addr, align 4
+  %add = add nsw i32 %3, %4
+  %div = sdiv i32 %add, 2
+  %5 = load i32, i32* %hi.addr, align 4
+  call void @swap(i32* %2, i32 %div, i32 %5)
+  %6 = load i32*, i32** %a.addr, align 8
+  %7 = load i32, i32* %hi.addr, align 4
+  %idxprom = sext i32 %7 to i64
+  %arrayidx = getelementptr inbounds i32, i32* %6, i64 %idxprom
+  %8 = load i32, i32* %arrayidx, align 4
+  store i32 %8, i32* %pivot, align 4
+  %9 = load i32, i32* %lo.addr, align 4
+  store i32 %9, i32* %i, align 4
+  %10 = load i32, i32* %lo.addr, align 4
+  store i32 %10, i32* %j, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc, %if.end
+  %11 = load i32, i32* %j, align 4
+  %12 = load i32, i32* %hi.addr, align 4
+  %cmp1 = icmp slt i32 %11, %12
+  br i1 %cmp1, label %for.body, label %for.end
+
+for.body:                                         ; preds = %for.cond
+  %13 = load i32*, i32** %a.addr, align 8
+  %14 = load i32, i32* %j, align 4
+  %idxprom2 = sext i32 %14 to i64
+  %arrayidx3 = getelementptr inbounds i32, i32* %13, i64 %idxprom2
+  %15 = load i32, i32* %arrayidx3, align 4
+  %16 = load i32, i32* %pivot, align 4
+  %cmp4 = icmp slt i32 %15, %16
+  br i1 %cmp4, label %if.then5, label %if.end6
+
+if.then5:                                         ; preds = %for.body
+  %17 = load i32*, i32** %a.addr, align 8
+  %18 = load i32, i32* %i, align 4
+  %19 = load i32, i32* %j, align 4
+  call void @swap(i32* %17, i32 %18, i32 %19)
+  %20 = load i32, i32* %i, align 4
+  %inc = add nsw i32 %20, 1
+  store i32 %inc, i32* %i, align 4
+  br label %if.end6
+
+if.end6:                                          ; preds = %if.then5, %for.body
+  br label %for.inc
+
+for.inc:                                          ; preds = %if.end6
+  %21 = load i32, i32* %j, align 4
+  %inc7 = add nsw i32 %21, 1
+  store i32 %inc7, i32* %j, align 4
+  br label %for.cond
+
+for.end:                                          ; preds = %for.cond
+  %22 = load i32*, i32** %a.addr, align 8
+  %23 = load i32, i32* %i, align 4
+  %24 = load i32, i32* %hi.addr, align 4
+  call void @swap(i32* %22, i32 %23, i32 %24)
+  %25 = load i32*, i32** %a.addr, align 8
+  %26 = load i32, i32* %lo.addr, align 4
+  %27 = load i32, i32* %i, align 4
+  %sub = sub nsw i32 %27, 1
+  call void @quicksort(i32* %25, i32 %26, i32 %sub)
+  %28 = load i32*, i32** %a.addr, align 8
+  %29 = load i32, i32* %i, align 4
+  %add8 = add nsw i32 %29, 1
+  %30 = load i32, i32* %hi.addr, align 4
+  call void @quicksort(i32* %28, i32 %add8, i32 %30)
+  br label %return
+
+return:                                           ; preds = %for.end, %if.then
+  ret void
+}
+
+; Function Attrs: nounwind uwtable
+define i32 @main(i32 %argc, i8** %argv) #0 {
+entry:
+  %retval = alloca i32, align 4
+  %argc.addr = alloca i32, align 4
+  %argv.addr = alloca i8**, align 8
+  %n = alloca i32, align 4
+  %a = alloca i32*, align 8
+  %seed = alloca i32, align 4
+  %before = alloca i32, align 4
+  %i = alloca i32, align 4
+  %after = alloca i32, align 4
+  %sorted = alloca i32, align 4
+  %i17 = alloca i32, align 4
+  store i32 0, i32* %retval, align 4
+  store i32 %argc, i32* %argc.addr, align 4
+  store i8** %argv, i8*** %argv.addr, align 8
+  %0 = load i32, i32* %argc.addr, align 4
+  %cmp = icmp sgt i32 %0, 1
+  br i1 %cmp, label %cond.true, label %cond.false
+
+cond.true:                                        ; preds = %entry
+  %1 = load i8**, i8*** %argv.addr, align 8
+  %arrayidx = getelementptr inbounds i8*, i8** %1, i64 1
+  %2 = load i8*, i8** %arrayidx, align 8
+  %call = call i64 @strtol(i8* %2, i8** null, i32 0) #3
+  br label %cond.end
+
+cond.false:                                       ; preds = %entry
+  br label %cond.end
+
+cond.end:                                         ; preds = %cond.false, %cond.true
+  %cond = phi i64 [ %call, %cond.true ], [ 200000, %cond.false ]
+  %conv = trunc i64 %cond to i32
+  store i32 %conv, i32* %n, align 4
+  %3 = load i32, i32* %n, align 4
+  %cmp1 = icmp sle i32 %3, 0
+  br i1 %cmp1, label %if.then, label %if.end
+
+if.then:                                          ; preds = %cond.end
+  %call2 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([22 x i8], [22 x i8]* @.str, i32 0, i32 0))
+  store i32 -1, i32* %retval, align 4
+  br label %return
+
+if.end:                                           ; preds = %cond.end
+  %4 = load i32, i32* %n, align 4
+  %conv3 = sext i32 %4 to i64
+  %mul = mul i64 %conv3, 4
+  %call4 = call noalias i8* @malloc(i64 %mul) #3
+  %5 = bitcast i8* %call4 to i32*
+  store i32* %5, i32** %a, align 8
+  store i32 1, i32* %seed, align 4
+  store i32 0, i32* %before, align 4
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:                                         ; preds = %for.inc, %if.end
+  %6 = load i32, i32* %i, align 4
+  %7 = load i32, i32* %n, align 4
+  %cmp5 = icmp slt i32 %6, %7
+  br i1 %cmp5, label %for.body, label %for.end
+
+for.body:                                         ; preds = %for.cond
+  %8 = load i32, i32* %seed, align 4
+  %mul7 = mul i32 %8, 1103515245
+  %add = add i32 %mul7, 12345
+  store i32 %add, i32* %seed, align 4
+  %9 = load i32, i32* %seed, align 4
+  %shr = lshr i32 %9, 8
+  %rem = urem i32 %shr, 1000000
+  %10 = load i32*, i32** %a, align 8
+  %11 = load i32, i32* %i, align 4
+  %idxprom = sext i32 %11 to i64
+  %arrayidx8 = getelementptr inbounds i32, i32* %10, i64 %idxprom
+  store i32 %rem, i32* %arrayidx8, align 4
+  %12 = load i32*, i32** %a, align 8
+  %13 = load i32, i32* %i, align 4
+  %idxprom9 = sext i32 %13 to i64
+  %arrayidx10 = getelementptr inbounds i32, i32* %12, i64 %idxprom9
+  %14 = load i32, i32* %arrayidx10, align 4
+  %15 = load i32, i32* %before, align 4
+  %add11 = add i32 %15, %14
+  store i32 %add11, i32* %before, align 4
+  br label %for.inc
+
+for.inc:                                          ; preds = %for.body
+  %16 = load i32, i32* %i, align 4
+  %inc = add nsw i32 %16, 1
+  store i32 %inc, i32* %i, align 4
+  br label %for.cond
+
+for.end:                                          ; preds = %for.cond
+  %17 = load i32*, i32** %a, align 8
+  %18 = load i32, i32* %n, align 4
+  %sub = sub nsw i32 %18, 1
+  call void @quicksort(i32* %17, i32 0, i32 %sub)
+  %19 = load i32*, i32** %a, align 8
+  %arrayidx12 = getelementptr inbounds i32, i32* %19, i64 0
+  %20 = load i32, i32* %arrayidx12, align 4
+  store i32 %20, i32* %after, align 4
+  store i32 1, i32* %sorted, align 4
+  store i32 1, i32* %i17, align 4
+  br label %for.cond13
+
+for.cond13:                                       ; preds = %for.inc31, %for.end
+  %21 = load i32, i32* %i17, align 4
+  %22 = load i32, i32* %n, align 4
+  %cmp14 = icmp slt i32 %21, %22
+  br i1 %cmp14, label %for.body16, label %for.end30
+
+for.body16:                                       ; preds = %for.cond13
+  %23 = load i32*, i32** %a, align 8
+  %24 = load i32, i32* %i17, align 4
+  %sub18 = sub nsw i32 %24, 1
+  %idxprom19 = sext i32 %sub18 to i64
+  %arrayidx20 = getelementptr inbounds i32, i32* %23, i64 %idxprom19
+  %25 = load i32, i32* %arrayidx20, align 4
+  %26 = load i32*, i32** %a, align 8
+  %27 = load i32, i32* %i17, align 4
+  %idxprom21 = sext i32 %27 to i64
+  %arrayidx22 = getelementptr inbounds i32, i32* %26, i64 %idxprom21
+  %28 = load i32, i32* %arrayidx22, align 4
+  %cmp23 = icmp sgt i32 %25, %28
+  br i1 %cmp23, label %if.then25, label %if.end26
+
+if.then25:                                        ; preds = %for.body16
+  store i32 0, i32* %sorted, align 4
+  br label %if.end26
+
+if.end26:                                         ; preds = %if.then25, %for.body16
+  %29 = load i32*, i32** %a, align 8
+  %30 = load i32, i32* %i17, align 4
+  %idxprom27 = sext i32 %30 to i64
+  %arrayidx28 = getelementptr inbounds i32, i32* %29, i64 %idxprom27
+  %31 = load i32, i32* %arrayidx28, align 4
+  %32 = load i32, i32* %after, align 4
+  %add29 = add i32 %32, %31
+  store i32 %add29, i32* %after, align 4
+  br label %for.inc31
+
+for.inc31:                                        ; preds = %if.end26
+  %33 = load i32, i32* %i17, align 4
+  %inc32 = add nsw i32 %33, 1
+  store i32 %inc32, i32* %i17, align 4
+  br label %for.cond13
+
+for.end30:                                        ; preds = %for.cond13
+  %34 = load i32, i32* %after, align 4
+  %call33 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([15 x i8], [15 x i8]* @.str.1, i32 0, i32 0), i32 %34)
+  %35 = load i32*, i32** %a, align 8
+  %36 = bitcast i32* %35 to i8*
+  call void @free(i8* %36) #3
+  %37 = load i32, i32* %sorted, align 4
+  %tobool = icmp ne i32 %37, 0
+  br i1 %tobool, label %lor.rhs, label %lor.end
+
+lor.rhs:                                          ; preds = %for.end30
+  %38 = load i32, i32* %before, align 4
+  %39 = load i32, i32* %after, align 4
+  %cmp34 = icmp ne i32 %38, %39
+  br label %lor.end
+
+lor.end:                                          ; preds = %lor.rhs, %for.end30
+  %40 = phi i1 [ true, %for.end30 ], [ %cmp34, %lor.rhs ]
+  %lor.ext = zext i1 %40 to i32
+  store i32 %lor.ext, i32* %retval, align 4
+  br label %return
+
+return:                                           ; preds = %lor.end, %if.then
+  %41 = load i32, i32* %retval, align 4
+  ret i32 %41
+}
+
+; Function Attrs: nounwind
+declare i64 @strtol(i8*, i8**, i32) #2
+
+declare i32 @printf(i8*, ...) #1
+
+; Function Attrs: nounwind
+declare noalias i8* @malloc(i64) #2
+
+; Function Attrs: nounwind
+declare void @free(i8*) #2
+
+attributes #0 = { nounwind uwtable "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #1 = { "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #2 = { nounwind "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #3 = { nounwind }
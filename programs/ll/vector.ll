@@ -0,0 +1,286 @@
+; ModuleID = 'programs/ll/vector.ll'
+source_filename = "programs/ll/vector.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; Integer vector operations (add, sub, xor, or, and, mul and comparisons) on <4 x i32>, <8 x i16> and <16 x i8>,
+; checked lane by lane against the same operations on scalars. The inputs depend on argc, so that they are not
+; constant folded. Exits with 0 if all lanes agree, 1 otherwise.
+
+define <4 x i32> @vops32(<4 x i32> %a, <4 x i32> %b) #0 {
+entry:
+  %s = add <4 x i32> %a, %b
+  %d = sub <4 x i32> %a, %b
+  %x = xor <4 x i32> %a, %b
+  %o = or <4 x i32> %a, %b
+  %n = and <4 x i32> %a, %b
+  %m = mul <4 x i32> %a, %b
+  %t1 = mul <4 x i32> %s, %d
+  %t2 = xor <4 x i32> %t1, %o
+  %t3 = sub <4 x i32> %t2, %n
+  %t4 = add <4 x i32> %t3, %m
+  %t5 = or <4 x i32> %t4, %x
+  %c1 = icmp ult <4 x i32> %a, %b
+  %c2 = icmp slt <4 x i32> %d, %s
+  %c3 = icmp eq <4 x i32> %n, %x
+  %c4 = icmp ne <4 x i32> %o, %m
+  %c5 = icmp sge <4 x i32> %t1, %t2
+  %c6 = icmp ugt <4 x i32> %t3, %t4
+  %r1 = select <4 x i1> %c1, <4 x i32> %t4, <4 x i32> %t5
+  %r2 = select <4 x i1> %c2, <4 x i32> %r1, <4 x i32> %t5
+  %r3 = select <4 x i1> %c3, <4 x i32> %t3, <4 x i32> %r2
+  %r4 = select <4 x i1> %c4, <4 x i32> %r3, <4 x i32> %t1
+  %r5 = select <4 x i1> %c5, <4 x i32> %r4, <4 x i32> %t2
+  %r6 = select <4 x i1> %c6, <4 x i32> %r5, <4 x i32> %s
+  ret <4 x i32> %r6
+}
+
+define i32 @sops32(i32 %a, i32 %b) #0 {
+entry:
+  %s = add i32 %a, %b
+  %d = sub i32 %a, %b
+  %x = xor i32 %a, %b
+  %o = or i32 %a, %b
+  %n = and i32 %a, %b
+  %m = mul i32 %a, %b
+  %t1 = mul i32 %s, %d
+  %t2 = xor i32 %t1, %o
+  %t3 = sub i32 %t2, %n
+  %t4 = add i32 %t3, %m
+  %t5 = or i32 %t4, %x
+  %c1 = icmp ult i32 %a, %b
+  %c2 = icmp slt i32 %d, %s
+  %c3 = icmp eq i32 %n, %x
+  %c4 = icmp ne i32 %o, %m
+  %c5 = icmp sge i32 %t1, %t2
+  %c6 = icmp ugt i32 %t3, %t4
+  %r1 = select i1 %c1, i32 %t4, i32 %t5
+  %r2 = select i1 %c2, i32 %r1, i32 %t5
+  %r3 = select i1 %c3, i32 %t3, i32 %r2
+  %r4 = select i1 %c4, i32 %r3, i32 %t1
+  %r5 = select i1 %c5, i32 %r4, i32 %t2
+  %r6 = select i1 %c6, i32 %r5, i32 %s
+  ret i32 %r6
+}
+
+define <8 x i16> @vops16(<8 x i16> %a, <8 x i16> %b) #0 {
+entry:
+  %s = add <8 x i16> %a, %b
+  %d = sub <8 x i16> %a, %b
+  %x = xor <8 x i16> %a, %b
+  %o = or <8 x i16> %a, %b
+  %n = and <8 x i16> %a, %b
+  %m = mul <8 x i16> %a, %b
+  %t1 = mul <8 x i16> %s, %d
+  %t2 = xor <8 x i16> %t1, %o
+  %t3 = sub <8 x i16> %t2, %n
+  %t4 = add <8 x i16> %t3, %m
+  %t5 = or <8 x i16> %t4, %x
+  %c1 = icmp ule <8 x i16> %a, %b
+  %c2 = icmp sgt <8 x i16> %d, %s
+  %c3 = icmp eq <8 x i16> %n, %x
+  %c4 = icmp sle <8 x i16> %t1, %t2
+  %r1 = select <8 x i1> %c1, <8 x i16> %t4, <8 x i16> %t5
+  %r2 = select <8 x i1> %c2, <8 x i16> %r1, <8 x i16> %t3
+  %r3 = select <8 x i1> %c3, <8 x i16> %m, <8 x i16> %r2
+  %r4 = select <8 x i1> %c4, <8 x i16> %r3, <8 x i16> %t1
+  ret <8 x i16> %r4
+}
+
+define i16 @sops16(i16 %a, i16 %b) #0 {
+entry:
+  %s = add i16 %a, %b
+  %d = sub i16 %a, %b
+  %x = xor i16 %a, %b
+  %o = or i16 %a, %b
+  %n = and i16 %a, %b
+  %m = mul i16 %a, %b
+  %t1 = mul i16 %s, %d
+  %t2 = xor i16 %t1, %o
+  %t3 = sub i16 %t2, %n
+  %t4 = add i16 %t3, %m
+  %t5 = or i16 %t4, %x
+  %c1 = icmp ule i16 %a, %b
+  %c2 = icmp sgt i16 %d, %s
+  %c3 = icmp eq i16 %n, %x
+  %c4 = icmp sle i16 %t1, %t2
+  %r1 = select i1 %c1, i16 %t4, i16 %t5
+  %r2 = select i1 %c2, i16 %r1, i16 %t3
+  %r3 = select i1 %c3, i16 %m, i16 %r2
+  %r4 = select i1 %c4, i16 %r3, i16 %t1
+  ret i16 %r4
+}
+
+define <16 x i8> @vops8(<16 x i8> %a, <16 x i8> %b) #0 {
+entry:
+  %s = add <16 x i8> %a, %b
+  %d = sub <16 x i8> %a, %b
+  %x = xor <16 x i8> %a, %b
+  %o = or <16 x i8> %a, %b
+  %n = and <16 x i8> %a, %b
+  %m = mul <16 x i8> %a, %b
+  %t1 = add <16 x i8> %s, %x
+  %t2 = sub <16 x i8> %t1, %n
+  %t3 = xor <16 x i8> %t2, %m
+  %t4 = or <16 x i8> %t3, %d
+  %c1 = icmp uge <16 x i8> %a, %b
+  %c2 = icmp slt <16 x i8> %o, %t2
+  %c3 = icmp ne <16 x i8> %n, %x
+  %r1 = select <16 x i1> %c1, <16 x i8> %t3, <16 x i8> %t4
+  %r2 = select <16 x i1> %c2, <16 x i8> %r1, <16 x i8> %t1
+  %r3 = select <16 x i1> %c3, <16 x i8> %r2, <16 x i8> %s
+  ret <16 x i8> %r3
+}
+
+define i8 @sops8(i8 %a, i8 %b) #0 {
+entry:
+  %s = add i8 %a, %b
+  %d = sub i8 %a, %b
+  %x = xor i8 %a, %b
+  %o = or i8 %a, %b
+  %n = and i8 %a, %b
+  %m = mul i8 %a, %b
+  %t1 = add i8 %s, %x
+  %t2 = sub i8 %t1, %n
+  %t3 = xor i8 %t2, %m
+  %t4 = or i8 %t3, %d
+  %c1 = icmp uge i8 %a, %b
+  %c2 = icmp slt i8 %o, %t2
+  %c3 = icmp ne i8 %n, %x
+  %r1 = select i1 %c1, i8 %t3, i8 %t4
+  %r2 = select i1 %c2, i8 %r1, i8 %t1
+  %r3 = select i1 %c3, i8 %r2, i8 %s
+  ret i8 %r3
+}
+
+; Number of lanes of 'v' that differ from 'sops32' applied to the lanes of 'a' and 'b'
+define i32 @check32(<4 x i32> %a, <4 x i32> %b, <4 x i32> %v) #0 {
+entry:
+  br label %loop
+
+loop:                                             ; preds = %loop, %entry
+  %j = phi i32 [ 0, %entry ], [ %j.next, %loop ]
+  %bad = phi i32 [ 0, %entry ], [ %bad.next, %loop ]
+  %aj = extractelement <4 x i32> %a, i32 %j
+  %bj = extractelement <4 x i32> %b, i32 %j
+  %vj = extractelement <4 x i32> %v, i32 %j
+  %sj = call i32 @sops32(i32 %aj, i32 %bj)
+  %ne = icmp ne i32 %vj, %sj
+  %inc = zext i1 %ne to i32
+  %bad.next = add i32 %bad, %inc
+  %j.next = add i32 %j, 1
+  %done = icmp eq i32 %j.next, 4
+  br i1 %done, label %exit, label %loop
+
+exit:                                             ; preds = %loop
+  ret i32 %bad.next
+}
+
+define i32 @check16(<8 x i16> %a, <8 x i16> %b, <8 x i16> %v) #0 {
+entry:
+  br label %loop
+
+loop:                                             ; preds = %loop, %entry
+  %j = phi i32 [ 0, %entry ], [ %j.next, %loop ]
+  %bad = phi i32 [ 0, %entry ], [ %bad.next, %loop ]
+  %aj = extractelement <8 x i16> %a, i32 %j
+  %bj = extractelement <8 x i16> %b, i32 %j
+  %vj = extractelement <8 x i16> %v, i32 %j
+  %sj = call i16 @sops16(i16 %aj, i16 %bj)
+  %ne = icmp ne i16 %vj, %sj
+  %inc = zext i1 %ne to i32
+  %bad.next = add i32 %bad, %inc
+  %j.next = add i32 %j, 1
+  %done = icmp eq i32 %j.next, 8
+  br i1 %done, label %exit, label %loop
+
+exit:                                             ; preds = %loop
+  ret i32 %bad.next
+}
+
+define i32 @check8(<16 x i8> %a, <16 x i8> %b, <16 x i8> %v) #0 {
+entry:
+  br label %loop
+
+loop:                                             ; preds = %loop, %entry
+  %j = phi i32 [ 0, %entry ], [ %j.next, %loop ]
+  %bad = phi i32 [ 0, %entry ], [ %bad.next, %loop ]
+  %aj = extractelement <16 x i8> %a, i32 %j
+  %bj = extractelement <16 x i8> %b, i32 %j
+  %vj = extractelement <16 x i8> %v, i32 %j
+  %sj = call i8 @sops8(i8 %aj, i8 %bj)
+  %ne = icmp ne i8 %vj, %sj
+  %inc = zext i1 %ne to i32
+  %bad.next = add i32 %bad, %inc
+  %j.next = add i32 %j, 1
+  %done = icmp eq i32 %j.next, 16
+  br i1 %done, label %exit, label %loop
+
+exit:                                             ; preds = %loop
+  ret i32 %bad.next
+}
+
+; 1000 pairs of pseudo-random vectors (xorshift seeded by argc), each checked at all three lane widths
+define i32 @main(i32 %argc, i8** %argv) #0 {
+entry:
+  br label %loop
+
+loop:                                             ; preds = %loop, %entry
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %state = phi i32 [ %argc, %entry ], [ %r4, %loop ]
+  %bad = phi i32 [ 0, %entry ], [ %bad3, %loop ]
+  %r0 = call i32 @xorshift(i32 %state)
+  %r1 = call i32 @xorshift(i32 %r0)
+  %r2 = call i32 @xorshift(i32 %r1)
+  %r3 = call i32 @xorshift(i32 %r2)
+  %r4 = call i32 @xorshift(i32 %r3)
+  %r5 = call i32 @xorshift(i32 %r4)
+  %r6 = call i32 @xorshift(i32 %r5)
+  %r7 = call i32 @xorshift(i32 %r6)
+  %a.0 = insertelement <4 x i32> undef, i32 %r0, i32 0
+  %a.1 = insertelement <4 x i32> %a.0, i32 %r1, i32 1
+  %a.2 = insertelement <4 x i32> %a.1, i32 %r2, i32 2
+  %a = insertelement <4 x i32> %a.2, i32 %r3, i32 3
+  %b.0 = insertelement <4 x i32> undef, i32 %r4, i32 0
+  %b.1 = insertelement <4 x i32> %b.0, i32 %r5, i32 1
+  %b.2 = insertelement <4 x i32> %b.1, i32 %r6, i32 2
+  ; Equal lanes in half of the iterations, so that the comparisons go both ways
+  %even = and i32 %i, 1
+  %same = icmp eq i32 %even, 0
+  %b3 = select i1 %same, i32 %r3, i32 %r7
+  %b = insertelement <4 x i32> %b.2, i32 %b3, i32 3
+  %v32 = call <4 x i32> @vops32(<4 x i32> %a, <4 x i32> %b)
+  %bad32 = call i32 @check32(<4 x i32> %a, <4 x i32> %b, <4 x i32> %v32)
+  %a16 = bitcast <4 x i32> %a to <8 x i16>
+  %b16 = bitcast <4 x i32> %b to <8 x i16>
+  %v16 = call <8 x i16> @vops16(<8 x i16> %a16, <8 x i16> %b16)
+  %bad16 = call i32 @check16(<8 x i16> %a16, <8 x i16> %b16, <8 x i16> %v16)
+  %a8 = bitcast <4 x i32> %a to <16 x i8>
+  %b8 = bitcast <4 x i32> %b to <16 x i8>
+  %v8 = call <16 x i8> @vops8(<16 x i8> %a8, <16 x i8> %b8)
+  %bad8 = call i32 @check8(<16 x i8> %a8, <16 x i8> %b8, <16 x i8> %v8)
+  %bad1 = add i32 %bad, %bad32
+  %bad2 = add i32 %bad1, %bad16
+  %bad3 = add i32 %bad2, %bad8
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, 1000
+  br i1 %done, label %exit, label %loop
+
+exit:                                             ; preds = %loop
+  %failed = icmp ne i32 %bad3, 0
+  %ret = zext i1 %failed to i32
+  ret i32 %ret
+}
+
+define i32 @xorshift(i32 %x) #0 {
+entry:
+  %x.1 = shl i32 %x, 13
+  %x.2 = xor i32 %x, %x.1
+  %x.3 = lshr i32 %x.2, 17
+  %x.4 = xor i32 %x.2, %x.3
+  %x.5 = shl i32 %x.4, 5
+  %x.6 = xor i32 %x.4, %x.5
+  ret i32 %x.6
+}
+
+attributes #0 = { nounwind uwtable "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" }
@@ -0,0 +1,231 @@
+// Runtime of the instrumentation mode of the passes (common/ObfInstrument.h).
+//
+// An instrumented module keeps the counters of each pass in a thread_local array. The first time a thread enters
+// an instrumented function, the array of the thread is attached to the table of the pass here. When a thread
+// exits, its counts are added to the totals of the tables (pthread key destructor). At exit, the counts of the
+// threads still running, the main thread among them, are added as well and all tables are written as JSON to
+// $OBF_INSTR_OUTPUT (obf_instr.json by default):
+//
+//   {"tables":[{"module":"fib.ll","pass":"flattenO","counters":[
+//     {"kind":"dispatch","function":"fib","block":"if.then","location":"fib.c:7","count":1234},...]},...]}
+//
+// Only attaching takes the lock, the increments are plain stores to memory of the incrementing thread. Counts of
+// threads still running at exit are read while they may change.
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/// Where a counted construct was inserted
+struct ObfInstrSite {
+    const char *Kind;
+    const char *Function;
+    const char *Block;
+    const char *Location;
+};
+
+/// Counters of one pass in one module, created by ObfInstrumenter::finish
+struct ObfInstrTable {
+    const char *Module;
+    const char *Pass;
+    uint64_t Size;
+    const struct ObfInstrSite *Sites;
+    uint64_t *Totals;           // Counts of the threads merged so far
+    struct ObfInstrTable *Next; // Tables attached so far
+};
+
+/// Counters of one table in one thread
+struct ObfInstrAttachment {
+    struct ObfInstrTable *Table;
+    uint64_t *Counters;
+    struct ObfInstrAttachment *Next;
+};
+
+/// Attachments of one running thread
+struct ObfInstrThread {
+    struct ObfInstrAttachment *Attachments;
+    struct ObfInstrThread *Prev;
+    struct ObfInstrThread *Next;
+};
+
+static pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t Once = PTHREAD_ONCE_INIT;
+static pthread_key_t Key;
+
+static struct ObfInstrTable *Tables;   // Guarded by 'Lock'
+static struct ObfInstrThread *Threads; // Guarded by 'Lock'
+static int Dumped;                     // Counts are no longer merged once written
+
+static __thread struct ObfInstrThread *Self;
+
+/// Add the counts of 'Thread' to the totals. Called with 'Lock' held
+static void merge(struct ObfInstrThread *Thread) {
+    struct ObfInstrAttachment *A;
+    uint64_t I;
+
+    for (A = Thread->Attachments; A; A = A->Next) {
+        for (I = 0; I < A->Table->Size; ++I) {
+            A->Table->Totals[I] += A->Counters[I];
+            A->Counters[I] = 0;
+        }
+    }
+}
+
+static void printString(FILE *Out, const char *S) {
+    fputc('"', Out);
+    for (; *S; ++S) {
+        unsigned char C = (unsigned char) *S;
+
+        if (C == '"' || C == '\\') {
+            fprintf(Out, "\\%c", C);
+        } else if (C < 0x20) {
+            fprintf(Out, "\\u%04x", C);
+        } else {
+            fputc(C, Out);
+        }
+    }
+    fputc('"', Out);
+}
+
+/// pthread key destructor, run when a thread that attached counters exits
+static void threadExit(void *Arg) {
+    struct ObfInstrThread *Thread = (struct ObfInstrThread *) Arg;
+    struct ObfInstrAttachment *A;
+
+    pthread_mutex_lock(&Lock);
+
+    if (!Dumped) {
+        merge(Thread);
+    }
+
+    if (Thread->Prev) {
+        Thread->Prev->Next = Thread->Next;
+    } else {
+        Threads = Thread->Next;
+    }
+    if (Thread->Next) {
+        Thread->Next->Prev = Thread->Prev;
+    }
+
+    pthread_mutex_unlock(&Lock);
+
+    while ((A = Thread->Attachments)) {
+        Thread->Attachments = A->Next;
+        free(A);
+    }
+    free(Thread);
+    Self = NULL;
+}
+
+/// atexit handler: merge the threads still running and write the tables
+static void dump(void) {
+    const char *Path = getenv("OBF_INSTR_OUTPUT");
+    struct ObfInstrThread *Thread;
+    struct ObfInstrTable *Table;
+    FILE *Out;
+    uint64_t I;
+
+    if (!Path || !*Path) {
+        Path = "obf_instr.json";
+    }
+
+    pthread_mutex_lock(&Lock);
+
+    for (Thread = Threads; Thread; Thread = Thread->Next) {
+        merge(Thread);
+    }
+    Dumped = 1;
+
+    Out = fopen(Path, "w");
+    if (!Out) {
+        perror(Path);
+        pthread_mutex_unlock(&Lock);
+        return;
+    }
+
+    fputs("{\"tables\":[", Out);
+
+    for (Table = Tables; Table; Table = Table->Next) {
+        fputs("{\"module\":", Out);
+        printString(Out, Table->Module);
+        fputs(",\"pass\":", Out);
+        printString(Out, Table->Pass);
+        fputs(",\"counters\":[", Out);
+
+        for (I = 0; I < Table->Size; ++I) {
+            const struct ObfInstrSite *Site = &Table->Sites[I];
+
+            fputs(I ? ",\n{\"kind\":" : "\n{\"kind\":", Out);
+            printString(Out, Site->Kind);
+            fputs(",\"function\":", Out);
+            printString(Out, Site->Function);
+            fputs(",\"block\":", Out);
+            printString(Out, Site->Block);
+            fputs(",\"location\":", Out);
+            printString(Out, Site->Location);
+            fprintf(Out, ",\"count\":%llu}", (unsigned long long) Table->Totals[I]);
+        }
+
+        fputs(Table->Next ? "]},\n" : "]}", Out);
+    }
+
+    fputs("]}\n", Out);
+    fclose(Out);
+
+    pthread_mutex_unlock(&Lock);
+}
+
+static void init(void) {
+    pthread_key_create(&Key, threadExit);
+    atexit(dump);
+}
+
+/// Attach 'Counters', the array of 'Table' of the calling thread. Called by instrumented functions once per
+/// thread and table
+void __obf_instr_attach(struct ObfInstrTable *Table, uint64_t *Counters) {
+    struct ObfInstrAttachment *A = (struct ObfInstrAttachment *) malloc(sizeof(*A));
+    struct ObfInstrTable *T;
+    int New = 0;
+
+    if (!A) {
+        return;
+    }
+
+    pthread_once(&Once, init);
+
+    if (!Self) {
+        Self = (struct ObfInstrThread *) calloc(1, sizeof(*Self));
+        if (!Self) {
+            free(A);
+            return;
+        }
+        pthread_setspecific(Key, Self);
+        New = 1;
+    }
+
+    A->Table = Table;
+    A->Counters = Counters;
+
+    pthread_mutex_lock(&Lock);
+
+    if (New) {
+        Self->Next = Threads;
+        if (Threads) {
+            Threads->Prev = Self;
+        }
+        Threads = Self;
+    }
+
+    A->Next = Self->Attachments;
+    Self->Attachments = A;
+
+    for (T = Tables; T && T != Table; T = T->Next) {
+    }
+    if (!T) {
+        Table->Next = Tables;
+        Tables = Table;
+    }
+
+    pthread_mutex_unlock(&Lock);
+}
@@ -10,26 +10,40 @@
 #include <llvm/IR/CFG.h>
 #include <algorithm>
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/RandomNumberGenerator.h>
+#include "ObfCompat.h"
+#include "ObfInstrument.h"
+#include "ObfOptions.h"
+#include "ObfPasses.h"
+#include "ObfTrace.h"
 
 #define DEBUG_TYPE "CheckerT"
 #define RED_ZONE 128
 
 using namespace llvm;
 
-static cl::list<unsigned int> Splits("splits", cl::Positional, cl::CommaSeparated,
-                            cl::desc("CRT watermark splits"));
+static cl::list<unsigned int> Splits(SplitsOption.Name, cl::CommaSeparated, cl::desc("CRT watermark splits"),
+                                     cl::value_desc("split,split,..."));
+
+static cl::opt<bool> Instrument("wm-instrument",
+                                cl::desc("Count the executions of the jumps over the watermark pieces (link with "
+                                         "libObfInstrRuntime.a)"),
+                                cl::init(false), cl::Optional);
 
 namespace {
     struct ChineseWM : public ModulePass {
         static char ID;
 
-        ChineseWM() : ModulePass(ID) {
-            srand(time(NULL));
-        }
+        std::unique_ptr<RandomNumberGenerator> RNG;
+
+        ChineseWM() : ModulePass(ID) {}
 
         void insertSplits(Module &M);
 
         virtual bool runOnModule(Module &M) {
+            ObfTraceScope Scope("splitWM", M);
+
+            RNG = createObfRNG(M, this);
 
             insertSplits(M);
 
@@ -51,25 +65,36 @@ void ChineseWM::insertSplits(Module &M) {
     ArgsTy2.push_back(Type::getInt32Ty(M.getContext()));
     FunctionType *IntFunTy = FunctionType::get(Type::getVoidTy(M.getContext()), ArgsTy2, false);
 
+    std::unique_ptr<ObfInstrumenter> Instr;
+    if (Instrument) {
+        Instr.reset(new ObfInstrumenter(M, "splitWM"));
+    }
+
     for (auto& Split : Splits) {
 
         int IdxF = 0;
         Module::iterator FI;
 
         do {
-            IdxF = rand() % M.getFunctionList().size();
+            IdxF = (*RNG)() % M.getFunctionList().size();
             FI = M.begin();
             std::advance(FI, IdxF);
         } while (FI->isDeclaration());
 
-        DEBUG(errs() << "Inserting piece " << std::to_string(Split) <<  " into " << FI->getName() << "\n");
+        LLVM_DEBUG(errs() << "Inserting piece " << std::to_string(Split) <<  " into " << FI->getName() << "\n");
+
+        ObfTraceScope FScope("splitWM", *FI);
 
-        int IdxBB = rand() % FI->getBasicBlockList().size();
+        int IdxBB = (*RNG)() % FI->getBasicBlockList().size();
         Function::iterator BI = FI->begin();
         std::advance(BI, IdxBB);
 
         Instruction *I = &*BI->getFirstInsertionPt();
 
+        if (Instr) {
+            Instr->count("piece", &*BI, I);
+        }
+
         IRBuilder<> Builder(I);
 
         Builder.CreateCall(InlineAsm::get(VoidFunTy, std::string("jmp .end_") + std::to_string(WM), "", true));
@@ -85,7 +110,32 @@ void ChineseWM::insertSplits(Module &M) {
 
         ++WM;
     }
+
+    if (Instr) {
+        Instr->finish();
+    }
 }
 
 
 static RegisterPass<ChineseWM> X("splitWM", "Inserts a CRT-split watermark into module", false, false);
+
+#if LLVM_VERSION_MAJOR >= 7
+PreservedAnalyses ChineseWMPass::run(Module &M, ModuleAnalysisManager &) {
+    ChineseWM Impl; // Same implementation as the legacy pass
+
+    if (!Impl.runOnModule(M)) {
+        return PreservedAnalyses::all();
+    }
+
+    // The counters of -wm-instrument are attached in a BasicBlock split off the 'entry' BasicBlock
+    if (Instrument) {
+        return PreservedAnalyses::none();
+    }
+
+    // Only inline asm calls are inserted, the CFG of every function is unchanged
+    PreservedAnalyses PA;
+    PA.preserve<FunctionAnalysisManagerModuleProxy>();
+    PA.preserveSet<CFGAnalyses>();
+    return PA;
+}
+#endif
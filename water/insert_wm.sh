@@ -14,6 +14,8 @@ case  $1 in
     *)
 esac
 
+obf=../cmake-build-debug/driver/llvm-obf # all passes are linked into the driver
+
 if [ "$1" == "" ]; then
     echo "Missing parameter: <program>" 
     usage
@@ -57,13 +59,11 @@ done
 echo
 
 base=$(basename "$program" ".ll")
-marked=${base}\_w.ll
-assembly=${base}\_w.s
+object=${base}\_w.o
 binary=${base}\_w
 
-opt -load ../cmake-build-debug/water/libSplitWMPass.so -splitWM -S ${program} -o ${marked} -debug -splits "${array[@]}"
-llc ${marked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=splitWM -o ${object} -debug -splits=$(IFS=,; echo "${array[*]}")
+clang ${object} -o ${binary}
 
 
 
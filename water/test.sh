@@ -7,7 +7,6 @@ usage()
 
 error()
 {
-    opt -view-cfg ${checked}
     exit -1
 }
 
@@ -20,6 +19,8 @@ case  $1 in
     *)
 esac
 
+obf=../cmake-build-debug/driver/llvm-obf # all passes are linked into the driver
+
 # sum100
 
 program="../programs/ll/sum100.ll" # program
@@ -44,13 +45,11 @@ done
 echo
 
 base=$(basename "$program" ".ll")
-marked=${base}\_w.ll
-assembly=${base}\_w.s
+object=${base}\_w.o
 binary=${base}\_w
 
-opt -load ../cmake-build-debug/water/libSplitWMPass.so -splitWM -S ${program} -o ${marked} -debug -splits "${array[@]}"
-llc ${marked} -o ${assembly}
-clang ${assembly} -o ${binary}
+${obf} ${program} -passes=splitWM -o ${object} -debug -splits=$(IFS=,; echo "${array[*]}")
+clang ${object} -o ${binary}
 
 watermark=$(objdump -dF ${binary} | python3 ./extract_wm.py ${binary} ${label} ${key} ${primes[@]})
 